@@ -28,10 +28,11 @@ ufbgc_return_t example_test1(ufbgc_test_parameters * parameters, void * uarg){
     ufbgc_assert_eqstr(str1,str2);
 
     int n1[] = {[0] = 1, [1] = 2, [2] = 3};
-    long n2[] = {10, 2 ,3};
+    int n2[] = {10, 2 ,3};
 
-    //Arrays are not the same, ufbgc assert this line!
-    ufbgc_assert_eqmem(n1,n2,3);
+    //Arrays are not the same, ufbgc assert this line and prints where they differ!
+    ufbgc_assert_eqmem(n1,n2,sizeof(n1));   //Size is in bytes
+    ufbgc_assert_eqarray(n1,n2,3);          //Count is in elements
 
     return UFBGC_OK;
 }
@@ -112,6 +113,7 @@ ufbgc_return_t test3(ufbgc_test_parameters * parameters, void * uarg){
 const char * val1[] = {"a1","a2","a3"};
 int  vali[] = {100,200,300,500};
 double  valdb[] = {1.1,1.2,1.3};
+ufbgc_blob valblob[] = {{"\x01\x02",2},{"\x03",1},{"",0}};
 ufbgc_test_parameters paramtest_param = {
     .no_iteration = 3,
     .parameters = {
@@ -127,6 +129,16 @@ ufbgc_test_parameters paramtest_param = {
             .key = "double-inputs",
             .value = valdb
         },
+        {
+            .key = "typed-inputs",
+            .value = valdb,
+            .type = UFBGC_PARAM_DOUBLE      //Optional, typed getters check it
+        },
+        {
+            .key = "blob-inputs",
+            .value = valblob,
+            .type = UFBGC_PARAM_BLOB
+        },
         {
             .key = NULL, //Last parameter or its key must be NULL
             .value = NULL,
@@ -171,6 +183,16 @@ ufbgc_return_t parameter_test(ufbgc_test_parameters * parameters, void * uarg){
     ufbgc_get_current_test_iterator(&it);
     printf("Double with iterator: %g\n",dx[it]);
 
+    /*
+        Typed getters check the type of the parameter and the iteration against no_iteration
+        They fail the test if the key is missing, asking "typed-inputs" as int would fail too
+    */
+    double typed;
+    ufbgc_get_param_double(typed,"typed-inputs");
+    ufbgc_blob blob;
+    ufbgc_get_param_blob(blob,"blob-inputs");
+    printf("Got typed double:%g and blob of %lu bytes\n",typed,blob.size);
+
     return UFBGC_OK;
 }
 
@@ -222,6 +244,193 @@ ufbgc_return_t operator_test(ufbgc_test_parameters * parameters, void * uarg){
 }
 
 
+/*
+    UFBGC_BENCH macro creates a benchmark, body is a single operation and it is repeated by ufbgc
+    UFBGC_BENCH(strlen_bench,       //Benchmark function name
+                UFBGC_LOG_WARNING,  //Log level of the benchmark
+                NULL,               //Output file
+                NULL,               //ufbgc_test_parameters
+                {...},              //Setup function
+                {...},              //Benchmark body, one operation
+                {...},              //Teardown function
+                UFBGC_BUDGET(...))  //Optional, budget of the benchmark
+    ufbgc_do_not_optimize keeps the compiler from removing the result of the operation
+    ufbgc_set_bytes_processed gives the work of one operation, throughput is printed next to the time
+*/
+UFBGC_BENCH(strlen_bench,UFBGC_LOG_WARNING,NULL,NULL,
+{
+    char * str = malloc(1024);
+    memset(str,'a',1023);
+    str[1023] = '\0';
+    *uarg = str;
+},
+{
+    size_t len = strlen((const char *)uarg);
+    ufbgc_do_not_optimize(len);
+    ufbgc_set_bytes_processed(len + 1);
+},
+{
+    free(uarg);
+},
+UFBGC_BUDGET(.wall_ms = 0.001))            //Median of an operation over 1us is [OVER BUDGET] and fails the run
+
+/*
+    Passing assertions are a single predicted branch, this benchmark measures the cost of four of them
+    Compile with -DUFBGC_MAX_VERBOSITY=UFBGC_LOG_WARNING to remove pass reporting of UFBGC_LOG_INFO completely
+*/
+UFBGC_BENCH(assert_bench,UFBGC_LOG_WARNING,NULL,NULL,
+{},
+{
+    size_t value = ufbgc_bench_i;
+    ufbgc_do_not_optimize(value);
+    ufbgc_assert(value == ufbgc_bench_i);
+    ufbgc_assert_false(value > ufbgc_bench_i);
+    ufbgc_assert_op(value,<=,ufbgc_bench_i);
+    ufbgc_likely(value + 1 > ufbgc_bench_i);
+},
+{})
+
+/*
+    Frames with TRACK_ALLOCS option count the allocations of setup, test and teardown functions
+    Assertions check the allocations of the test function
+*/
+ufbgc_return_t alloc_test(ufbgc_test_parameters * parameters, void * uarg){
+
+    const char * str = (const char *) uarg;
+    ufbgc_assert_eq(strlen(str),1023);
+    if(!ufbgc_alloc_tracking()){                 //Library is built without -DUFBGC_ALLOC_TRACKER=ON
+        return UFBGC_OK;
+    }
+    ufbgc_assert_max_allocs(0);                  //Measured code must not allocate
+
+    char * copy = strdup(str);
+    ufbgc_assert_max_allocs(1);
+    free(copy);
+    ufbgc_assert_no_leak();
+
+    return UFBGC_OK;
+}
+
+ufbgc_return_t alloc_test_setup(ufbgc_test_parameters * parameters, void ** uarg){
+    char * str = malloc(1024);
+    memset(str,'a',1023);
+    str[1023] = '\0';
+    *uarg = str;
+    return UFBGC_OK;
+}
+
+ufbgc_return_t alloc_test_teardown(ufbgc_test_parameters * parameters, void * uarg){
+    free(uarg);
+    return UFBGC_OK;
+}
+
+/*
+    Fixtures are built once when a frame asks for them and shared by every iteration and frame which lists them
+    It is torn down after the last frame listing it, instead of setup_f and teardown_f of every iteration
+*/
+UFBGC_FIXTURE(copy_pattern,
+{
+    unsigned char * pattern = malloc(64);
+    for(int i = 0; i < 64; ++i) pattern[i] = (unsigned char) i;
+    *data = pattern;
+},
+{
+    free(data);
+})
+
+/*
+    Generators produce the parameters of each iteration when it starts, no table of every combination is built
+    Below generator runs 4 sizes x 3 alignments, zipped with the element type names, 12 iterations
+*/
+const char * copy_types[] = {"char","int","double"};
+ufbgc_return_t copy_test(ufbgc_test_parameters * parameters, void * uarg){
+
+    int size, alignment;
+    const char * type;
+    ufbgc_get_param_int(size,"size");
+    ufbgc_get_param_int(alignment,"alignment");
+    ufbgc_get_param_string(type,"type");
+
+    const unsigned char * pattern;
+    ufbgc_use_fixture(pattern,copy_pattern,const unsigned char *);     //Read-only, also from parallel workers
+
+    unsigned char buffer[64 + 16];
+    unsigned char * dst = buffer + alignment;
+    memcpy(dst,pattern,size);
+    ufbgc_assert_(dst[size - 1] == size - 1,"%d bytes of %s",size,type);
+    ufbgc_set_bytes_processed(size);            //Rate of the frame in the summary is the work of every iteration over their time
+
+    return UFBGC_OK;
+}
+
+/*
+    Property is checked with 1000 generated strings, a failing string would be shrunk to a minimal one and printed
+    Random numbers of a test are seeded from the seed of the run, --seed=N repeats them
+*/
+ufbgc_return_t reverse_twice_property(ufbgc_property * prop, void * uarg){
+
+    const char * str = ufbgc_prop_string(prop,32,NULL);
+    size_t len = strlen(str);
+
+    char reversed[33], twice[33];
+    for(size_t i = 0; i < len; ++i) reversed[i] = str[len - 1 - i];
+    for(size_t i = 0; i < len; ++i) twice[i] = reversed[len - 1 - i];
+
+    ufbgc_assert_eqmem(twice,str,len);
+
+    return UFBGC_OK;
+}
+
+UFBGC_TEST(property_test,NO_OPTION,UFBGC_LOG_WARNING,NULL,NULL,{},
+{
+    ufbgc_assert_property(reverse_twice_property,NULL,1000);
+    ufbgc_assert_op(ufbgc_randint(1,6),<=,6);
+},{})
+
+
+/*
+    Latency of every operation is recorded into a histogram, the runner prints its percentiles after the [OK] line
+    Threads record into histograms of their own and merge them with ufbgc_histogram_merge
+*/
+ufbgc_return_t latency_test(ufbgc_test_parameters * parameters, void * uarg){
+
+    static ufbgc_histogram latency;             //Fixed size, zero memory is an empty histogram
+    ufbgc_histogram_reset(&latency);
+
+    char buffer[256];
+    for(int i = 0; i < 10000; ++i){
+        uint64_t start = ufbgc_get_wall_time_ns();
+        snprintf(buffer,sizeof(buffer),"%d %g",i,i * 0.5);
+        ufbgc_do_not_optimize(buffer);
+        ufbgc_histogram_record(&latency,ufbgc_get_wall_time_ns() - start);
+    }
+
+    ufbgc_report_histogram("snprintf",&latency);
+    ufbgc_assert_percentile(&latency,50,<,1ms);         //Limit is a duration literal, ns us ms or s
+    ufbgc_assert_percentile_ns(&latency,100,>=,0);      //Limit is an expression in nanoseconds
+
+    return UFBGC_OK;
+}
+
+/*
+    UFBGC_STRESS runs the body on 4 threads for 1000 rounds, a spinning barrier starts each round on every thread together
+    ufbgc_stress_thread and ufbgc_stress_round tell which thread and round the body runs
+*/
+long stress_counter;
+UFBGC_STRESS(counter_stress,4,1000,UFBGC_LOG_WARNING,NULL,NULL,
+{
+    stress_counter = 0;
+},
+{
+    for(int i = 0; i < 100; ++i){
+        __atomic_add_fetch(&stress_counter,1,__ATOMIC_RELAXED);
+    }
+    ufbgc_assert(ufbgc_stress_thread() < ufbgc_stress_threads());      //Failure prints [thread N, round M]
+},
+{
+    //Teardown runs after every thread finished its rounds
+})
+
 ufbgc_test_frame test_list[] = {
     {
         .test_f = example_test1,            //Test function
@@ -256,12 +465,44 @@ ufbgc_test_frame test_list[] = {
         .parameters = &operator_test_param,
         .option = NO_OPTION,
         .log_level = UFBGC_LOG_INFO,        //Verbosity level set to UFBGC_LOG_INFO, so every information about test will be printed(even if assertion not fails) 
-    }
+    },
+            strlen_bench_frame,             //Benchmark frame created by UFBGC_BENCH macro
+            assert_bench_frame,             //Assertion throughput
+    {
+        .test_f = alloc_test,
+        .name = "alloc-test",
+        .setup_f = alloc_test_setup,
+        .teardown_f = alloc_test_teardown,
+        .option = TRACK_ALLOCS,             //Allocations and leaks are reported below the result of the test
+        .tags = "memory",                   //Selected with --tag=memory, skipped with --tag=-memory
+        .budget = {                         //Checked after the assertions passed, 0 fields are not checked
+            .allocs = 1,                    //Test function allocates its copy only, [OVER BUDGET] without -DUFBGC_ALLOC_TRACKER=ON
+            .deadline_ms = 1000,            //Watchdog stops an iteration which runs longer
+        },
+    },
+    {
+        .test_f = copy_test,
+        .name = "copy-test",
+        .generator = UFBGC_CARTESIAN(       //Iterates until the generator is exhausted, no_iteration is not needed
+            UFBGC_INT_RANGE("size",8,64 + 1,16),
+            UFBGC_ZIP(UFBGC_INT_RANGE("alignment",0,16,4), UFBGC_VALUES("type",UFBGC_PARAM_STRING,copy_types))),
+        .fixtures = UFBGC_FIXTURES(&copy_pattern),
+        .version = "1",                     //Changing it invalidates the --cache result of the frame
+    },
+            property_test_frame,            //Property based test
+    {
+        .test_f = latency_test,
+        .name = "latency-test",
+    },
+            counter_stress_frame,           //Stress frame created by UFBGC_STRESS macro
 };
 
 int main(int argc, char const *argv[]){
-    
-    ufbgc_start_test(test_list, ufbgc_test_frame_array_length(test_list));
 
-    return 0;
+    //Command line options of the runner e.g. --jobs=4, --isolate, --shard=0/2, --list, --filter='copy*'
+    if(ufbgc_parse_args(argc, argv) != UFBGC_OK){
+        return 1;
+    }
+
+    return ufbgc_start_test(test_list, ufbgc_test_frame_array_length(test_list)) == UFBGC_OK ? 0 : 1;
 }
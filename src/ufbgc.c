@@ -1,209 +1,7923 @@
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
 #include "ufbgc.h"
+#include <math.h>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <fcntl.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+    #include <x86intrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define UFBGC_POSIX
+    #include <pthread.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <poll.h>
+    #include <sys/types.h>
+    #include <sys/wait.h>
+    #include <signal.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/utsname.h>
+    #include <sys/resource.h>
+#endif
+
+#ifdef __GLIBC__
+    #define UFBGC_COOKIE_STREAM
+    #include <stdio_ext.h>
+#endif
+
+//Allocation tracker is opt-in, it replaces the malloc family of every program linking ufbgc
+#if defined(UFBGC_ALLOC_TRACKER) && !defined(__GLIBC__)
+    #undef UFBGC_ALLOC_TRACKER
+#endif
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+    #define UFBGC_PROFILER
+    #include <ucontext.h>
+    #include <dlfcn.h>
+    #include <elf.h>
+    #include <fcntl.h>
+    #include <time.h>
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    #define UFBGC_THREAD_LOCAL _Thread_local
+#else
+    #define UFBGC_THREAD_LOCAL __thread
+#endif
+
+//Growing byte buffer which is never counted by the allocation tracker
+typedef struct{
+    char * data;
+    size_t size;
+    size_t capacity;
+}internal_ufbgc_event_buffer;
+
+//Hashed keys of the running frame's parameters, built once before its iterations
+typedef struct{
+    const char * key;
+    uint64_t hash;
+    const ufbgc_args * arg;
+    bool generated;                 //Value of the current iteration, not an array
+}internal_ufbgc_param_slot;
+
+typedef struct{
+    internal_ufbgc_param_slot * slots;
+    size_t size;                    //Power of two, 0 if there is no index
+}internal_ufbgc_param_index;
+
+//State of a generator node, nodes of a frame are stored in preorder
+typedef struct{
+    const ufbgc_generator * generator;
+    size_t end;                     //Index of the node after the subtree
+    size_t index;                   //Position of the current value
+    union{
+        int i;
+        double d;
+        const char * s;
+        ufbgc_blob b;
+    }value;
+    ufbgc_args arg;                 //Key, current value and type of a leaf
+    FILE * file;
+    char * line;
+    size_t line_capacity;
+    bool failed;                    //File cannot be read or a line cannot be parsed
+}internal_ufbgc_gen_node;
+
+#define UFBGC_MAX_REPORTED_HISTOGRAMS 8
+
+//Percentiles of a histogram reported by ufbgc_report_histogram, in nanoseconds
+typedef struct{
+    char name[48];
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+}internal_ufbgc_histogram_report;
 
 typedef struct{
     const ufbgc_test_frame * frame;
     size_t frame_iterator;
     bool frame_iterateable;
-    clock_t test_start;
+    bool colored_output;
+    ufbgc_timer test_timer;
     FILE * output_file;
+    size_t bench_iterations;        //Operations of the current benchmark sample
+    internal_ufbgc_event_buffer * events;   //Reporter events of the frame, NULL if there is no reporter
+    internal_ufbgc_param_index params;
+    internal_ufbgc_gen_node * gen_nodes;    //Generator state of the frame, NULL without a generator
+    size_t no_gen_nodes;
+    bool quiet;                     //Assertions are not printed or reported, e.g. while a property is shrunk
+    bool used_golden;               //Golden files are compared, they are not a part of the cache key
+    internal_ufbgc_histogram_report histograms[UFBGC_MAX_REPORTED_HISTOGRAMS];     //Reported in the current iteration
+    size_t no_histograms;
+    size_t stress_threads;          //Threads of the running STRESS_TEST, 0 outside of a stress thread
+    size_t stress_thread;
+    size_t stress_round;
+    uint64_t bytes_processed;       //Work of the current iteration, per operation in a benchmark
+    uint64_t items_processed;
 }internal_ufbgc_test_frame;
 
-static internal_ufbgc_test_frame current_test_frame = {
+//Per operation statistics of a benchmark, times are in nanoseconds
+typedef struct{
+    size_t operations;              //Operations per sample
+    size_t samples;
+    double min;
+    double median;
+    double mean;
+    double stddev;
+    double p90;
+    double p99;
+    double cpu_mean;                //CPU time of an operation over all samples
+}internal_ufbgc_bench_stats;
+
+typedef enum{
+    UFBGC_ALLOC_PHASE_NONE = 0,
+    UFBGC_ALLOC_PHASE_SETUP,
+    UFBGC_ALLOC_PHASE_TEST,
+    UFBGC_ALLOC_PHASE_TEARDOWN,
+}internal_ufbgc_alloc_phase;
+
+typedef enum{
+    UFBGC_PERF_CYCLES = 0,
+    UFBGC_PERF_INSTRUCTIONS,
+    UFBGC_PERF_BRANCH_MISSES,
+    UFBGC_PERF_L1D_MISSES,
+    UFBGC_PERF_LLC_MISSES,
+    UFBGC_PERF_CONTEXT_SWITCHES,
+    UFBGC_PERF_LEN
+}internal_ufbgc_perf_counter;
+
+typedef struct{
+    uint64_t values[UFBGC_PERF_LEN];
+    uint32_t available;             //Bit of a counter is set if it could be read
+}internal_ufbgc_perf_values;
+
+//Work set by the test and the time of the iterations which set it, rates are work over time
+typedef struct{
+    double bytes;
+    double bytes_ns;
+    double items;
+    double items_ns;
+}internal_ufbgc_throughput;
+
+typedef struct{
+    const ufbgc_test_frame * tframe;
+    ufbgc_return_t test_result;
+    double execution_time;          //Wall time in ms
+    double cpu_time;                //CPU time of the runner thread in ms
+    uint64_t cycles;
+    bool crashed;                   //Worker process died while running the frame
+    int crash_signal;
+    int exit_status;
+    bool benchmarked;
+    internal_ufbgc_bench_stats bench;   //Statistics of the last iteration of a benchmark
+    int regression;                 //1 if an iteration regressed against the baseline, -1 if improved
+    internal_ufbgc_perf_values perf;    //Hardware counters summed over the iterations
+    bool allocs_tracked;
+    ufbgc_alloc_stats allocs;       //Allocations summed over the iterations, peak is the maximum
+    bool cacheable;                 //Result can be stored in the cache under cache_key
+    bool cached;                    //Passed with the same key before, the frame is not run
+    uint64_t cache_key;
+    bool used_random;               //An iteration drew random numbers, the result depends on the seed
+    bool used_golden;               //An iteration compared golden files, the result depends on their content
+    internal_ufbgc_throughput throughput;   //Summed over the passed iterations
+    bool over_budget;               //An iteration passed but exceeded the budget of the frame
+    bool timed_out;                 //Worker process was stopped by the watchdog at the deadline of the frame
+}internal_ufbgc_test_result;
+
+//Frames selected to run, results are kept in the same order as indices
+typedef struct{
+    const ufbgc_test_frame * test_list;
+    size_t * indices;
+    size_t len;
+    internal_ufbgc_test_result * results;
+}internal_ufbgc_test_run;
+
+typedef enum{
+    UFBGC_ORDER_DECLARED,           //Frames run in the order of the test list
+    UFBGC_ORDER_FAILED_FIRST,       //Recently failed frames first, then new frames, then the rest
+    UFBGC_ORDER_LONGEST_FIRST,      //Slowest frames first, workers finish at about the same time
+    UFBGC_ORDER_RANDOM,             //Shuffled with the seed of the run
+}internal_ufbgc_order;
+
+#define UFBGC_MAX_PINNED_CPUS 64
+
+//Options are set by ufbgc_parse_args
+typedef struct{
+    size_t threads;                 //Worker threads of ufbgc_start_test, 0 or 1 runs sequentially
+    size_t processes;               //Forked worker processes of ufbgc_start_test, 0 disables isolation
+    size_t shard_index;
+    size_t shard_count;
+    size_t bench_warmup_ms;         //Warm-up time of a benchmark
+    size_t bench_time_ms;           //Target measurement time of a benchmark
+    size_t bench_samples;           //Minimum number of samples of a benchmark
+    const char * baseline_path;     //Timings are compared with this baseline file
+    bool update_baseline;           //Samples of the run are merged into the baseline file
+    double regression_threshold;    //Minimum change of the median in percent
+    double regression_alpha;        //Significance level of the Mann-Whitney test
+    double regression_min_delta_ns; //Smaller changes of single sample tests are ignored
+    bool perf_counters;             //Performance counters are read for every frame
+    bool track_allocs;              //Allocations of every frame are tracked
+    uint64_t seed;                  //Seed of the random numbers of the run
+    bool seed_given;                //Seed is taken from --seed, otherwise every run has a new one
+    size_t property_runs;           //Generated inputs of a property which does not give its runs
+    const char * history_path;      //Outcome and duration of every frame are recorded in this file
+    internal_ufbgc_order order;     //Run order of the frames, other than declared needs the history
+    bool fail_fast;                 //Frames are not started after the first failure
+    bool list;                      //Selected frames are listed, nothing is run
+    const char * name_filter;       //Comma separated globs of frame names, '-' excludes
+    const char * tag_filter;        //Comma separated globs of tags, '-' excludes
+    const char * cache_path;        //Passed frames are recorded in this file and not run again with the same key
+    const char * cache_fingerprint; //Replaces the hash of the executable in the cache key
+    int pin_cpus[UFBGC_MAX_PINNED_CPUS];    //Worker N runs on the Nth CPU of the list modulo its length (Linux)
+    size_t no_pin_cpus;             //0 leaves the affinity of the runner alone
+    int fifo_priority;              //Runner threads use SCHED_FIFO with this priority, 0 keeps the policy
+    int nice;                       //Nice value of the runner threads, valid if nice_given
+    bool nice_given;
+    bool profile;                   //Every frame is profiled, not only the ones with PROFILE_STACKS
+    const char * profile_dir;       //Folded stacks of the profiled iterations are written here
+    size_t profile_hz;              //Samples per second of CPU time
+    size_t timeout_ms;              //Deadline of the iterations of frames without their own, 0 disables the watchdog
+}internal_ufbgc_runner_options;
+
+static internal_ufbgc_runner_options runner_options = {
+    .threads = 1,
+    .processes = 0,
+    .shard_index = 0,
+    .shard_count = 1,
+    .bench_warmup_ms = 100,
+    .bench_time_ms = 500,
+    .bench_samples = 30,
+    .baseline_path = NULL,
+    .update_baseline = false,
+    .regression_threshold = 10,
+    .regression_alpha = 0.05,
+    .regression_min_delta_ns = 100000,
+    .perf_counters = false,
+    .track_allocs = false,
+    .seed = 0,
+    .seed_given = false,
+    .property_runs = 100,
+    .history_path = NULL,
+    .order = UFBGC_ORDER_DECLARED,
+    .fail_fast = false,
+    .list = false,
+    .name_filter = NULL,
+    .tag_filter = NULL,
+    .cache_path = NULL,
+    .cache_fingerprint = NULL,
+    .no_pin_cpus = 0,
+    .fifo_priority = 0,
+    .nice = 0,
+    .nice_given = false,
+    .profile = false,
+    .profile_dir = "ufbgc_profiles",
+    .profile_hz = 997,
+    .timeout_ms = 0,
+};
+
+//Every runner thread has its own frame context, so getters always see the test running on the calling thread
+static UFBGC_THREAD_LOCAL internal_ufbgc_test_frame current_test_frame = {
     .frame = NULL,
     .frame_iterator = 0,
     .frame_iterateable = false,
+    .colored_output = false,
     .output_file = NULL,
+    .bench_iterations = 1,
+    .events = NULL,
 };
 
-ufbgc_return_t ufbgc_start_test(const ufbgc_test_frame * test_list, size_t list_len){
 
-    ufbgc_print_magenta(stdout,"ufbgc - starting tests\n\n");
+#ifdef UFBGC_POSIX
+static void ufbgc_isolated_iteration_start(size_t iteration);
+static void ufbgc_watchdog_arm(const ufbgc_test_frame * tframe, size_t iteration, double deadline_ms, bool colored);
+static void ufbgc_watchdog_disarm();
+#endif
 
-    __ufbgc_internal_assert_(test_list != NULL,"Test frame pointer is NULL");
-    __ufbgc_internal_assert_(list_len > 0,"Test list length must be bigger than zero");
+//Same as ufbgc_print_* macros but the color is chosen at run time
+static void ufbgc_print_colored(FILE * fl, const char * color, const char * format, ...){
+    va_list args;
+    va_start(args,format);
+    bool colored = UFBGC_COLORED(fl);
+    if(colored) fputs(color,fl);
+    vfprintf(fl,format,args);
+    if(colored) fputs(ANSI_COLOR_RESET,fl);
+    va_end(args);
+}
 
-    const ufbgc_test_frame * tframe = test_list;
+//Prints a duration given in nanoseconds with a readable unit
+static const char * ufbgc_format_ns(double ns, char * buffer, size_t size){
+    if(ns < 1e3)        snprintf(buffer,size,"%.3gns",ns);
+    else if(ns < 1e6)   snprintf(buffer,size,"%.3gus",ns / 1e3);
+    else if(ns < 1e9)   snprintf(buffer,size,"%.3gms",ns / 1e6);
+    else                snprintf(buffer,size,"%.3gs",ns / 1e9);
+    return buffer;
+}
 
-    #ifdef UFBGC_PRINT_SUMMARY
-        typedef struct{
-            const ufbgc_test_frame * tframe;
-            ufbgc_return_t test_result;
-            double execution_time;
-        }test_summary;
-        test_summary * summary_list = (test_summary*) malloc(sizeof(test_summary) * list_len);
-    #endif
-    
-    for(size_t iter = 0; iter < list_len && tframe != NULL && tframe->test_f != NULL; ++iter){
+static int ufbgc_compare_double(const void * a, const void * b){
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+//Linear interpolation between the closest ranks of a sorted array
+static double ufbgc_percentile(const double * sorted, size_t len, double percentile){
+    if(len == 0){
+        return 0;
+    }
+    double rank = percentile / 100.0 * (double)(len - 1);
+    size_t lower = (size_t) rank;
+    if(lower + 1 >= len){
+        return sorted[len - 1];
+    }
+    return sorted[lower] + (rank - (double) lower) * (sorted[lower + 1] - sorted[lower]);
+}
+
+static void ufbgc_alloc_set_phase(internal_ufbgc_alloc_phase phase);
+static void ufbgc_profile_enter(uintptr_t boundary);
+static void ufbgc_profile_leave();
+
+static ufbgc_return_t ufbgc_bench_sample(const ufbgc_test_frame * tframe, void * user_arg, size_t operations, uint64_t * elapsed, uint64_t * cpu_elapsed){
+    current_test_frame.bench_iterations = operations;
+    ufbgc_alloc_set_phase(UFBGC_ALLOC_PHASE_TEST);
+    ufbgc_profile_enter((uintptr_t) __builtin_frame_address(0));
+    uint64_t cpu_start = ufbgc_get_thread_cpu_time_ns();
+    uint64_t start = ufbgc_get_wall_time_ns();
+    ufbgc_return_t test_result = tframe->test_f(tframe->parameters,user_arg);
+    *elapsed = ufbgc_get_wall_time_ns() - start;
+    *cpu_elapsed = ufbgc_get_thread_cpu_time_ns() - cpu_start;
+    ufbgc_profile_leave();
+    ufbgc_alloc_set_phase(UFBGC_ALLOC_PHASE_NONE);
+    current_test_frame.bench_iterations = 1;
+    return test_result;
+}
 
-        #ifdef UFBGC_PRINT_SUMMARY
-            summary_list[iter].tframe = tframe;
-            summary_list[iter].test_result = UFBGC_FAIL;
-        #endif        
-        
+/*
+    Benchmark is warmed up while the operations per sample are scaled until a sample takes bench_time / bench_samples
+    then samples are collected until both the sample count and the measurement time are reached
+*/
+static ufbgc_return_t ufbgc_run_benchmark(const ufbgc_test_frame * tframe, void * user_arg, internal_ufbgc_bench_stats * stats, double ** measured_samples, size_t * measured_len){
+    const uint64_t warmup_ns = (uint64_t) runner_options.bench_warmup_ms * 1000000ull;
+    const uint64_t measure_ns = (uint64_t) runner_options.bench_time_ms * 1000000ull;
+    const size_t min_samples = runner_options.bench_samples ? runner_options.bench_samples : 1;
+    const size_t max_samples = min_samples * 10;
+    const size_t max_operations = (size_t) 1 << 40;
+    uint64_t sample_ns = measure_ns / min_samples;
+    if(sample_ns < 1000) sample_ns = 1000;
 
-        current_test_frame.frame = tframe;
+    memset(stats,0,sizeof(*stats));
 
-        struct tm current_time;
-        ufbgc_get_current_time(&current_time);
+    size_t operations = 1;
+    uint64_t elapsed = 0;
+    uint64_t cpu_elapsed = 0;
+    uint64_t warmup_start = ufbgc_get_wall_time_ns();
+    for(;;){
+        if(ufbgc_bench_sample(tframe,user_arg,operations,&elapsed,&cpu_elapsed) != UFBGC_OK){
+            return UFBGC_FAIL;
+        }
+        if(elapsed < sample_ns && operations < max_operations){
+            double scale = elapsed > 0 ? 1.2 * (double) sample_ns / (double) elapsed : 10;
+            scale = scale < 2 ? 2 : (scale > 10 ? 10 : scale);
+            operations = (size_t)((double) operations * scale);
+            continue;
+        }
+        if(ufbgc_get_wall_time_ns() - warmup_start >= warmup_ns){
+            break;
+        }
+    }
 
-        current_test_frame.output_file = stdout;
+    double * samples = (double *) malloc(sizeof(double) * max_samples);
+    if(samples == NULL){
+        return UFBGC_FAIL;
+    }
 
-        if(tframe->output_file != NULL){
-            current_test_frame.output_file = fopen(tframe->output_file,"a+");
-            __ufbgc_internal_assert_(current_test_frame.output_file != NULL,"Can't open file:%s",tframe->output_file);
+    size_t no_samples = 0;
+    uint64_t cpu_total = 0;
+    uint64_t measure_start = ufbgc_get_wall_time_ns();
+    while(no_samples < min_samples || (no_samples < max_samples && ufbgc_get_wall_time_ns() - measure_start < measure_ns)){
+        if(ufbgc_bench_sample(tframe,user_arg,operations,&elapsed,&cpu_elapsed) != UFBGC_OK){
+            free(samples);
+            return UFBGC_FAIL;
         }
-        
+        samples[no_samples++] = (double) elapsed / (double) operations;
+        cpu_total += cpu_elapsed;
+    }
+
+    //Statistics are taken from a sorted copy, the samples are returned in measurement order for the baseline
+    double * sorted = (double *) malloc(sizeof(double) * no_samples);
+    if(sorted == NULL){
+        free(samples);
+        return UFBGC_FAIL;
+    }
+    memcpy(sorted,samples,sizeof(double) * no_samples);
+    qsort(sorted,no_samples,sizeof(double),ufbgc_compare_double);
+
+    double sum = 0;
+    for(size_t i = 0; i < no_samples; ++i){
+        sum += sorted[i];
+    }
+    double mean = sum / (double) no_samples;
+    double variance = 0;
+    for(size_t i = 0; i < no_samples; ++i){
+        variance += (sorted[i] - mean) * (sorted[i] - mean);
+    }
+
+    stats->operations = operations;
+    stats->samples = no_samples;
+    stats->min = sorted[0];
+    stats->median = ufbgc_percentile(sorted,no_samples,50);
+    stats->mean = mean;
+    stats->stddev = no_samples > 1 ? sqrt(variance / (double)(no_samples - 1)) : 0;
+    stats->p90 = ufbgc_percentile(sorted,no_samples,90);
+    stats->p99 = ufbgc_percentile(sorted,no_samples,99);
+    stats->cpu_mean = (double) cpu_total / ((double) operations * (double) no_samples);
+    free(sorted);
+
+    *measured_samples = samples;
+    *measured_len = no_samples;
+    return UFBGC_OK;
+}
+
+/*
+    Baseline keeps the timing samples of every test iteration, keyed by frame name and iteration
+    File format is "UFBGCBL1", uint32 entry count, and for every entry:
+    uint16 name length, name, uint32 iteration, uint32 sample count, double samples[] (nanoseconds)
+*/
+#define UFBGC_BASELINE_MAGIC "UFBGCBL1"
+#define UFBGC_BASELINE_MAX_SAMPLES 64
+
+typedef struct{
+    char * name;
+    uint32_t iteration;
+    uint32_t no_samples;
+    double * samples;
+}internal_ufbgc_baseline_entry;
 
-        ufbgc_print_cyan(current_test_frame.output_file,"Starting test : '%s' @ %s",tframe->name ? tframe->name : "NULL" ,asctime(&current_time));
+typedef struct{
+    internal_ufbgc_baseline_entry * entries;
+    size_t len;
+    size_t capacity;
+    size_t * table;                 //Open addressing, entry index + 1, zero is empty
+    size_t table_size;
+}internal_ufbgc_baseline;
+
+static internal_ufbgc_baseline baseline_loaded;     //Baseline of the previous runs, read-only while tests run
+static internal_ufbgc_baseline baseline_current;    //Samples of this run
+#ifdef UFBGC_POSIX
+static pthread_mutex_t baseline_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static uint64_t ufbgc_hash_bytes(uint64_t hash, const void * data, size_t size){
+    const unsigned char * p = (const unsigned char *) data;
+    for(size_t i = 0; i < size; ++i){
+        hash ^= p[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
 
+static uint64_t ufbgc_baseline_hash(const char * name, uint32_t iteration){
+    uint64_t hash = ufbgc_hash_bytes(0xcbf29ce484222325ull,name,strlen(name));
+    return ufbgc_hash_bytes(hash,&iteration,sizeof(iteration));
+}
 
-        if(tframe->option == PASS_TEST){
-            ufbgc_print_yellow(current_test_frame.output_file,"'%s'\t\t\t%-10s\n",tframe->name,"[PASS]");
+static internal_ufbgc_baseline_entry * ufbgc_baseline_find(const internal_ufbgc_baseline * bl, const char * name, uint32_t iteration){
+    if(bl->table_size == 0){
+        return NULL;
+    }
+    size_t slot = (size_t) ufbgc_baseline_hash(name,iteration) & (bl->table_size - 1);
+    while(bl->table[slot] != 0){
+        internal_ufbgc_baseline_entry * entry = &bl->entries[bl->table[slot] - 1];
+        if(entry->iteration == iteration && !strcmp(entry->name,name)){
+            return entry;
         }
-        else if(tframe->test_f != NULL){
-            if(tframe->parameters != NULL) current_test_frame.frame_iterateable = true;
+        slot = (slot + 1) & (bl->table_size - 1);
+    }
+    return NULL;
+}
 
-            do{
-                if(current_test_frame.frame_iterateable){
-                    ufbgc_print_blue(current_test_frame.output_file,"Iteration : %lu\n",current_test_frame.frame_iterator);
-                }
-                
-                void * user_arg = NULL;
+static bool ufbgc_baseline_rehash(internal_ufbgc_baseline * bl, size_t table_size){
+    size_t * table = (size_t *) calloc(table_size,sizeof(size_t));
+    if(table == NULL){
+        return false;
+    }
+    for(size_t i = 0; i < bl->len; ++i){
+        size_t slot = (size_t) ufbgc_baseline_hash(bl->entries[i].name,bl->entries[i].iteration) & (table_size - 1);
+        while(table[slot] != 0){
+            slot = (slot + 1) & (table_size - 1);
+        }
+        table[slot] = i + 1;
+    }
+    free(bl->table);
+    bl->table = table;
+    bl->table_size = table_size;
+    return true;
+}
 
-                if(tframe->setup_f != NULL){
-                    tframe->setup_f(tframe->parameters, &user_arg);
-                }
+//Samples are appended to the entry in measurement order, only the last UFBGC_BASELINE_MAX_SAMPLES samples are kept
+static bool ufbgc_baseline_add(internal_ufbgc_baseline * bl, const char * name, uint32_t iteration, const double * samples, size_t no_samples){
+    internal_ufbgc_baseline_entry * entry = ufbgc_baseline_find(bl,name,iteration);
+    if(entry == NULL){
+        if(bl->len == bl->capacity){
+            size_t capacity = bl->capacity ? bl->capacity * 2 : 64;
+            internal_ufbgc_baseline_entry * entries = (internal_ufbgc_baseline_entry *) realloc(bl->entries,capacity * sizeof(*entries));
+            if(entries == NULL){
+                return false;
+            }
+            bl->entries = entries;
+            bl->capacity = capacity;
+        }
+        if((bl->len + 1) * 2 > bl->table_size && !ufbgc_baseline_rehash(bl,bl->table_size ? bl->table_size * 2 : 128)){
+            return false;
+        }
+        entry = &bl->entries[bl->len];
+        entry->name = strdup(name);
+        entry->iteration = iteration;
+        entry->no_samples = 0;
+        entry->samples = (double *) malloc(UFBGC_BASELINE_MAX_SAMPLES * sizeof(double));
+        if(entry->name == NULL || entry->samples == NULL){
+            free(entry->name);
+            free(entry->samples);
+            return false;
+        }
+        bl->len++;
+        size_t slot = (size_t) ufbgc_baseline_hash(name,iteration) & (bl->table_size - 1);
+        while(bl->table[slot] != 0){
+            slot = (slot + 1) & (bl->table_size - 1);
+        }
+        bl->table[slot] = bl->len;
+    }
 
-                current_test_frame.test_start = clock();
-                ufbgc_return_t test_result = tframe->test_f(tframe->parameters,user_arg);
-                double execution_time = ufbgc_get_execution_time_ms(current_test_frame.test_start);
-                if(test_result == UFBGC_OK){
+    if(no_samples > UFBGC_BASELINE_MAX_SAMPLES){
+        samples += no_samples - UFBGC_BASELINE_MAX_SAMPLES;
+        no_samples = UFBGC_BASELINE_MAX_SAMPLES;
+    }
+    size_t keep = entry->no_samples + no_samples > UFBGC_BASELINE_MAX_SAMPLES ? UFBGC_BASELINE_MAX_SAMPLES - no_samples : entry->no_samples;
+    memmove(entry->samples,entry->samples + (entry->no_samples - keep),keep * sizeof(double));
+    memcpy(entry->samples + keep,samples,no_samples * sizeof(double));
+    entry->no_samples = (uint32_t)(keep + no_samples);
+    return true;
+}
 
-                    ufbgc_print_green(current_test_frame.output_file,"'%s'\t\t\t%-10s %gms\n",tframe->name,"[OK]",execution_time);
-                }
-                else{
-                    ufbgc_print_red(current_test_frame.output_file,"'%s'\t\t\t%-10s\n",tframe->name,"[FAILED]");
-                }
+static void ufbgc_baseline_free(internal_ufbgc_baseline * bl){
+    for(size_t i = 0; i < bl->len; ++i){
+        free(bl->entries[i].name);
+        free(bl->entries[i].samples);
+    }
+    free(bl->entries);
+    free(bl->table);
+    memset(bl,0,sizeof(*bl));
+}
 
-                #ifdef UFBGC_PRINT_SUMMARY
-                    summary_list[iter].test_result = test_result;
-                    summary_list[iter].execution_time = execution_time;
-                #endif
-                
-                if(tframe->teardown_f != NULL){
-                    tframe->teardown_f(tframe->parameters, user_arg);   
-                }
+static bool ufbgc_baseline_load(internal_ufbgc_baseline * bl, const char * path){
+    FILE * fl = fopen(path,"rb");
+    if(fl == NULL){
+        return false;
+    }
+    char magic[8];
+    uint32_t no_entries = 0;
+    bool ok = fread(magic,1,8,fl) == 8 && !memcmp(magic,UFBGC_BASELINE_MAGIC,8) && fread(&no_entries,sizeof(no_entries),1,fl) == 1;
+
+    double * samples = (double *) malloc(UFBGC_BASELINE_MAX_SAMPLES * sizeof(double));
+    ok = ok && samples != NULL;
+    for(uint32_t i = 0; ok && i < no_entries; ++i){
+        uint16_t name_len;
+        uint32_t iteration, no_samples;
+        char name[65536];
+        ok = fread(&name_len,sizeof(name_len),1,fl) == 1 && fread(name,1,name_len,fl) == name_len;
+        name[ok ? name_len : 0] = '\0';
+        ok = ok && fread(&iteration,sizeof(iteration),1,fl) == 1 && fread(&no_samples,sizeof(no_samples),1,fl) == 1;
+        ok = ok && no_samples <= UFBGC_BASELINE_MAX_SAMPLES && fread(samples,sizeof(double),no_samples,fl) == no_samples;
+        ok = ok && ufbgc_baseline_add(bl,name,iteration,samples,no_samples);
+    }
+    free(samples);
+    fclose(fl);
+    return ok;
+}
+
+//File is written next to the old one and renamed by ufbgc_close_atomic, readers never see a partial file
+static FILE * ufbgc_open_atomic(const char * path, char ** tmp_path){
+    size_t path_len = strlen(path);
+    *tmp_path = (char *) malloc(path_len + 5);
+    if(*tmp_path == NULL){
+        return NULL;
+    }
+    memcpy(*tmp_path,path,path_len);
+    memcpy(*tmp_path + path_len,".tmp",5);
+    FILE * fl = fopen(*tmp_path,"wb");
+    if(fl == NULL){
+        free(*tmp_path);
+        *tmp_path = NULL;
+    }
+    return fl;
+}
+
+static bool ufbgc_close_atomic(FILE * fl, char * tmp_path, const char * path, bool ok){
+    if(fl == NULL){
+        return false;
+    }
+    if(fclose(fl) != 0){
+        ok = false;
+    }
+    ok = ok && rename(tmp_path,path) == 0;
+    if(!ok){
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    return ok;
+}
+
+static bool ufbgc_baseline_save(const internal_ufbgc_baseline * bl, const char * path){
+    char * tmp_path;
+    FILE * fl = ufbgc_open_atomic(path,&tmp_path);
+    bool ok = fl != NULL;
+    uint32_t no_entries = (uint32_t) bl->len;
+    ok = ok && fwrite(UFBGC_BASELINE_MAGIC,1,8,fl) == 8 && fwrite(&no_entries,sizeof(no_entries),1,fl) == 1;
+    for(size_t i = 0; ok && i < bl->len; ++i){
+        const internal_ufbgc_baseline_entry * entry = &bl->entries[i];
+        size_t name_len = strlen(entry->name);
+        uint16_t len16 = (uint16_t)(name_len > 65535 ? 65535 : name_len);
+        ok = fwrite(&len16,sizeof(len16),1,fl) == 1 && fwrite(entry->name,1,len16,fl) == len16;
+        ok = ok && fwrite(&entry->iteration,sizeof(entry->iteration),1,fl) == 1 && fwrite(&entry->no_samples,sizeof(entry->no_samples),1,fl) == 1;
+        ok = ok && fwrite(entry->samples,sizeof(double),entry->no_samples,fl) == entry->no_samples;
+    }
+    return ufbgc_close_atomic(fl,tmp_path,path,ok);
+}
+
+#ifdef UFBGC_POSIX
+static bool ufbgc_isolated_send_samples(size_t iteration, const double * samples, size_t no_samples);
+#endif
+
+//Samples of an iteration are collected for the baseline file, isolated workers send them to the parent
+static void ufbgc_collect_samples(const char * name, size_t iteration, const double * samples, size_t no_samples){
+    #ifdef UFBGC_POSIX
+        if(ufbgc_isolated_send_samples(iteration,samples,no_samples)){
+            return;
+        }
+        pthread_mutex_lock(&baseline_lock);
+    #endif
+    ufbgc_baseline_add(&baseline_current,name,(uint32_t) iteration,samples,no_samples);
+    #ifdef UFBGC_POSIX
+        pthread_mutex_unlock(&baseline_lock);
+    #endif
+}
+
+static double ufbgc_median(const double * samples, size_t no_samples){
+    double * sorted = (double *) malloc(no_samples * sizeof(double));
+    if(sorted == NULL || no_samples == 0){
+        free(sorted);
+        return 0;
+    }
+    memcpy(sorted,samples,no_samples * sizeof(double));
+    qsort(sorted,no_samples,sizeof(double),ufbgc_compare_double);
+    double median = ufbgc_percentile(sorted,no_samples,50);
+    free(sorted);
+    return median;
+}
+
+typedef struct{
+    double value;
+    int group;
+}internal_ufbgc_ranked_sample;
 
-                current_test_frame.frame_iterator++;
-            }while(current_test_frame.frame_iterateable && current_test_frame.frame_iterator < tframe->parameters->no_iteration );
+static int ufbgc_compare_ranked_sample(const void * a, const void * b){
+    return ufbgc_compare_double(&((const internal_ufbgc_ranked_sample *) a)->value,&((const internal_ufbgc_ranked_sample *) b)->value);
+}
+
+//Two sided p-value of the Mann-Whitney U test, normal approximation with tie correction
+static double ufbgc_mann_whitney_p(const double * a, size_t na, const double * b, size_t nb){
+    size_t n = na + nb;
+    internal_ufbgc_ranked_sample * all = (internal_ufbgc_ranked_sample *) malloc(n * sizeof(*all));
+    if(all == NULL){
+        return 1;
+    }
+    for(size_t i = 0; i < na; ++i) all[i] = (internal_ufbgc_ranked_sample){a[i],0};
+    for(size_t i = 0; i < nb; ++i) all[na + i] = (internal_ufbgc_ranked_sample){b[i],1};
+    qsort(all,n,sizeof(*all),ufbgc_compare_ranked_sample);
+
+    double rank_sum = 0;
+    double tie_sum = 0;
+    for(size_t i = 0; i < n;){
+        size_t j = i;
+        while(j < n && all[j].value == all[i].value) j++;
+        double rank = (double)(i + j + 1) / 2.0;
+        for(size_t k = i; k < j; ++k){
+            if(all[k].group == 0) rank_sum += rank;
         }
+        double t = (double)(j - i);
+        tie_sum += t * t * t - t;
+        i = j;
+    }
+    free(all);
+
+    double u = rank_sum - (double) na * (double)(na + 1) / 2.0;
+    double mean = (double) na * (double) nb / 2.0;
+    double variance = (double) na * (double) nb / 12.0 * ((double)(n + 1) - tie_sum / ((double) n * (double)(n - 1)));
+    if(variance <= 0){
+        return 1;
+    }
+    double z = (fabs(u - mean) - 0.5) / sqrt(variance);
+    return z <= 0 ? 1 : erfc(z / sqrt(2.0));
+}
 
-        ufbgc_print_magenta(current_test_frame.output_file,"------------------------------------------------------------\n");
-        tframe++;
-        current_test_frame.frame = NULL;
-        current_test_frame.frame_iterator = 0;
-        current_test_frame.frame_iterateable = false;
+/*
+    Compares samples of an iteration with the baseline, returns 1 for a regression, -1 for an improvement
+    Change of the median must be beyond the threshold, and it must be significant:
+    Mann-Whitney when both sides have enough samples, otherwise current median must be out of the baseline range
+    and the change must be bigger than regression_min_delta_ns
+*/
+static int ufbgc_check_regression(FILE * out, const char * name, size_t iteration, const double * samples, size_t no_samples){
+    const internal_ufbgc_baseline_entry * entry = ufbgc_baseline_find(&baseline_loaded,name,(uint32_t) iteration);
+    if(entry == NULL || entry->no_samples == 0 || no_samples == 0){
+        return 0;
+    }
+    double base_median = ufbgc_median(entry->samples,entry->no_samples);
+    double median = ufbgc_median(samples,no_samples);
+    if(base_median <= 0){
+        return 0;
+    }
+    double change = (median - base_median) / base_median;
+    if(fabs(change) * 100.0 <= runner_options.regression_threshold){
+        return 0;
+    }
 
-        if(current_test_frame.output_file != stdout){
-            fclose(current_test_frame.output_file);
+    double p = -1;
+    if(no_samples >= 5 && entry->no_samples >= 5){
+        p = ufbgc_mann_whitney_p(samples,no_samples,entry->samples,entry->no_samples);
+        if(p >= runner_options.regression_alpha){
+            return 0;
+        }
+    }
+    else{
+        //Timer noise of short tests is bigger than any threshold
+        if(fabs(median - base_median) < runner_options.regression_min_delta_ns){
+            return 0;
+        }
+        double base_min = entry->samples[0], base_max = entry->samples[0];
+        for(uint32_t i = 1; i < entry->no_samples; ++i){
+            if(entry->samples[i] < base_min) base_min = entry->samples[i];
+            if(entry->samples[i] > base_max) base_max = entry->samples[i];
+        }
+        if(median >= base_min && median <= base_max){
+            return 0;
         }
     }
 
+    char base_str[32], cur_str[32], p_str[32] = "";
+    ufbgc_format_ns(base_median,base_str,sizeof(base_str));
+    ufbgc_format_ns(median,cur_str,sizeof(cur_str));
+    if(p >= 0){
+        snprintf(p_str,sizeof(p_str),", p=%.3g",p);
+    }
+    if(change > 0){
+        ufbgc_print_red(out,"'%s'\t\t\t%-10s %+.1f%% vs baseline (median %s -> %s%s)\n",name,"[REGRESSED]",change * 100.0,base_str,cur_str,p_str);
+        return 1;
+    }
+    ufbgc_print_cyan(out,"'%s'\t\t\t%-10s %+.1f%% vs baseline (median %s -> %s%s)\n",name,"[IMPROVED]",change * 100.0,base_str,cur_str,p_str);
+    return -1;
+}
 
-    ufbgc_print_magenta(stdout,"ufbgc - tests completed\n\n");
+/*
+    Hardware counters of the thread running the test, opened with perf_event_open
+    Counters which can't be opened (no PMU, perf_event_paranoid) are skipped, test falls back to time only
+*/
+typedef struct{
+    int fds[UFBGC_PERF_LEN];
+    int error;                      //errno of the first counter which couldn't be opened
+}internal_ufbgc_perf_session;
 
-    #ifdef UFBGC_PRINT_SUMMARY
-    ufbgc_print_magenta(stdout,"ufbgc - tests summary:\n");
-    for(size_t i = 0; i<list_len; ++i){
-        const ufbgc_test_frame * tframe = summary_list[i].tframe;
-        __ufbgc_internal_assert_(tframe != NULL,"Can't put summary! Test frame pointer is NULL");
-        size_t test_name_len = strlen(tframe->name);
-        size_t right_row = 50;
-        
-        if(tframe->option == PASS_TEST){
-            ufbgc_print_yellow(stdout,"'%s'%*s\n",tframe->name,right_row-test_name_len,"[PASS]");
-            continue;
+#ifdef __linux__
+
+static const struct{
+    uint32_t type;
+    uint64_t config;
+}ufbgc_perf_events[UFBGC_PERF_LEN] = {
+    [UFBGC_PERF_CYCLES]             = {PERF_TYPE_HARDWARE,PERF_COUNT_HW_CPU_CYCLES},
+    [UFBGC_PERF_INSTRUCTIONS]       = {PERF_TYPE_HARDWARE,PERF_COUNT_HW_INSTRUCTIONS},
+    [UFBGC_PERF_BRANCH_MISSES]      = {PERF_TYPE_HARDWARE,PERF_COUNT_HW_BRANCH_MISSES},
+    [UFBGC_PERF_L1D_MISSES]         = {PERF_TYPE_HW_CACHE,PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    [UFBGC_PERF_LLC_MISSES]         = {PERF_TYPE_HW_CACHE,PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    [UFBGC_PERF_CONTEXT_SWITCHES]   = {PERF_TYPE_SOFTWARE,PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+static bool ufbgc_perf_open(internal_ufbgc_perf_session * session){
+    bool opened = false;
+    session->error = 0;
+    for(int i = 0; i < UFBGC_PERF_LEN; ++i){
+        struct perf_event_attr attr;
+        memset(&attr,0,sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = ufbgc_perf_events[i].type;
+        attr.config = ufbgc_perf_events[i].config;
+        attr.disabled = 1;
+        attr.inherit = 1;           //Threads created by the test are counted after they exit
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        session->fds[i] = (int) syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+        if(session->fds[i] >= 0){
+            opened = true;
         }
-        if(summary_list[i].test_result == UFBGC_OK){
-            ufbgc_print_green(stdout,"'%s'%*s (%g ms)\n",tframe->name,right_row-test_name_len,"[OK]",summary_list[i].execution_time);
+        else if(session->error == 0){
+            session->error = errno;
         }
-        else{
-            ufbgc_print_red(stdout,"'%s'%*s\n",tframe->name,right_row-test_name_len,"[FAILED]");
+    }
+    return opened;
+}
+
+static void ufbgc_perf_start(internal_ufbgc_perf_session * session){
+    for(int i = 0; i < UFBGC_PERF_LEN; ++i){
+        if(session->fds[i] >= 0){
+            ioctl(session->fds[i],PERF_EVENT_IOC_RESET,0);
+            ioctl(session->fds[i],PERF_EVENT_IOC_ENABLE,0);
         }
     }
-    free(summary_list);
-    #endif
+}
 
+//Counters are scaled when the kernel multiplexed them
+static void ufbgc_perf_stop(internal_ufbgc_perf_session * session, internal_ufbgc_perf_values * values){
+    for(int i = 0; i < UFBGC_PERF_LEN; ++i){
+        if(session->fds[i] >= 0){
+            ioctl(session->fds[i],PERF_EVENT_IOC_DISABLE,0);
+        }
+    }
+    memset(values,0,sizeof(*values));
+    for(int i = 0; i < UFBGC_PERF_LEN; ++i){
+        uint64_t data[3];
+        if(session->fds[i] < 0 || read(session->fds[i],data,sizeof(data)) != sizeof(data)){
+            continue;
+        }
+        values->values[i] = data[2] > 0 && data[2] < data[1] ? (uint64_t)((double) data[0] * (double) data[1] / (double) data[2]) : data[0];
+        values->available |= 1u << i;
+    }
+}
 
-    return UFBGC_OK;
+static void ufbgc_perf_close(internal_ufbgc_perf_session * session){
+    for(int i = 0; i < UFBGC_PERF_LEN; ++i){
+        if(session->fds[i] >= 0){
+            close(session->fds[i]);
+            session->fds[i] = -1;
+        }
+    }
 }
 
-ufbgc_log_verbosity_t ufbgc_get_current_test_verbosity(){
-    if(current_test_frame.frame != NULL){
-        return current_test_frame.frame->log_level;
+#else
+
+static bool ufbgc_perf_open(internal_ufbgc_perf_session * session){
+    for(int i = 0; i < UFBGC_PERF_LEN; ++i){
+        session->fds[i] = -1;
     }
-    return UFBGC_LOG_ERROR;
+    session->error = ENOSYS;
+    return false;
+}
+static void ufbgc_perf_start(internal_ufbgc_perf_session * session){
+    (void) session;
+}
+static void ufbgc_perf_stop(internal_ufbgc_perf_session * session, internal_ufbgc_perf_values * values){
+    (void) session;
+    memset(values,0,sizeof(*values));
+}
+static void ufbgc_perf_close(internal_ufbgc_perf_session * session){
+    (void) session;
 }
 
-FILE * ufbgc_get_current_test_file(){
-    if(current_test_frame.frame != NULL && current_test_frame.frame->output_file != NULL){
-        return current_test_frame.output_file;
+#endif
+
+static void ufbgc_perf_accumulate(internal_ufbgc_perf_values * sum, const internal_ufbgc_perf_values * values){
+    for(int i = 0; i < UFBGC_PERF_LEN; ++i){
+        sum->values[i] += values->values[i];
     }
-    return stdout;
+    sum->available |= values->available;
+}
+
+static bool ufbgc_perf_has(const internal_ufbgc_perf_values * values, internal_ufbgc_perf_counter counter){
+    return (values->available >> counter) & 1u;
 }
 
+//IPC and misses per thousand instructions
+static void ufbgc_print_perf_values(FILE * out, const char * color, const char * prefix, const internal_ufbgc_perf_values * values, const char * suffix){
+    const uint64_t * v = values->values;
+    double kilo_instructions = (double) v[UFBGC_PERF_INSTRUCTIONS] / 1000.0;
+    bool has_instructions = ufbgc_perf_has(values,UFBGC_PERF_INSTRUCTIONS) && kilo_instructions > 0;
+    char line[256] = "";
+    size_t len = 0;
 
-bool ufbgc_get_current_test_iterator(size_t * it){
-    if(current_test_frame.frame == NULL || it == NULL){
-        return false;
+    #define UFBGC_PERF_APPEND(format,...) \
+        len += (size_t) snprintf(line + len,sizeof(line) - len,"%s" format,len ? " | " : "",##__VA_ARGS__)
+
+    if(ufbgc_perf_has(values,UFBGC_PERF_CYCLES) && has_instructions && v[UFBGC_PERF_CYCLES] > 0){
+        UFBGC_PERF_APPEND("IPC %.2f",(double) v[UFBGC_PERF_INSTRUCTIONS] / (double) v[UFBGC_PERF_CYCLES]);
+    }
+    if(has_instructions && ufbgc_perf_has(values,UFBGC_PERF_BRANCH_MISSES)){
+        UFBGC_PERF_APPEND("branch-miss %.2f/ki",(double) v[UFBGC_PERF_BRANCH_MISSES] / kilo_instructions);
+    }
+    if(has_instructions && ufbgc_perf_has(values,UFBGC_PERF_L1D_MISSES)){
+        UFBGC_PERF_APPEND("L1d-miss %.2f/ki",(double) v[UFBGC_PERF_L1D_MISSES] / kilo_instructions);
+    }
+    if(has_instructions && ufbgc_perf_has(values,UFBGC_PERF_LLC_MISSES)){
+        UFBGC_PERF_APPEND("LLC-miss %.2f/ki",(double) v[UFBGC_PERF_LLC_MISSES] / kilo_instructions);
+    }
+    if(ufbgc_perf_has(values,UFBGC_PERF_CONTEXT_SWITCHES)){
+        UFBGC_PERF_APPEND("%llu ctx-sw",(unsigned long long) v[UFBGC_PERF_CONTEXT_SWITCHES]);
     }
 
-    *it = current_test_frame.frame_iterator;
-    return true;
+    #undef UFBGC_PERF_APPEND
+
+    ufbgc_print_colored(out,color,"%s%s%s",prefix,line,suffix);
 }
 
-const void * ufbgc_get_parameter(const char * key){
-    if(current_test_frame.frame == NULL){
-        return NULL;
+/*
+    Allocation tracker, malloc family is interposed and forwarded to glibc
+    Only allocations of the thread running the test are tracked and only while setup, test and teardown functions run
+    Live allocations are kept in a pointer set, so freeing memory which was allocated before the test is ignored
+*/
+typedef struct{
+    void * ptr;
+    size_t size;
+    int phase;
+}internal_ufbgc_alloc_entry;
+
+typedef struct{
+    int phase;
+    internal_ufbgc_alloc_entry * table;     //Linear probing, NULL pointer is an empty slot
+    size_t table_size;
+    size_t used;
+    ufbgc_alloc_stats total;                //Setup, test and teardown of the iteration
+    ufbgc_alloc_stats test;                 //Test function only
+}internal_ufbgc_alloc_tracker;
+
+#ifdef UFBGC_ALLOC_TRACKER
+
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t nmemb, size_t size);
+extern void * __libc_realloc(void * ptr, size_t size);
+extern void * __libc_memalign(size_t alignment, size_t size);
+extern void * __libc_valloc(size_t size);
+extern void * __libc_pvalloc(size_t size);
+extern void __libc_free(void * ptr);
+
+//Initial exec model, reading the tracker of the thread must not allocate
+static __thread internal_ufbgc_alloc_tracker * alloc_tracker __attribute__((tls_model("initial-exec"))) = NULL;
+
+static size_t ufbgc_alloc_slot(const internal_ufbgc_alloc_tracker * tracker, const void * ptr){
+    uintptr_t h = (uintptr_t) ptr;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return (size_t) h & (tracker->table_size - 1);
+}
+
+static bool ufbgc_alloc_grow(internal_ufbgc_alloc_tracker * tracker){
+    size_t old_size = tracker->table_size;
+    internal_ufbgc_alloc_entry * old_table = tracker->table;
+    size_t table_size = old_size ? old_size * 2 : 1024;
+    internal_ufbgc_alloc_entry * table = (internal_ufbgc_alloc_entry *) __libc_calloc(table_size,sizeof(*table));
+    if(table == NULL){
+        return false;
     }
-    //Use current tframe
-    if(current_test_frame.frame->parameters != NULL){
-        ufbgc_test_parameters * params = current_test_frame.frame->parameters;
-        const ufbgc_args * uarg = params->parameters;
-        while(uarg != NULL && uarg->key != NULL){
-            if(!strcmp(uarg->key,key)){
-                return uarg->value;
+    tracker->table = table;
+    tracker->table_size = table_size;
+    for(size_t i = 0; i < old_size; ++i){
+        if(old_table[i].ptr != NULL){
+            size_t slot = ufbgc_alloc_slot(tracker,old_table[i].ptr);
+            while(table[slot].ptr != NULL){
+                slot = (slot + 1) & (table_size - 1);
             }
-            uarg++;
+            table[slot] = old_table[i];
         }
     }
+    __libc_free(old_table);
+    return true;
+}
 
-    current_test_frame.frame_iterateable = false;
+static void ufbgc_alloc_stats_add(ufbgc_alloc_stats * stats, size_t size){
+    stats->allocations++;
+    stats->bytes += size;
+    stats->live_allocations++;
+    stats->live_bytes += size;
+    if(stats->live_bytes > stats->peak_bytes){
+        stats->peak_bytes = stats->live_bytes;
+    }
+}
 
-    return NULL;
+static void ufbgc_alloc_track(internal_ufbgc_alloc_tracker * tracker, void * ptr, size_t size){
+    if(tracker->phase == UFBGC_ALLOC_PHASE_NONE){
+        return;
+    }
+    if((tracker->used + 1) * 2 > tracker->table_size && !ufbgc_alloc_grow(tracker)){
+        return;
+    }
+    size_t slot = ufbgc_alloc_slot(tracker,ptr);
+    while(tracker->table[slot].ptr != NULL){
+        slot = (slot + 1) & (tracker->table_size - 1);
+    }
+    tracker->table[slot].ptr = ptr;
+    tracker->table[slot].size = size;
+    tracker->table[slot].phase = tracker->phase;
+    tracker->used++;
+
+    ufbgc_alloc_stats_add(&tracker->total,size);
+    if(tracker->phase == UFBGC_ALLOC_PHASE_TEST){
+        ufbgc_alloc_stats_add(&tracker->test,size);
+    }
 }
 
+//Entry is removed with backward shift, so lookups never need tombstones
+static void ufbgc_alloc_untrack(internal_ufbgc_alloc_tracker * tracker, void * ptr){
+    if(tracker->table_size == 0){
+        return;
+    }
+    size_t mask = tracker->table_size - 1;
+    size_t slot = ufbgc_alloc_slot(tracker,ptr);
+    while(tracker->table[slot].ptr != ptr){
+        if(tracker->table[slot].ptr == NULL){
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
 
-void ufbgc_get_current_time(struct tm * dest){
-    time_t rawtime;
-    time ( &rawtime );
-    struct tm * timeinfo = localtime ( &rawtime );
-    memcpy(dest,timeinfo,sizeof(struct tm));
+    internal_ufbgc_alloc_entry entry = tracker->table[slot];
+    tracker->total.frees++;
+    tracker->total.live_allocations--;
+    tracker->total.live_bytes -= entry.size;
+    if(entry.phase == UFBGC_ALLOC_PHASE_TEST){
+        tracker->test.frees++;
+        tracker->test.live_allocations--;
+        tracker->test.live_bytes -= entry.size;
+    }
+
+    size_t hole = slot;
+    for(size_t next = (hole + 1) & mask; tracker->table[next].ptr != NULL; next = (next + 1) & mask){
+        size_t home = ufbgc_alloc_slot(tracker,tracker->table[next].ptr);
+        if(((next - home) & mask) >= ((next - hole) & mask)){
+            tracker->table[hole] = tracker->table[next];
+            hole = next;
+        }
+    }
+    tracker->table[hole].ptr = NULL;
+    tracker->used--;
 }
 
+void * malloc(size_t size){
+    void * ptr = __libc_malloc(size);
+    internal_ufbgc_alloc_tracker * tracker = alloc_tracker;
+    if(__builtin_expect(tracker != NULL,0) && ptr != NULL){
+        ufbgc_alloc_track(tracker,ptr,size);
+    }
+    return ptr;
+}
 
-double ufbgc_get_execution_time(clock_t start){
-    return (double)(clock() - start) / CLOCKS_PER_SEC; 
+void * calloc(size_t nmemb, size_t size){
+    void * ptr = __libc_calloc(nmemb,size);
+    internal_ufbgc_alloc_tracker * tracker = alloc_tracker;
+    if(__builtin_expect(tracker != NULL,0) && ptr != NULL){
+        ufbgc_alloc_track(tracker,ptr,nmemb * size);
+    }
+    return ptr;
 }
-double ufbgc_get_execution_time_ms(clock_t start){
-    return (double)(clock() - start) / (CLOCKS_PER_SEC/1000); 
+
+void * realloc(void * ptr, size_t size){
+    internal_ufbgc_alloc_tracker * tracker = alloc_tracker;
+    void * new_ptr = __libc_realloc(ptr,size);
+    if(__builtin_expect(tracker != NULL,0)){
+        if(ptr != NULL && (new_ptr != NULL || size == 0)){
+            ufbgc_alloc_untrack(tracker,ptr);
+        }
+        if(new_ptr != NULL){
+            ufbgc_alloc_track(tracker,new_ptr,size);
+        }
+    }
+    return new_ptr;
 }
-double ufbgc_get_execution_time_us(clock_t start){
-    return (double)(clock() - start) / (CLOCKS_PER_SEC/1000000); 
+
+void free(void * ptr){
+    internal_ufbgc_alloc_tracker * tracker = alloc_tracker;
+    if(__builtin_expect(tracker != NULL,0) && ptr != NULL){
+        ufbgc_alloc_untrack(tracker,ptr);
+    }
+    __libc_free(ptr);
 }
 
+void * aligned_alloc(size_t alignment, size_t size){
+    void * ptr = __libc_memalign(alignment,size);
+    internal_ufbgc_alloc_tracker * tracker = alloc_tracker;
+    if(__builtin_expect(tracker != NULL,0) && ptr != NULL){
+        ufbgc_alloc_track(tracker,ptr,size);
+    }
+    return ptr;
+}
 
-int ufbgc_randint(int min, int max){
-	srand((int) clock() );
-    return rand()%(max-min + 1) + min;
-}
\ No newline at end of file
+void * memalign(size_t alignment, size_t size){
+    return aligned_alloc(alignment,size);
+}
+
+void * valloc(size_t size){
+    void * ptr = __libc_valloc(size);
+    internal_ufbgc_alloc_tracker * tracker = alloc_tracker;
+    if(__builtin_expect(tracker != NULL,0) && ptr != NULL){
+        ufbgc_alloc_track(tracker,ptr,size);
+    }
+    return ptr;
+}
+
+void * pvalloc(size_t size){
+    void * ptr = __libc_pvalloc(size);
+    internal_ufbgc_alloc_tracker * tracker = alloc_tracker;
+    if(__builtin_expect(tracker != NULL,0) && ptr != NULL){
+        ufbgc_alloc_track(tracker,ptr,size);
+    }
+    return ptr;
+}
+
+void * reallocarray(void * ptr, size_t nmemb, size_t size){
+    size_t total;
+    if(__builtin_mul_overflow(nmemb,size,&total)){
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(ptr,total);
+}
+
+int posix_memalign(void ** memptr, size_t alignment, size_t size){
+    if(alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0){
+        return EINVAL;
+    }
+    void * ptr = aligned_alloc(alignment,size);
+    if(ptr == NULL){
+        return ENOMEM;
+    }
+    *memptr = ptr;
+    return 0;
+}
+
+//Memory of ufbgc itself (e.g. buffered test output) is never tracked
+#define ufbgc_internal_malloc __libc_malloc
+#define ufbgc_internal_realloc __libc_realloc
+#define ufbgc_internal_free __libc_free
+
+static void ufbgc_alloc_attach(internal_ufbgc_alloc_tracker * tracker){
+    memset(tracker,0,sizeof(*tracker));
+    alloc_tracker = tracker;
+}
+
+static void ufbgc_alloc_detach(internal_ufbgc_alloc_tracker * tracker){
+    alloc_tracker = NULL;
+    __libc_free(tracker->table);
+    tracker->table = NULL;
+}
+
+static void ufbgc_alloc_set_phase(internal_ufbgc_alloc_phase phase){
+    if(alloc_tracker != NULL){
+        alloc_tracker->phase = phase;
+    }
+}
+
+//Allocations between suspend and resume are not tracked, e.g. shared fixtures built inside a test
+static internal_ufbgc_alloc_tracker * ufbgc_alloc_suspend(){
+    internal_ufbgc_alloc_tracker * tracker = alloc_tracker;
+    alloc_tracker = NULL;
+    return tracker;
+}
+
+static void ufbgc_alloc_resume(internal_ufbgc_alloc_tracker * tracker){
+    alloc_tracker = tracker;
+}
+
+bool ufbgc_alloc_tracking(){
+    return alloc_tracker != NULL;
+}
+
+bool ufbgc_get_alloc_stats(ufbgc_alloc_stats * stats){
+    if(alloc_tracker == NULL){
+        memset(stats,0,sizeof(*stats));
+        return false;
+    }
+    *stats = alloc_tracker->test;
+    return true;
+}
+
+#else
+
+#define ufbgc_internal_malloc malloc
+#define ufbgc_internal_realloc realloc
+#define ufbgc_internal_free free
+
+static void ufbgc_alloc_attach(internal_ufbgc_alloc_tracker * tracker){
+    memset(tracker,0,sizeof(*tracker));
+}
+static void ufbgc_alloc_detach(internal_ufbgc_alloc_tracker * tracker){
+    (void) tracker;
+}
+static void ufbgc_alloc_set_phase(internal_ufbgc_alloc_phase phase){
+    (void) phase;
+}
+static internal_ufbgc_alloc_tracker * ufbgc_alloc_suspend(){
+    return NULL;
+}
+static void ufbgc_alloc_resume(internal_ufbgc_alloc_tracker * tracker){
+    (void) tracker;
+}
+
+bool ufbgc_alloc_tracking(){
+    return false;
+}
+
+bool ufbgc_get_alloc_stats(ufbgc_alloc_stats * stats){
+    memset(stats,0,sizeof(*stats));
+    return false;
+}
+
+#endif
+
+size_t ufbgc_get_test_allocations(){
+    ufbgc_alloc_stats stats;
+    ufbgc_get_alloc_stats(&stats);
+    return stats.allocations;
+}
+
+size_t ufbgc_get_test_live_allocations(){
+    ufbgc_alloc_stats stats;
+    ufbgc_get_alloc_stats(&stats);
+    return stats.live_allocations;
+}
+
+size_t ufbgc_get_test_live_bytes(){
+    ufbgc_alloc_stats stats;
+    ufbgc_get_alloc_stats(&stats);
+    return stats.live_bytes;
+}
+
+static const char * ufbgc_format_bytes(double bytes, char * buffer, size_t size){
+    if(bytes < 1024)                        snprintf(buffer,size,"%.0fB",bytes);
+    else if(bytes < 1024.0 * 1024)          snprintf(buffer,size,"%.3gKB",bytes / 1024);
+    else if(bytes < 1024.0 * 1024 * 1024)   snprintf(buffer,size,"%.3gMB",bytes / (1024.0 * 1024));
+    else                                    snprintf(buffer,size,"%.3gGB",bytes / (1024.0 * 1024 * 1024));
+    return buffer;
+}
+
+static void ufbgc_alloc_accumulate(ufbgc_alloc_stats * sum, const ufbgc_alloc_stats * stats){
+    sum->allocations += stats->allocations;
+    sum->frees += stats->frees;
+    sum->bytes += stats->bytes;
+    sum->live_allocations += stats->live_allocations;
+    sum->live_bytes += stats->live_bytes;
+    if(stats->peak_bytes > sum->peak_bytes){
+        sum->peak_bytes = stats->peak_bytes;
+    }
+}
+
+//Allocations of the whole iteration, memory left after teardown is reported as leaked
+static void ufbgc_print_alloc_stats(FILE * out, const char * color, const char * prefix, const ufbgc_alloc_stats * stats, const char * suffix){
+    char bytes[32], peak[32], leaked[32];
+    ufbgc_print_colored(out,color,"%sallocs %lu (%s) | peak %s",prefix,(unsigned long) stats->allocations,
+        ufbgc_format_bytes((double) stats->bytes,bytes,sizeof(bytes)),ufbgc_format_bytes((double) stats->peak_bytes,peak,sizeof(peak)));
+    ufbgc_print_colored(out,stats->live_allocations ? ANSI_COLOR_YELLOW : color," | leaked %lu (%s)",(unsigned long) stats->live_allocations,
+        ufbgc_format_bytes((double) stats->live_bytes,leaked,sizeof(leaked)));
+    ufbgc_print_colored(out,color,"%s",suffix);
+}
+
+static void ufbgc_throughput_add(internal_ufbgc_throughput * throughput, uint64_t bytes, uint64_t items, double ns){
+    if(bytes > 0){
+        throughput->bytes += (double) bytes;
+        throughput->bytes_ns += ns;
+    }
+    if(items > 0){
+        throughput->items += (double) items;
+        throughput->items_ns += ns;
+    }
+}
+
+//Decimal prefixes, e.g. 1.25 GB/s, 830 Mops/s
+static const char * ufbgc_format_rate(double per_second, const char * unit, char * buffer, size_t size){
+    static const char * prefixes[] = {"","K","M","G","T"};
+    size_t prefix = 0;
+    while(per_second >= 1000 && prefix + 1 < sizeof(prefixes) / sizeof(prefixes[0])){
+        per_second /= 1000;
+        prefix++;
+    }
+    snprintf(buffer,size,"%.3g %s%s",per_second,prefixes[prefix],unit);
+    return buffer;
+}
+
+static void ufbgc_print_throughput(FILE * out, const char * color, const internal_ufbgc_throughput * throughput){
+    char rate[32];
+    if(throughput->bytes_ns > 0){
+        ufbgc_print_colored(out,color,", %s",ufbgc_format_rate(throughput->bytes * 1e9 / throughput->bytes_ns,"B/s",rate,sizeof(rate)));
+    }
+    if(throughput->items_ns > 0){
+        ufbgc_print_colored(out,color,", %s",ufbgc_format_rate(throughput->items * 1e9 / throughput->items_ns,"ops/s",rate,sizeof(rate)));
+    }
+}
+
+//CPU time, cycles and the rates of the iteration are printed after the wall time of the [OK] line
+static void ufbgc_print_time_details(FILE * out, const char * color, uint64_t cpu_ns, uint64_t cycles, const internal_ufbgc_throughput * throughput){
+    char cpu[32];
+    ufbgc_print_colored(out,color," (cpu %s",ufbgc_format_ns((double) cpu_ns,cpu,sizeof(cpu)));
+    if(cycles > 0){
+        ufbgc_print_colored(out,color,", %llu cycles",(unsigned long long) cycles);
+    }
+    ufbgc_print_throughput(out,color,throughput);
+    ufbgc_print_colored(out,color,")\n");
+}
+
+static void ufbgc_print_bench_stats(FILE * out, const internal_ufbgc_bench_stats * stats){
+    char min[32], median[32], mean[32], stddev[32], p90[32], p99[32];
+    ufbgc_print_white(out,"  %lu samples x %lu ops | min %s | median %s | mean %s | stddev %s | p90 %s | p99 %s  (per op)\n",
+        stats->samples,stats->operations,
+        ufbgc_format_ns(stats->min,min,sizeof(min)),
+        ufbgc_format_ns(stats->median,median,sizeof(median)),
+        ufbgc_format_ns(stats->mean,mean,sizeof(mean)),
+        ufbgc_format_ns(stats->stddev,stddev,sizeof(stddev)),
+        ufbgc_format_ns(stats->p90,p90,sizeof(p90)),
+        ufbgc_format_ns(stats->p99,p99,sizeof(p99)));
+}
+
+//Same name in an iteration replaces the earlier report
+static void ufbgc_add_histogram_report(internal_ufbgc_test_frame * context, const internal_ufbgc_histogram_report * report){
+    size_t i = 0;
+    while(i < context->no_histograms && strcmp(context->histograms[i].name,report->name) != 0){
+        i++;
+    }
+    if(i == UFBGC_MAX_REPORTED_HISTOGRAMS){
+        return;
+    }
+    context->histograms[i] = *report;
+    if(i == context->no_histograms){
+        context->no_histograms++;
+    }
+}
+
+static void ufbgc_print_histograms(FILE * out, const internal_ufbgc_test_frame * context){
+    for(size_t i = 0; i < context->no_histograms; ++i){
+        const internal_ufbgc_histogram_report * report = &context->histograms[i];
+        char p50[32], p99[32], p999[32], max[32];
+        ufbgc_print_white(out,"  %s: %llu values | p50 %s | p99 %s | p999 %s | max %s\n",report->name,(unsigned long long) report->count,
+            ufbgc_format_ns((double) report->p50,p50,sizeof(p50)),
+            ufbgc_format_ns((double) report->p99,p99,sizeof(p99)),
+            ufbgc_format_ns((double) report->p999,p999,sizeof(p999)),
+            ufbgc_format_ns((double) report->max,max,sizeof(max)));
+    }
+}
+
+/*
+    Events of a frame are encoded into a buffer while the frame runs, the thread which started the run
+    decodes them and calls the reporters when the output of the frame is printed
+    Buffer has the format of the binary reporter: a fixed header followed by the strings of the event
+    (test, assert type, condition, file, function, message), each string is a uint32 length and NUL terminated bytes
+*/
+typedef struct{
+    uint32_t size;                  //Size of the record, strings included
+    uint16_t type;
+    uint16_t status;
+    uint32_t iteration;
+    uint32_t line;
+    uint32_t log_level;
+    uint32_t reserved;
+    double wall_ms;
+    double cpu_ms;
+    uint64_t cycles;
+    uint64_t timestamp_ns;
+}internal_ufbgc_event_record;
+
+#define UFBGC_EVENT_STRINGS 6
+#define UFBGC_EVENT_MAGIC "UFBGCEV1"
+
+static bool ufbgc_event_buffer_append(internal_ufbgc_event_buffer * buffer, const void * data, size_t size){
+    if(buffer->size + size > buffer->capacity){
+        size_t capacity = buffer->capacity ? buffer->capacity : 1024;
+        while(capacity < buffer->size + size){
+            capacity *= 2;
+        }
+        char * buffer_data = (char *) ufbgc_internal_realloc(buffer->data,capacity);
+        if(buffer_data == NULL){
+            return false;
+        }
+        buffer->data = buffer_data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size,data,size);
+    buffer->size += size;
+    return true;
+}
+
+static void ufbgc_event_buffer_free(internal_ufbgc_event_buffer * buffer){
+    ufbgc_internal_free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
+
+/*
+    Sampling profiler, a CPU time timer of the thread running the frame sends SIGPROF and the handler walks the frame pointers
+    Samples are kept only while the test function runs and the walk stops at the runner function which called it
+    Stacks are counted in a table which is mapped before the timer starts, the handler never allocates
+*/
+#define UFBGC_PROFILE_DEPTH 64
+#define UFBGC_PROFILE_SLOTS 8192        //Power of two, at most half of the slots hold a stack
+
+typedef struct{
+    uint64_t hash;
+    uint64_t count;                     //0 is an empty slot
+    uint32_t offset;                    //First address of the stack in the pool, leaf first
+    uint32_t depth;
+}internal_ufbgc_profile_stack;
+
+typedef struct{
+    internal_ufbgc_profile_stack * stacks;
+    uintptr_t * pool;
+    size_t pool_used;
+    size_t no_stacks;
+    uint64_t samples;
+    uint64_t dropped;                   //Samples with a new stack after the table is full
+    uintptr_t boundary;                 //Frame of the runner function which calls the test function
+    volatile sig_atomic_t inside;
+    int error;                          //errno of a profiler which couldn't be opened
+    #ifdef UFBGC_PROFILER
+        timer_t timer;
+    #endif
+}internal_ufbgc_profiler;
+
+static UFBGC_THREAD_LOCAL internal_ufbgc_profiler * thread_profiler = NULL;
+
+//Caller passes its own frame address, frames from there on belong to the runner
+static void ufbgc_profile_enter(uintptr_t boundary){
+    internal_ufbgc_profiler * profiler = thread_profiler;
+    if(profiler != NULL){
+        profiler->boundary = boundary;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        profiler->inside = 1;
+    }
+}
+
+static void ufbgc_profile_leave(){
+    internal_ufbgc_profiler * profiler = thread_profiler;
+    if(profiler != NULL){
+        profiler->inside = 0;
+    }
+}
+
+#ifdef UFBGC_PROFILER
+
+#ifndef sigev_notify_thread_id
+    #define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+typedef struct{
+    uintptr_t address;
+    uintptr_t size;
+    const char * name;
+}internal_ufbgc_symbol;
+
+//Function symbols of a loaded ELF file, names point into the mapped file
+typedef struct{
+    uintptr_t base;
+    bool relative;                      //Shared objects and PIE executables, symbol values are offsets from the base
+    char name[64];                      //File name for addresses without a symbol
+    void * map;
+    size_t map_size;
+    internal_ufbgc_symbol * symbols;
+    size_t no_symbols;
+}internal_ufbgc_module;
+
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t profile_users = 0;
+static struct sigaction profile_previous_action;
+static internal_ufbgc_module * profile_modules = NULL;
+static size_t no_profile_modules = 0;
+
+static void ufbgc_profile_add(internal_ufbgc_profiler * profiler, const uintptr_t * stack, size_t depth){
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for(size_t i = 0; i < depth; ++i){
+        hash = (hash ^ (uint64_t) stack[i]) * 0x100000001b3ull;
+    }
+    profiler->samples++;
+    const size_t mask = UFBGC_PROFILE_SLOTS - 1;
+    for(size_t slot = (size_t) hash & mask;; slot = (slot + 1) & mask){
+        internal_ufbgc_profile_stack * entry = &profiler->stacks[slot];
+        if(entry->count == 0){
+            if(profiler->no_stacks >= UFBGC_PROFILE_SLOTS / 2){
+                profiler->dropped++;
+                return;
+            }
+            entry->hash = hash;
+            entry->offset = (uint32_t) profiler->pool_used;
+            entry->depth = (uint32_t) depth;
+            entry->count = 1;
+            memcpy(profiler->pool + profiler->pool_used,stack,depth * sizeof(uintptr_t));
+            profiler->pool_used += depth;
+            profiler->no_stacks++;
+            return;
+        }
+        if(entry->hash == hash && entry->depth == depth && !memcmp(profiler->pool + entry->offset,stack,depth * sizeof(uintptr_t))){
+            entry->count++;
+            return;
+        }
+    }
+}
+
+//Frame records are {caller frame, return address}, a record outside of the stack pointer and the runner frame ends the walk
+static void ufbgc_profile_signal(int signal_number, siginfo_t * info, void * context){
+    (void) signal_number;
+    (void) info;
+    internal_ufbgc_profiler * profiler = thread_profiler;
+    if(profiler == NULL || !profiler->inside){
+        return;
+    }
+    const ucontext_t * uc = (const ucontext_t *) context;
+    #if defined(__x86_64__)
+        uintptr_t pc = (uintptr_t) uc->uc_mcontext.gregs[REG_RIP];
+        uintptr_t fp = (uintptr_t) uc->uc_mcontext.gregs[REG_RBP];
+        uintptr_t sp = (uintptr_t) uc->uc_mcontext.gregs[REG_RSP];
+    #else
+        uintptr_t pc = (uintptr_t) uc->uc_mcontext.pc;
+        uintptr_t fp = (uintptr_t) uc->uc_mcontext.regs[29];
+        uintptr_t sp = (uintptr_t) uc->uc_mcontext.sp;
+    #endif
+    uintptr_t stack[UFBGC_PROFILE_DEPTH];
+    size_t depth = 0;
+    stack[depth++] = pc;
+    while(depth < UFBGC_PROFILE_DEPTH && fp >= sp && fp < profiler->boundary && fp % sizeof(uintptr_t) == 0){
+        const uintptr_t * record = (const uintptr_t *) fp;
+        if(record[0] <= fp || record[0] >= profiler->boundary || record[1] == 0){
+            break;
+        }
+        stack[depth++] = record[1] - 1;     //Inside of the call instruction
+        fp = record[0];
+    }
+    ufbgc_profile_add(profiler,stack,depth);
+}
+
+//SIGPROF handler is installed while any frame is profiled, the handler of the program is put back after the last one
+static bool ufbgc_profile_open(internal_ufbgc_profiler * profiler){
+    memset(profiler,0,sizeof(*profiler));
+    size_t table_size = UFBGC_PROFILE_SLOTS * sizeof(internal_ufbgc_profile_stack);
+    size_t pool_size = UFBGC_PROFILE_SLOTS / 2 * UFBGC_PROFILE_DEPTH * sizeof(uintptr_t);
+    void * map = mmap(NULL,table_size + pool_size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+    if(map == MAP_FAILED){
+        profiler->error = errno;
+        return false;
+    }
+    profiler->stacks = (internal_ufbgc_profile_stack *) map;
+    profiler->pool = (uintptr_t *)((char *) map + table_size);
+
+    pthread_mutex_lock(&profile_lock);
+    if(profile_users++ == 0){
+        struct sigaction action;
+        memset(&action,0,sizeof(action));
+        action.sa_sigaction = ufbgc_profile_signal;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF,&action,&profile_previous_action);
+    }
+    pthread_mutex_unlock(&profile_lock);
+
+    struct sigevent event;
+    memset(&event,0,sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = (pid_t) syscall(SYS_gettid);
+    if(timer_create(CLOCK_THREAD_CPUTIME_ID,&event,&profiler->timer) != 0){
+        profiler->error = errno;
+        munmap(map,table_size + pool_size);
+        pthread_mutex_lock(&profile_lock);
+        if(--profile_users == 0){
+            sigaction(SIGPROF,&profile_previous_action,NULL);
+        }
+        pthread_mutex_unlock(&profile_lock);
+        return false;
+    }
+    return true;
+}
+
+static void ufbgc_profile_set_timer(internal_ufbgc_profiler * profiler, long interval_ns){
+    struct itimerspec spec;
+    memset(&spec,0,sizeof(spec));
+    spec.it_interval.tv_sec = interval_ns / 1000000000l;
+    spec.it_interval.tv_nsec = interval_ns % 1000000000l;
+    spec.it_value = spec.it_interval;
+    timer_settime(profiler->timer,0,&spec,NULL);
+}
+
+//Table is cleared for every iteration, the timer runs from setup to teardown but only the test function is sampled
+static void ufbgc_profile_start(internal_ufbgc_profiler * profiler){
+    memset(profiler->stacks,0,UFBGC_PROFILE_SLOTS * sizeof(internal_ufbgc_profile_stack));
+    profiler->pool_used = 0;
+    profiler->no_stacks = 0;
+    profiler->samples = 0;
+    profiler->dropped = 0;
+    profiler->inside = 0;
+    thread_profiler = profiler;
+    size_t hz = runner_options.profile_hz ? runner_options.profile_hz : 1;
+    ufbgc_profile_set_timer(profiler,(long)(1000000000ull / hz));
+}
+
+static void ufbgc_profile_stop(internal_ufbgc_profiler * profiler){
+    ufbgc_profile_set_timer(profiler,0);
+    thread_profiler = NULL;
+}
+
+static void ufbgc_profile_close(internal_ufbgc_profiler * profiler){
+    timer_delete(profiler->timer);
+    munmap(profiler->stacks,UFBGC_PROFILE_SLOTS * sizeof(internal_ufbgc_profile_stack) + UFBGC_PROFILE_SLOTS / 2 * UFBGC_PROFILE_DEPTH * sizeof(uintptr_t));
+    pthread_mutex_lock(&profile_lock);
+    if(--profile_users == 0){
+        sigaction(SIGPROF,&profile_previous_action,NULL);
+    }
+    pthread_mutex_unlock(&profile_lock);
+}
+
+static int ufbgc_symbol_compare(const void * a, const void * b){
+    uintptr_t x = ((const internal_ufbgc_symbol *) a)->address, y = ((const internal_ufbgc_symbol *) b)->address;
+    return x < y ? -1 : x > y;
+}
+
+//Symbol table is preferred, stripped files fall back to the dynamic symbols
+static void ufbgc_module_load(internal_ufbgc_module * module, const char * path){
+    int fd = open(path,O_RDONLY | O_CLOEXEC);
+    if(fd < 0){
+        return;
+    }
+    struct stat st;
+    void * map = MAP_FAILED;
+    if(fstat(fd,&st) == 0 && (size_t) st.st_size >= sizeof(Elf64_Ehdr)){
+        map = mmap(NULL,(size_t) st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    }
+    close(fd);
+    if(map == MAP_FAILED){
+        return;
+    }
+    module->map = map;
+    module->map_size = (size_t) st.st_size;
+
+    const char * data = (const char *) map;
+    const Elf64_Ehdr * header = (const Elf64_Ehdr *) map;
+    if(memcmp(header->e_ident,ELFMAG,SELFMAG) != 0 || header->e_ident[EI_CLASS] != ELFCLASS64 || header->e_shoff == 0 ||
+        header->e_shoff + (uint64_t) header->e_shnum * sizeof(Elf64_Shdr) > module->map_size){
+        return;
+    }
+    module->relative = header->e_type == ET_DYN;
+    const Elf64_Shdr * sections = (const Elf64_Shdr *)(data + header->e_shoff);
+    const Elf64_Shdr * symtab = NULL;
+    for(size_t i = 0; i < header->e_shnum; ++i){
+        if(sections[i].sh_type == SHT_SYMTAB || (sections[i].sh_type == SHT_DYNSYM && symtab == NULL)){
+            symtab = &sections[i];
+        }
+    }
+    if(symtab == NULL || symtab->sh_link >= header->e_shnum || symtab->sh_offset + symtab->sh_size > module->map_size){
+        return;
+    }
+    const Elf64_Shdr * strtab = &sections[symtab->sh_link];
+    if(strtab->sh_offset + strtab->sh_size > module->map_size){
+        return;
+    }
+    const Elf64_Sym * symbols = (const Elf64_Sym *)(data + symtab->sh_offset);
+    size_t no_symbols = symtab->sh_size / sizeof(Elf64_Sym);
+    module->symbols = (internal_ufbgc_symbol *) ufbgc_internal_malloc((no_symbols ? no_symbols : 1) * sizeof(internal_ufbgc_symbol));
+    if(module->symbols == NULL){
+        return;
+    }
+    for(size_t i = 0; i < no_symbols; ++i){
+        int type = ELF64_ST_TYPE(symbols[i].st_info);
+        if((type == STT_FUNC || type == STT_GNU_IFUNC) && symbols[i].st_shndx != SHN_UNDEF && symbols[i].st_value != 0 &&
+            symbols[i].st_name < strtab->sh_size){
+            internal_ufbgc_symbol * symbol = &module->symbols[module->no_symbols++];
+            symbol->address = (uintptr_t) symbols[i].st_value;
+            symbol->size = (uintptr_t) symbols[i].st_size;
+            symbol->name = data + strtab->sh_offset + symbols[i].st_name;
+        }
+    }
+    qsort(module->symbols,module->no_symbols,sizeof(internal_ufbgc_symbol),ufbgc_symbol_compare);
+}
+
+//Modules are loaded once and kept until the run ends, callers hold the profile lock
+static const internal_ufbgc_module * ufbgc_profile_module(const Dl_info * info){
+    for(size_t i = 0; i < no_profile_modules; ++i){
+        if(profile_modules[i].base == (uintptr_t) info->dli_fbase){
+            return &profile_modules[i];
+        }
+    }
+    internal_ufbgc_module * modules = (internal_ufbgc_module *) ufbgc_internal_realloc(profile_modules,(no_profile_modules + 1) * sizeof(internal_ufbgc_module));
+    if(modules == NULL){
+        return NULL;
+    }
+    profile_modules = modules;
+    internal_ufbgc_module * module = &profile_modules[no_profile_modules++];
+    memset(module,0,sizeof(*module));
+    module->base = (uintptr_t) info->dli_fbase;
+    const char * slash = strrchr(info->dli_fname,'/');
+    snprintf(module->name,sizeof(module->name),"%s",slash != NULL ? slash + 1 : info->dli_fname);
+    //dladdr names the executable by argv[0], which is not a path when it is found in PATH
+    ufbgc_module_load(module,strcmp(info->dli_fname,program_invocation_name) == 0 ? "/proc/self/exe" : info->dli_fname);
+    return module;
+}
+
+static void ufbgc_profile_symbol(uintptr_t address, char * dest, size_t size){
+    Dl_info info;
+    if(dladdr((void *) address,&info) == 0 || info.dli_fname == NULL){
+        snprintf(dest,size,"0x%llx",(unsigned long long) address);
+        return;
+    }
+    const internal_ufbgc_module * module = ufbgc_profile_module(&info);
+    if(module != NULL && module->no_symbols > 0){
+        uintptr_t value = module->relative ? address - module->base : address;
+        size_t low = 0, high = module->no_symbols;
+        while(low < high){
+            size_t mid = low + (high - low) / 2;
+            if(module->symbols[mid].address <= value) low = mid + 1;
+            else high = mid;
+        }
+        const internal_ufbgc_symbol * symbol = low > 0 ? &module->symbols[low - 1] : NULL;
+        if(symbol != NULL && (value < symbol->address + symbol->size || value == symbol->address)){
+            snprintf(dest,size,"%s",symbol->name);
+            return;
+        }
+    }
+    //Addresses without a symbol (e.g. local functions of a stripped library) are merged by their file
+    snprintf(dest,size,"[%s]",module != NULL ? module->name : info.dli_fname);
+}
+
+static void ufbgc_profile_free_modules(){
+    for(size_t i = 0; i < no_profile_modules; ++i){
+        if(profile_modules[i].map != NULL){
+            munmap(profile_modules[i].map,profile_modules[i].map_size);
+        }
+        ufbgc_internal_free(profile_modules[i].symbols);
+    }
+    ufbgc_internal_free(profile_modules);
+    profile_modules = NULL;
+    no_profile_modules = 0;
+}
+
+#else
+
+static bool ufbgc_profile_open(internal_ufbgc_profiler * profiler){
+    memset(profiler,0,sizeof(*profiler));
+    profiler->error = ENOSYS;
+    return false;
+}
+static void ufbgc_profile_start(internal_ufbgc_profiler * profiler){
+    (void) profiler;
+}
+static void ufbgc_profile_stop(internal_ufbgc_profiler * profiler){
+    (void) profiler;
+}
+static void ufbgc_profile_close(internal_ufbgc_profiler * profiler){
+    (void) profiler;
+}
+static void ufbgc_profile_symbol(uintptr_t address, char * dest, size_t size){
+    snprintf(dest,size,"0x%llx",(unsigned long long) address);
+}
+static void ufbgc_profile_free_modules(){
+}
+
+#endif
+
+/*
+    Folded stacks of an iteration, one line per stack: test;root;...;leaf count
+    Stacks of different addresses in the same functions are merged, lines are sorted
+    File is <profile dir>/<test>.<iteration>.folded, characters which are not allowed in a folded frame or a file name are replaced
+*/
+typedef struct{
+    char * line;
+    uint64_t count;
+}internal_ufbgc_folded_stack;
+
+static int ufbgc_folded_compare(const void * a, const void * b){
+    return strcmp(((const internal_ufbgc_folded_stack *) a)->line,((const internal_ufbgc_folded_stack *) b)->line);
+}
+
+static bool ufbgc_profile_write(const internal_ufbgc_profiler * profiler, const char * test_name, size_t iteration, char * path, size_t path_size){
+    char name[128];
+    snprintf(name,sizeof(name),"%s",test_name != NULL ? test_name : "NULL");
+    for(char * c = name; *c; ++c){
+        bool allowed = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') || *c == '_' || *c == '-' || *c == '.';
+        if(!allowed){
+            *c = '_';
+        }
+    }
+    #ifdef UFBGC_POSIX
+        mkdir(runner_options.profile_dir,0777);
+    #endif
+    snprintf(path,path_size,"%s/%s.%lu.folded",runner_options.profile_dir,name,(unsigned long) iteration);
+
+    internal_ufbgc_folded_stack * folded = (internal_ufbgc_folded_stack *) ufbgc_internal_malloc((profiler->no_stacks ? profiler->no_stacks : 1) * sizeof(*folded));
+    if(folded == NULL){
+        return false;
+    }
+    size_t no_folded = 0;
+    bool ok = true;
+    #ifdef UFBGC_PROFILER
+        pthread_mutex_lock(&profile_lock);
+    #endif
+    internal_ufbgc_event_buffer line;
+    memset(&line,0,sizeof(line));
+    char symbol[256];
+    for(size_t i = 0; ok && i < UFBGC_PROFILE_SLOTS && no_folded < profiler->no_stacks; ++i){
+        const internal_ufbgc_profile_stack * entry = &profiler->stacks[i];
+        if(entry->count == 0){
+            continue;
+        }
+        line.size = 0;
+        ok = ufbgc_event_buffer_append(&line,name,strlen(name));
+        for(size_t k = entry->depth; ok && k-- > 0;){
+            symbol[0] = ';';
+            ufbgc_profile_symbol(profiler->pool[entry->offset + k],symbol + 1,sizeof(symbol) - 1);
+            for(char * c = symbol + 1; *c; ++c){
+                if(*c == ';' || *c == ' ') *c = '_';
+            }
+            ok = ufbgc_event_buffer_append(&line,symbol,strlen(symbol));
+        }
+        ok = ok && ufbgc_event_buffer_append(&line,"",1);
+        folded[no_folded].line = ok ? (char *) ufbgc_internal_malloc(line.size) : NULL;
+        ok = ok && folded[no_folded].line != NULL;
+        if(ok){
+            memcpy(folded[no_folded].line,line.data,line.size);
+            folded[no_folded++].count = entry->count;
+        }
+    }
+    #ifdef UFBGC_PROFILER
+        pthread_mutex_unlock(&profile_lock);
+    #endif
+    ufbgc_event_buffer_free(&line);
+    qsort(folded,no_folded,sizeof(*folded),ufbgc_folded_compare);
+
+    char * tmp_path;
+    FILE * fl = ok ? ufbgc_open_atomic(path,&tmp_path) : NULL;
+    for(size_t i = 0; fl != NULL && i < no_folded; ++i){
+        uint64_t count = folded[i].count;
+        while(i + 1 < no_folded && !strcmp(folded[i].line,folded[i + 1].line)){
+            count += folded[++i].count;
+        }
+        fprintf(fl,"%s %llu\n",folded[i].line,(unsigned long long) count);
+    }
+    for(size_t i = 0; i < no_folded; ++i){
+        ufbgc_internal_free(folded[i].line);
+    }
+    ufbgc_internal_free(folded);
+    return fl != NULL && ufbgc_close_atomic(fl,tmp_path,path,true);
+}
+
+static void ufbgc_encode_event(internal_ufbgc_event_buffer * buffer, const ufbgc_event * event){
+    const char * strings[UFBGC_EVENT_STRINGS] = {event->test,event->assert_type,event->condition,event->file,event->function,event->message};
+    uint32_t lengths[UFBGC_EVENT_STRINGS];
+    internal_ufbgc_event_record record;
+    memset(&record,0,sizeof(record));
+    record.size = sizeof(record);
+    for(size_t i = 0; i < UFBGC_EVENT_STRINGS; ++i){
+        lengths[i] = strings[i] != NULL ? (uint32_t) strlen(strings[i]) : 0;
+        record.size += (uint32_t)(sizeof(uint32_t) + lengths[i] + 1);
+    }
+    record.type = (uint16_t) event->type;
+    record.status = (uint16_t) event->status;
+    record.iteration = (uint32_t) event->iteration;
+    record.line = event->line;
+    record.log_level = (uint32_t) event->log_level;
+    record.wall_ms = event->wall_ms;
+    record.cpu_ms = event->cpu_ms;
+    record.cycles = event->cycles;
+    record.timestamp_ns = event->timestamp_ns;
+
+    size_t size = buffer->size;
+    bool appended = ufbgc_event_buffer_append(buffer,&record,sizeof(record));
+    for(size_t i = 0; i < UFBGC_EVENT_STRINGS && appended; ++i){
+        appended = ufbgc_event_buffer_append(buffer,&lengths[i],sizeof(lengths[i])) &&
+            ufbgc_event_buffer_append(buffer,strings[i] != NULL ? strings[i] : "",lengths[i] + 1);
+    }
+    //Record is dropped as a whole if the buffer can't grow
+    if(!appended){
+        buffer->size = size;
+    }
+}
+
+//Strings of the event point into data
+static bool ufbgc_decode_event(const char * data, size_t size, size_t * offset, ufbgc_event * event){
+    internal_ufbgc_event_record record;
+    if(size - *offset < sizeof(record)){
+        return false;
+    }
+    memcpy(&record,data + *offset,sizeof(record));
+    if(record.size < sizeof(record) || size - *offset < record.size){
+        return false;
+    }
+    const char * strings[UFBGC_EVENT_STRINGS];
+    size_t position = *offset + sizeof(record);
+    size_t end = *offset + record.size;
+    for(size_t i = 0; i < UFBGC_EVENT_STRINGS; ++i){
+        uint32_t length;
+        if(end - position < sizeof(length)){
+            return false;
+        }
+        memcpy(&length,data + position,sizeof(length));
+        position += sizeof(length);
+        if(end - position < (size_t) length + 1){
+            return false;
+        }
+        strings[i] = data + position;
+        position += (size_t) length + 1;
+    }
+
+    memset(event,0,sizeof(*event));
+    event->type = (ufbgc_event_type_t) record.type;
+    event->status = (ufbgc_status_t) record.status;
+    event->iteration = record.iteration;
+    event->line = record.line;
+    event->log_level = (ufbgc_log_verbosity_t) record.log_level;
+    event->wall_ms = record.wall_ms;
+    event->cpu_ms = record.cpu_ms;
+    event->cycles = record.cycles;
+    event->timestamp_ns = record.timestamp_ns;
+    event->test = strings[0];
+    event->assert_type = strings[1];
+    event->condition = strings[2];
+    event->file = strings[3];
+    event->function = strings[4];
+    event->message = strings[5];
+    *offset = end;
+    return true;
+}
+
+static uint64_t ufbgc_get_unix_time_ns(){
+    #ifdef UFBGC_POSIX
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME,&ts);
+        return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+    #else
+        return (uint64_t) time(NULL) * 1000000000ull;
+    #endif
+}
+
+//Event of the frame running on this thread, dropped if there is no reporter
+static void ufbgc_emit_event(ufbgc_event * event){
+    if(current_test_frame.events == NULL){
+        return;
+    }
+    event->timestamp_ns = ufbgc_get_unix_time_ns();
+    ufbgc_encode_event(current_test_frame.events,event);
+}
+
+static const char * ufbgc_status_name(ufbgc_status_t status){
+    switch(status){
+        case UFBGC_STATUS_OK:           return "ok";
+        case UFBGC_STATUS_FAILED:       return "failed";
+        case UFBGC_STATUS_CRASHED:      return "crashed";
+        case UFBGC_STATUS_SKIPPED:      return "skipped";
+        case UFBGC_STATUS_REGRESSED:    return "regressed";
+        case UFBGC_STATUS_CACHED:       return "cached";
+        case UFBGC_STATUS_OVER_BUDGET:  return "over_budget";
+        case UFBGC_STATUS_TIMEOUT:      return "timeout";
+    }
+    return "unknown";
+}
+
+
+#define UFBGC_MAX_REPORTERS 8
+
+static ufbgc_reporter reporters[UFBGC_MAX_REPORTERS];
+static bool reporter_files[UFBGC_MAX_REPORTERS];   //Context is a report file created by ufbgc_add_report_file
+static size_t no_reporters = 0;
+
+bool ufbgc_add_reporter(const ufbgc_reporter * reporter){
+    if(reporter == NULL || no_reporters >= UFBGC_MAX_REPORTERS){
+        return false;
+    }
+    reporters[no_reporters] = *reporter;
+    reporter_files[no_reporters] = false;
+    no_reporters++;
+    return true;
+}
+
+static void ufbgc_report_run_start(size_t no_tests){
+    for(size_t i = 0; i < no_reporters; ++i){
+        if(reporters[i].run_start != NULL) reporters[i].run_start(reporters[i].context,no_tests);
+    }
+}
+
+static void ufbgc_report_run_end(ufbgc_return_t result){
+    for(size_t i = 0; i < no_reporters; ++i){
+        if(reporters[i].run_end != NULL) reporters[i].run_end(reporters[i].context,result);
+    }
+}
+
+//Events of a finished frame are decoded and passed to every reporter
+static void ufbgc_report_events(const internal_ufbgc_event_buffer * events){
+    size_t offset = 0;
+    ufbgc_event event;
+    while(ufbgc_decode_event(events->data,events->size,&offset,&event)){
+        for(size_t i = 0; i < no_reporters; ++i){
+            if(reporters[i].event != NULL) reporters[i].event(reporters[i].context,&event);
+        }
+    }
+}
+
+
+/*
+    Report files, every event is written as soon as the reporter gets it and the file is flushed after each test
+    Only the failures of the running test are kept in memory by the JUnit reporter, <testcase> needs the time of the test first
+    JUnit <testcase> elements go to a temporary file, <testsuite> is written with the counts of the run when the run ends
+*/
+typedef enum{
+    UFBGC_REPORT_JUNIT,
+    UFBGC_REPORT_JSONL,
+    UFBGC_REPORT_BINARY,
+}internal_ufbgc_report_format;
+
+typedef struct{
+    internal_ufbgc_report_format format;
+    char * path;
+    FILE * file;
+    internal_ufbgc_event_buffer failures;       //JUnit: <failure> elements of the running test
+    internal_ufbgc_event_buffer system_out;     //JUnit: failed likely assertions of the running test
+    internal_ufbgc_event_buffer record;         //Binary: encoded event
+    FILE * testcases;                           //JUnit: <testcase> elements of the run
+    size_t no_tests, no_failures, no_errors, no_skipped;   //JUnit: counts of <testsuite>
+}internal_ufbgc_report_file;
+
+static void ufbgc_json_string(FILE * file, const char * str){
+    fputc('"',file);
+    for(const unsigned char * c = (const unsigned char *) str; *c; ++c){
+        if(*c == '"' || *c == '\\')    fprintf(file,"\\%c",*c);
+        else if(*c == '\n')             fputs("\\n",file);
+        else if(*c == '\t')             fputs("\\t",file);
+        else if(*c < 0x20)              fprintf(file,"\\u%04x",*c);
+        else                            fputc(*c,file);
+    }
+    fputc('"',file);
+}
+
+static void ufbgc_xml_escape(internal_ufbgc_event_buffer * buffer, const char * str){
+    for(const unsigned char * c = (const unsigned char *) str; *c; ++c){
+        const char * entity = NULL;
+        switch(*c){
+            case '&':  entity = "&amp;";  break;
+            case '<':  entity = "&lt;";   break;
+            case '>':  entity = "&gt;";   break;
+            case '"':  entity = "&quot;"; break;
+            case '\'': entity = "&apos;"; break;
+        }
+        if(entity != NULL){
+            ufbgc_event_buffer_append(buffer,entity,strlen(entity));
+        }
+        else if(*c < 0x20 && *c != '\n' && *c != '\t'){
+            ufbgc_event_buffer_append(buffer,"?",1);      //Not allowed in XML 1.0
+        }
+        else{
+            ufbgc_event_buffer_append(buffer,c,1);
+        }
+    }
+}
+
+static void ufbgc_xml_append(internal_ufbgc_event_buffer * buffer, const char * str){
+    ufbgc_event_buffer_append(buffer,str,strlen(str));
+}
+
+static void ufbgc_report_file_run_start(void * context, size_t no_tests){
+    internal_ufbgc_report_file * report = (internal_ufbgc_report_file *) context;
+    report->file = fopen(report->path,report->format == UFBGC_REPORT_BINARY ? "wb" : "w");
+    if(report->file == NULL){
+        ufbgc_print_red(stdout,"ufbgc - can't create report '%s'\n",report->path);
+        return;
+    }
+    const ufbgc_environment * env = ufbgc_get_environment();
+    const char * properties[][2] = {
+        {"cpu",env->cpu_model},
+        {"kernel",env->kernel},
+        {"governor",env->governor},
+        {"compiler",env->compiler},
+        {"compile_flags",env->compile_flags},
+    };
+    if(report->format == UFBGC_REPORT_JUNIT){
+        report->testcases = tmpfile();
+        if(report->testcases == NULL){
+            ufbgc_print_red(stdout,"ufbgc - can't create report '%s'\n",report->path);
+            fclose(report->file);
+            report->file = NULL;
+            return;
+        }
+        report->no_tests = report->no_failures = report->no_errors = report->no_skipped = 0;
+        internal_ufbgc_event_buffer buffer;
+        memset(&buffer,0,sizeof(buffer));
+        ufbgc_xml_append(&buffer,"    <properties>\n");
+        for(size_t i = 0; i < sizeof(properties) / sizeof(properties[0]); ++i){
+            ufbgc_xml_append(&buffer,"      <property name=\"");
+            ufbgc_xml_append(&buffer,properties[i][0]);
+            ufbgc_xml_append(&buffer,"\" value=\"");
+            ufbgc_xml_escape(&buffer,properties[i][1]);
+            ufbgc_xml_append(&buffer,"\"/>\n");
+        }
+        ufbgc_xml_append(&buffer,"    </properties>\n");
+        fwrite(buffer.data,1,buffer.size,report->testcases);
+        ufbgc_event_buffer_free(&buffer);
+    }
+    else if(report->format == UFBGC_REPORT_JSONL){
+        fprintf(report->file,"{\"event\":\"run_start\",\"tests\":%lu,\"cpus\":%lu",no_tests,(unsigned long) env->online_cpus);
+        for(size_t i = 0; i < sizeof(properties) / sizeof(properties[0]); ++i){
+            fprintf(report->file,",\"%s\":",properties[i][0]);
+            ufbgc_json_string(report->file,properties[i][1]);
+        }
+        fprintf(report->file,",\"timestamp_ns\":%llu}\n",(unsigned long long) ufbgc_get_unix_time_ns());
+    }
+    else{
+        fwrite(UFBGC_EVENT_MAGIC,1,strlen(UFBGC_EVENT_MAGIC),report->file);
+    }
+    fflush(report->file);
+}
+
+static void ufbgc_report_junit_event(internal_ufbgc_report_file * report, const ufbgc_event * event){
+    char number[64];
+    if(event->type == UFBGC_EVENT_TEST_START){
+        report->failures.size = 0;
+        report->system_out.size = 0;
+    }
+    else if(event->type == UFBGC_EVENT_ASSERT_FAIL){
+        internal_ufbgc_event_buffer * buffer = event->log_level == UFBGC_LOG_ERROR ? &report->failures : &report->system_out;
+        if(buffer == &report->failures){
+            ufbgc_xml_append(buffer,"      <failure type=\"");
+            ufbgc_xml_escape(buffer,event->assert_type);
+            ufbgc_xml_append(buffer,"\" message=\"");
+            ufbgc_xml_escape(buffer,event->condition);
+            ufbgc_xml_append(buffer,"\">");
+        }
+        ufbgc_xml_escape(buffer,event->file);
+        ufbgc_xml_append(buffer,"/");
+        ufbgc_xml_escape(buffer,event->function);
+        snprintf(number,sizeof(number),":%u iteration %lu",event->line,(unsigned long) event->iteration);
+        ufbgc_xml_append(buffer,number);
+        if(buffer == &report->system_out){
+            ufbgc_xml_append(buffer," ");
+            ufbgc_xml_escape(buffer,event->assert_type);
+            ufbgc_xml_append(buffer," failed: ");
+            ufbgc_xml_escape(buffer,event->condition);
+        }
+        if(event->message[0] != '\0'){
+            ufbgc_xml_append(buffer,"\n");
+            ufbgc_xml_escape(buffer,event->message);
+        }
+        ufbgc_xml_append(buffer,buffer == &report->failures ? "</failure>\n" : "\n");
+    }
+    else if(event->type == UFBGC_EVENT_TEST_END){
+        internal_ufbgc_event_buffer name = {NULL,0,0};
+        ufbgc_xml_escape(&name,event->test);
+        ufbgc_event_buffer_append(&name,"",1);
+        fprintf(report->testcases,"    <testcase classname=\"ufbgc\" name=\"%s\" time=\"%.6f\">\n",name.data != NULL ? name.data : "",event->wall_ms / 1e3);
+        ufbgc_event_buffer_free(&name);
+
+        report->no_tests++;
+        switch(event->status){
+            case UFBGC_STATUS_SKIPPED:
+            case UFBGC_STATUS_CACHED:       report->no_skipped++;   break;
+            case UFBGC_STATUS_CRASHED:
+            case UFBGC_STATUS_TIMEOUT:      report->no_errors++;    break;
+            case UFBGC_STATUS_FAILED:
+            case UFBGC_STATUS_OVER_BUDGET:
+            case UFBGC_STATUS_REGRESSED:    report->no_failures++;  break;
+            default:                                                break;
+        }
+
+        if(event->status == UFBGC_STATUS_SKIPPED){
+            fputs("      <skipped/>\n",report->testcases);
+        }
+        else if(event->status == UFBGC_STATUS_CACHED){
+            fputs("      <skipped message=\"cached\"/>\n",report->testcases);
+        }
+        else if(event->status == UFBGC_STATUS_CRASHED){
+            internal_ufbgc_event_buffer message = {NULL,0,0};
+            ufbgc_xml_escape(&message,event->message);
+            ufbgc_event_buffer_append(&message,"",1);
+            fprintf(report->testcases,"      <error type=\"crash\" message=\"%s\"/>\n",message.data != NULL ? message.data : "");
+            ufbgc_event_buffer_free(&message);
+        }
+        else if(event->status == UFBGC_STATUS_TIMEOUT){
+            internal_ufbgc_event_buffer message = {NULL,0,0};
+            ufbgc_xml_escape(&message,event->message);
+            ufbgc_event_buffer_append(&message,"",1);
+            fprintf(report->testcases,"      <error type=\"timeout\" message=\"%s\"/>\n",message.data != NULL ? message.data : "");
+            ufbgc_event_buffer_free(&message);
+        }
+        else if(event->status == UFBGC_STATUS_OVER_BUDGET){
+            internal_ufbgc_event_buffer message = {NULL,0,0};
+            ufbgc_xml_escape(&message,event->message);
+            ufbgc_event_buffer_append(&message,"",1);
+            fprintf(report->testcases,"      <failure type=\"budget\" message=\"%s\"/>\n",message.data != NULL ? message.data : "");
+            ufbgc_event_buffer_free(&message);
+        }
+        else if(event->status == UFBGC_STATUS_REGRESSED){
+            fputs("      <failure type=\"regression\" message=\"slower than the baseline\"/>\n",report->testcases);
+        }
+        else if(event->status == UFBGC_STATUS_FAILED && report->failures.size == 0){
+            fputs("      <failure type=\"test\" message=\"test function returned UFBGC_FAIL\"/>\n",report->testcases);
+        }
+        if(event->status == UFBGC_STATUS_FAILED || event->status == UFBGC_STATUS_CRASHED || event->status == UFBGC_STATUS_TIMEOUT){
+            fwrite(report->failures.data,1,report->failures.size,report->testcases);
+        }
+        if(report->system_out.size > 0){
+            fputs("      <system-out>",report->testcases);
+            fwrite(report->system_out.data,1,report->system_out.size,report->testcases);
+            fputs("</system-out>\n",report->testcases);
+        }
+        fputs("    </testcase>\n",report->testcases);
+        fflush(report->testcases);
+    }
+}
+
+static void ufbgc_report_jsonl_event(internal_ufbgc_report_file * report, const ufbgc_event * event){
+    FILE * file = report->file;
+    static const char * event_names[] = {"","test_start","assert_fail","iteration_end","test_end"};
+    fprintf(file,"{\"event\":\"%s\",\"test\":",event_names[event->type]);
+    ufbgc_json_string(file,event->test);
+    if(event->type == UFBGC_EVENT_ASSERT_FAIL){
+        fprintf(file,",\"iteration\":%lu,\"level\":\"%s\",\"type\":",(unsigned long) event->iteration,event->log_level == UFBGC_LOG_ERROR ? "error" : "warning");
+        ufbgc_json_string(file,event->assert_type);
+        fputs(",\"condition\":",file);
+        ufbgc_json_string(file,event->condition);
+        fputs(",\"file\":",file);
+        ufbgc_json_string(file,event->file);
+        fputs(",\"function\":",file);
+        ufbgc_json_string(file,event->function);
+        fprintf(file,",\"line\":%u,\"message\":",event->line);
+        ufbgc_json_string(file,event->message);
+    }
+    else if(event->type == UFBGC_EVENT_TEST_START && event->message[0] != '\0'){
+        fputs(",\"noise\":",file);
+        ufbgc_json_string(file,event->message);
+    }
+    else if(event->type == UFBGC_EVENT_ITERATION_END || event->type == UFBGC_EVENT_TEST_END){
+        fprintf(file,",\"%s\":%lu,\"status\":\"%s\",\"wall_ms\":%.9g,\"cpu_ms\":%.9g,\"cycles\":%llu",
+            event->type == UFBGC_EVENT_TEST_END ? "iterations" : "iteration",(unsigned long) event->iteration,
+            ufbgc_status_name(event->status),event->wall_ms,event->cpu_ms,(unsigned long long) event->cycles);
+        if(event->message[0] != '\0'){
+            fputs(",\"message\":",file);
+            ufbgc_json_string(file,event->message);
+        }
+    }
+    fprintf(file,",\"timestamp_ns\":%llu}\n",(unsigned long long) event->timestamp_ns);
+    if(event->type == UFBGC_EVENT_TEST_END){
+        fflush(file);
+    }
+}
+
+static void ufbgc_report_file_event(void * context, const ufbgc_event * event){
+    internal_ufbgc_report_file * report = (internal_ufbgc_report_file *) context;
+    if(report->file == NULL){
+        return;
+    }
+    if(report->format == UFBGC_REPORT_JUNIT){
+        ufbgc_report_junit_event(report,event);
+    }
+    else if(report->format == UFBGC_REPORT_JSONL){
+        ufbgc_report_jsonl_event(report,event);
+    }
+    else{
+        report->record.size = 0;
+        ufbgc_encode_event(&report->record,event);
+        fwrite(report->record.data,1,report->record.size,report->file);
+        if(event->type == UFBGC_EVENT_TEST_END){
+            fflush(report->file);
+        }
+    }
+}
+
+static void ufbgc_report_file_run_end(void * context, ufbgc_return_t result){
+    internal_ufbgc_report_file * report = (internal_ufbgc_report_file *) context;
+    if(report->file == NULL){
+        return;
+    }
+    if(report->format == UFBGC_REPORT_JUNIT){
+        fprintf(report->file,"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites tests=\"%lu\" failures=\"%lu\" errors=\"%lu\" skipped=\"%lu\">\n",
+            (unsigned long) report->no_tests,(unsigned long) report->no_failures,(unsigned long) report->no_errors,(unsigned long) report->no_skipped);
+        fprintf(report->file,"  <testsuite name=\"ufbgc\" tests=\"%lu\" failures=\"%lu\" errors=\"%lu\" skipped=\"%lu\">\n",
+            (unsigned long) report->no_tests,(unsigned long) report->no_failures,(unsigned long) report->no_errors,(unsigned long) report->no_skipped);
+        char chunk[4096];
+        size_t size;
+        rewind(report->testcases);
+        while((size = fread(chunk,1,sizeof(chunk),report->testcases)) > 0){
+            fwrite(chunk,1,size,report->file);
+        }
+        fclose(report->testcases);
+        report->testcases = NULL;
+        fputs("  </testsuite>\n</testsuites>\n",report->file);
+    }
+    else if(report->format == UFBGC_REPORT_JSONL){
+        fprintf(report->file,"{\"event\":\"run_end\",\"result\":\"%s\",\"timestamp_ns\":%llu}\n",
+            result == UFBGC_OK ? "ok" : "failed",(unsigned long long) ufbgc_get_unix_time_ns());
+    }
+    fclose(report->file);
+    report->file = NULL;
+}
+
+bool ufbgc_add_report_file(const char * format, const char * path){
+    internal_ufbgc_report_format report_format;
+    if(format == NULL || path == NULL || no_reporters >= UFBGC_MAX_REPORTERS) return false;
+    else if(!strcmp(format,"junit"))    report_format = UFBGC_REPORT_JUNIT;
+    else if(!strcmp(format,"jsonl"))    report_format = UFBGC_REPORT_JSONL;
+    else if(!strcmp(format,"binary"))   report_format = UFBGC_REPORT_BINARY;
+    else return false;
+
+    internal_ufbgc_report_file * report = (internal_ufbgc_report_file *) calloc(1,sizeof(internal_ufbgc_report_file));
+    if(report == NULL){
+        return false;
+    }
+    report->format = report_format;
+    report->path = strdup(path);
+    if(report->path == NULL){
+        free(report);
+        return false;
+    }
+    ufbgc_reporter reporter = {
+        .run_start = ufbgc_report_file_run_start,
+        .event = ufbgc_report_file_event,
+        .run_end = ufbgc_report_file_run_end,
+        .context = report,
+    };
+    ufbgc_add_reporter(&reporter);
+    reporter_files[no_reporters - 1] = true;
+    return true;
+}
+
+void ufbgc_clear_reporters(){
+    for(size_t i = 0; i < no_reporters; ++i){
+        if(reporter_files[i]){
+            internal_ufbgc_report_file * report = (internal_ufbgc_report_file *) reporters[i].context;
+            if(report->file != NULL){
+                fclose(report->file);
+            }
+            if(report->testcases != NULL){
+                fclose(report->testcases);
+            }
+            ufbgc_event_buffer_free(&report->failures);
+            ufbgc_event_buffer_free(&report->system_out);
+            ufbgc_event_buffer_free(&report->record);
+            free(report->path);
+            free(report);
+        }
+    }
+    no_reporters = 0;
+}
+
+static uint64_t ufbgc_param_hash(const char * key){
+    return ufbgc_hash_bytes(0xcbf29ce484222325ull,key,strlen(key));
+}
+
+static bool ufbgc_param_index_insert(internal_ufbgc_param_slot * slots, size_t size, const ufbgc_args * arg, bool generated){
+    uint64_t hash = ufbgc_param_hash(arg->key);
+    size_t slot = (size_t) hash & (size - 1);
+    while(slots[slot].key != NULL){
+        if(slots[slot].hash == hash && !strcmp(slots[slot].key,arg->key)){
+            return false;
+        }
+        slot = (slot + 1) & (size - 1);
+    }
+    slots[slot].key = arg->key;
+    slots[slot].hash = hash;
+    slots[slot].arg = arg;
+    slots[slot].generated = generated;
+    return true;
+}
+
+//First parameter wins when a key is repeated, same as a scan of the list, generated keys come after the list
+static void ufbgc_param_index_build(internal_ufbgc_param_index * index, const ufbgc_test_parameters * params,
+    const internal_ufbgc_gen_node * nodes, size_t no_nodes){
+    index->slots = NULL;
+    index->size = 0;
+
+    size_t count = 0;
+    while(params != NULL && params->parameters[count].key != NULL){
+        count++;
+    }
+    count += no_nodes;
+    if(count == 0){
+        return;
+    }
+
+    size_t size = 8;
+    while(size < count * 2){
+        size <<= 1;
+    }
+    internal_ufbgc_param_slot * slots = (internal_ufbgc_param_slot *) ufbgc_internal_malloc(size * sizeof(*slots));
+    if(slots == NULL){
+        return;
+    }
+    memset(slots,0,size * sizeof(*slots));
+
+    for(const ufbgc_args * arg = params != NULL ? params->parameters : NULL; arg != NULL && arg->key != NULL; ++arg){
+        ufbgc_param_index_insert(slots,size,arg,false);
+    }
+    for(size_t i = 0; i < no_nodes; ++i){
+        if(nodes[i].arg.key != NULL){
+            ufbgc_param_index_insert(slots,size,&nodes[i].arg,true);
+        }
+    }
+    index->slots = slots;
+    index->size = size;
+}
+
+static void ufbgc_param_index_free(internal_ufbgc_param_index * index){
+    ufbgc_internal_free(index->slots);
+    index->slots = NULL;
+    index->size = 0;
+}
+
+static const ufbgc_args * ufbgc_find_parameter(const internal_ufbgc_test_frame * context, const char * key, bool * generated){
+    const internal_ufbgc_param_index * index = &context->params;
+    if(index->size == 0){
+        //No index (e.g. out of memory), scan the list and the generators
+        const ufbgc_test_parameters * params = context->frame->parameters;
+        for(const ufbgc_args * arg = params != NULL ? params->parameters : NULL; arg != NULL && arg->key != NULL; ++arg){
+            if(!strcmp(arg->key,key)){
+                *generated = false;
+                return arg;
+            }
+        }
+        for(size_t i = 0; i < context->no_gen_nodes; ++i){
+            const ufbgc_args * arg = &context->gen_nodes[i].arg;
+            if(arg->key != NULL && !strcmp(arg->key,key)){
+                *generated = true;
+                return arg;
+            }
+        }
+        return NULL;
+    }
+
+    uint64_t hash = ufbgc_param_hash(key);
+    size_t slot = (size_t) hash & (index->size - 1);
+    while(index->slots[slot].key != NULL){
+        const internal_ufbgc_param_slot * entry = &index->slots[slot];
+        if(entry->key == key || (entry->hash == hash && !strcmp(entry->key,key))){
+            *generated = entry->generated;
+            return entry->arg;
+        }
+        slot = (slot + 1) & (index->size - 1);
+    }
+    return NULL;
+}
+
+static size_t ufbgc_gen_count_nodes(const ufbgc_generator * generator){
+    size_t count = 1;
+    if(generator->kind == UFBGC_GENERATOR_CARTESIAN || generator->kind == UFBGC_GENERATOR_ZIP){
+        for(size_t i = 0; i < generator->combine.count; ++i){
+            count += ufbgc_gen_count_nodes(generator->combine.generators[i]);
+        }
+    }
+    return count;
+}
+
+static size_t ufbgc_gen_layout(internal_ufbgc_gen_node * nodes, size_t position, const ufbgc_generator * generator){
+    internal_ufbgc_gen_node * node = &nodes[position];
+    node->generator = generator;
+    size_t next = position + 1;
+    if(generator->kind == UFBGC_GENERATOR_CARTESIAN || generator->kind == UFBGC_GENERATOR_ZIP){
+        for(size_t i = 0; i < generator->combine.count; ++i){
+            next = ufbgc_gen_layout(nodes,next,generator->combine.generators[i]);
+        }
+    }
+    else{
+        node->arg.key = generator->key;
+        node->arg.type = generator->type;
+    }
+    node->end = next;
+    return next;
+}
+
+static size_t ufbgc_gen_value_size(ufbgc_param_type_t type){
+    switch(type){
+        case UFBGC_PARAM_INT: return sizeof(int);
+        case UFBGC_PARAM_DOUBLE: return sizeof(double);
+        case UFBGC_PARAM_STRING: return sizeof(const char *);
+        case UFBGC_PARAM_BLOB: return sizeof(ufbgc_blob);
+        default: return 0;
+    }
+}
+
+//Reads the next line which is not empty or a comment, the line is parsed into the type of the generator
+static bool ufbgc_gen_read_line(internal_ufbgc_gen_node * node, FILE * out){
+    for(;;){
+        size_t length = 0;
+        for(;;){
+            if(node->line_capacity - length < 2){
+                size_t capacity = node->line_capacity ? node->line_capacity * 2 : 256;
+                char * line = (char *) ufbgc_internal_realloc(node->line,capacity);
+                if(line == NULL){
+                    node->failed = true;
+                    ufbgc_print_red(out,"Generator '%s': line of '%s' cannot be allocated\n",node->generator->key,node->generator->path);
+                    return false;
+                }
+                node->line = line;
+                node->line_capacity = capacity;
+            }
+            if(fgets(node->line + length,(int)(node->line_capacity - length),node->file) == NULL){
+                break;
+            }
+            length += strlen(node->line + length);
+            if(length > 0 && node->line[length - 1] == '\n'){
+                break;
+            }
+        }
+        if(length == 0){
+            return false;
+        }
+        while(length > 0 && (node->line[length - 1] == '\n' || node->line[length - 1] == '\r')){
+            node->line[--length] = '\0';
+        }
+        if(length == 0 || node->line[0] == '#'){
+            continue;
+        }
+
+        node->index++;
+        char * end = NULL;
+        switch(node->generator->type){
+            case UFBGC_PARAM_INT:
+                node->value.i = (int) strtol(node->line,&end,0);
+                break;
+            case UFBGC_PARAM_DOUBLE:
+                node->value.d = strtod(node->line,&end);
+                break;
+            case UFBGC_PARAM_BLOB:
+                node->value.b.data = node->line;
+                node->value.b.size = length;
+                return true;
+            default:
+                node->value.s = node->line;
+                return true;
+        }
+        if(end == node->line || *end != '\0'){
+            node->failed = true;
+            ufbgc_print_red(out,"Generator '%s': line '%s' of '%s' is not %s\n",node->generator->key,node->line,
+                node->generator->path,node->generator->type == UFBGC_PARAM_INT ? "an int" : "a double");
+            return false;
+        }
+        return true;
+    }
+}
+
+//Leaves point arg.value at their current value, return false when they have no value
+static bool ufbgc_gen_leaf_value(internal_ufbgc_gen_node * node){
+    const ufbgc_generator * generator = node->generator;
+    switch(generator->kind){
+        case UFBGC_GENERATOR_INT_RANGE:{
+            long long value = (long long) generator->int_range.start + (long long) node->index * generator->int_range.step;
+            node->value.i = (int) value;
+            node->arg.value = &node->value.i;
+            return generator->int_range.step > 0 ? value < generator->int_range.stop :
+                generator->int_range.step < 0 && value > generator->int_range.stop;
+        }
+        case UFBGC_GENERATOR_DOUBLE_RANGE:
+            node->value.d = generator->double_range.start + (double) node->index * generator->double_range.step;
+            node->arg.value = &node->value.d;
+            return generator->double_range.step > 0 ? node->value.d < generator->double_range.stop :
+                generator->double_range.step < 0 && node->value.d > generator->double_range.stop;
+        case UFBGC_GENERATOR_VALUES:
+            node->arg.value = (const char *) generator->values.values + node->index * ufbgc_gen_value_size(generator->type);
+            return node->index < generator->values.count;
+        default:
+            return false;
+    }
+}
+
+static bool ufbgc_gen_reset(internal_ufbgc_gen_node * nodes, size_t position, FILE * out){
+    internal_ufbgc_gen_node * node = &nodes[position];
+    const ufbgc_generator * generator = node->generator;
+    node->index = 0;
+    switch(generator->kind){
+        case UFBGC_GENERATOR_CARTESIAN:
+        case UFBGC_GENERATOR_ZIP:{
+            bool has_value = true;
+            for(size_t child = position + 1; child < node->end; child = nodes[child].end){
+                has_value = ufbgc_gen_reset(nodes,child,out) && has_value;
+            }
+            return has_value;
+        }
+        case UFBGC_GENERATOR_FILE:
+            node->arg.value = generator->type == UFBGC_PARAM_INT ? (const void *) &node->value.i :
+                generator->type == UFBGC_PARAM_DOUBLE ? (const void *) &node->value.d :
+                generator->type == UFBGC_PARAM_BLOB ? (const void *) &node->value.b : (const void *) &node->value.s;
+            if(node->file == NULL){
+                node->file = fopen(generator->path,"r");
+                if(node->file == NULL){
+                    node->failed = true;
+                    ufbgc_print_red(out,"Generator '%s': '%s' cannot be opened (%s)\n",generator->key,generator->path,strerror(errno));
+                    return false;
+                }
+            }
+            else{
+                rewind(node->file);
+            }
+            return ufbgc_gen_read_line(node,out);
+        default:
+            if((generator->kind == UFBGC_GENERATOR_VALUES && ufbgc_gen_value_size(generator->type) == 0) ||
+                (generator->kind == UFBGC_GENERATOR_INT_RANGE && generator->int_range.step == 0) ||
+                (generator->kind == UFBGC_GENERATOR_DOUBLE_RANGE && !(generator->double_range.step != 0))){
+                node->failed = true;
+                ufbgc_print_red(out,"Generator '%s': %s\n",generator->key ? generator->key : "NULL",
+                    generator->kind == UFBGC_GENERATOR_VALUES ? "values need a type" : "step of the range is zero");
+                return false;
+            }
+            return ufbgc_gen_leaf_value(node);
+    }
+}
+
+//Moves to the next combination, cartesian products work like an odometer
+static bool ufbgc_gen_advance(internal_ufbgc_gen_node * nodes, size_t position, FILE * out){
+    internal_ufbgc_gen_node * node = &nodes[position];
+    switch(node->generator->kind){
+        case UFBGC_GENERATOR_CARTESIAN:{
+            size_t children[node->end - position];
+            size_t no_children = 0;
+            for(size_t child = position + 1; child < node->end; child = nodes[child].end){
+                children[no_children++] = child;
+            }
+            while(no_children > 0){
+                size_t child = children[--no_children];
+                if(ufbgc_gen_advance(nodes,child,out)){
+                    return true;
+                }
+                if(no_children == 0 || !ufbgc_gen_reset(nodes,child,out)){
+                    return false;
+                }
+            }
+            return false;
+        }
+        case UFBGC_GENERATOR_ZIP:{
+            bool has_value = true;
+            for(size_t child = position + 1; child < node->end; child = nodes[child].end){
+                has_value = ufbgc_gen_advance(nodes,child,out) && has_value;
+            }
+            return has_value;
+        }
+        case UFBGC_GENERATOR_FILE:
+            return ufbgc_gen_read_line(node,out);
+        default:
+            node->index++;
+            return ufbgc_gen_leaf_value(node);
+    }
+}
+
+//Starts the generator of the frame, returns false if it has no values
+static bool ufbgc_gen_start(internal_ufbgc_test_frame * context, const ufbgc_generator * generator, FILE * out){
+    size_t count = ufbgc_gen_count_nodes(generator);
+    internal_ufbgc_gen_node * nodes = (internal_ufbgc_gen_node *) ufbgc_internal_malloc(count * sizeof(*nodes));
+    if(nodes == NULL){
+        ufbgc_print_red(out,"Generator state cannot be allocated\n");
+        return false;
+    }
+    memset(nodes,0,count * sizeof(*nodes));
+    ufbgc_gen_layout(nodes,0,generator);
+    context->gen_nodes = nodes;
+    context->no_gen_nodes = count;
+    return ufbgc_gen_reset(nodes,0,out);
+}
+
+static bool ufbgc_gen_failed(const internal_ufbgc_test_frame * context){
+    for(size_t i = 0; i < context->no_gen_nodes; ++i){
+        if(context->gen_nodes[i].failed){
+            return true;
+        }
+    }
+    return context->gen_nodes == NULL;
+}
+
+static void ufbgc_gen_stop(internal_ufbgc_test_frame * context){
+    for(size_t i = 0; i < context->no_gen_nodes; ++i){
+        if(context->gen_nodes[i].file != NULL){
+            fclose(context->gen_nodes[i].file);
+        }
+        ufbgc_internal_free(context->gen_nodes[i].line);
+    }
+    ufbgc_internal_free(context->gen_nodes);
+    context->gen_nodes = NULL;
+    context->no_gen_nodes = 0;
+}
+
+//Prints the generated values of the iteration as key=value pairs
+static void ufbgc_gen_print_values(FILE * out, const internal_ufbgc_test_frame * context){
+    for(size_t i = 0; i < context->no_gen_nodes; ++i){
+        const ufbgc_args * arg = &context->gen_nodes[i].arg;
+        if(arg->key == NULL){
+            continue;
+        }
+        switch(arg->type){
+            case UFBGC_PARAM_INT: ufbgc_print_blue(out," %s=%d",arg->key,*(const int *) arg->value); break;
+            case UFBGC_PARAM_DOUBLE: ufbgc_print_blue(out," %s=%g",arg->key,*(const double *) arg->value); break;
+            case UFBGC_PARAM_STRING: ufbgc_print_blue(out," %s='%s'",arg->key,*(const char * const *) arg->value); break;
+            case UFBGC_PARAM_BLOB: ufbgc_print_blue(out," %s=<%lu bytes>",arg->key,((const ufbgc_blob *) arg->value)->size); break;
+            default: break;
+        }
+    }
+}
+
+/*
+    State of a fixture in a run, users are the frames which list it and have not finished yet
+    Ready is read without the lock once the fixture is built, the data is never changed while it is set
+*/
+typedef enum{
+    UFBGC_FIXTURE_EMPTY = 0,
+    UFBGC_FIXTURE_READY,
+    UFBGC_FIXTURE_FAILED,
+}internal_ufbgc_fixture_status;
+
+typedef struct internal_ufbgc_fixture_state{
+    ufbgc_fixture * fixture;
+    void * data;
+    size_t users;
+    bool pinned;                    //Asked by a frame which does not list it, kept until the run ends
+    bool inherited;                 //Built by the parent of a forked worker, only the parent tears it down
+    int status;
+    #ifdef UFBGC_POSIX
+        pthread_mutex_t lock;
+    #endif
+    struct internal_ufbgc_fixture_state * next;
+}internal_ufbgc_fixture_state;
+
+static internal_ufbgc_fixture_state * fixtures = NULL;
+#ifdef UFBGC_POSIX
+static pthread_mutex_t fixtures_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+//Called with fixtures_lock held or before workers start
+static internal_ufbgc_fixture_state * ufbgc_fixture_register(ufbgc_fixture * fixture){
+    internal_ufbgc_fixture_state * state = (internal_ufbgc_fixture_state *) __atomic_load_n(&fixture->internal,__ATOMIC_ACQUIRE);
+    if(state != NULL){
+        return state;
+    }
+    state = (internal_ufbgc_fixture_state *) ufbgc_internal_malloc(sizeof(*state));
+    if(state == NULL){
+        return NULL;
+    }
+    memset(state,0,sizeof(*state));
+    state->fixture = fixture;
+    #ifdef UFBGC_POSIX
+        pthread_mutex_init(&state->lock,NULL);
+    #endif
+    state->next = fixtures;
+    fixtures = state;
+    __atomic_store_n(&fixture->internal,state,__ATOMIC_RELEASE);
+    return state;
+}
+
+//Counts the users of the fixtures of the frames at the given positions of the run
+static void ufbgc_fixtures_count_users(const internal_ufbgc_test_run * run, const size_t * positions, size_t no_positions){
+    for(internal_ufbgc_fixture_state * state = fixtures; state != NULL; state = state->next){
+        state->users = 0;
+    }
+    for(size_t i = 0; i < no_positions; ++i){
+        const ufbgc_test_frame * tframe = &run->test_list[run->indices[positions != NULL ? positions[i] : i]];
+        for(ufbgc_fixture * const * fixture = tframe->fixtures; fixture != NULL && *fixture != NULL; ++fixture){
+            internal_ufbgc_fixture_state * state = ufbgc_fixture_register(*fixture);
+            if(state != NULL){
+                state->users++;
+            }
+        }
+    }
+}
+
+static void ufbgc_fixture_teardown(internal_ufbgc_fixture_state * state){
+    if(state->status == UFBGC_FIXTURE_READY && state->fixture->teardown_f != NULL && !state->inherited){
+        internal_ufbgc_alloc_tracker * tracker = ufbgc_alloc_suspend();
+        state->fixture->teardown_f(state->data);
+        ufbgc_alloc_resume(tracker);
+    }
+    state->data = NULL;
+    __atomic_store_n(&state->status,UFBGC_FIXTURE_EMPTY,__ATOMIC_RELEASE);
+}
+
+//Frame is finished, fixtures without users are torn down
+static void ufbgc_fixtures_release(const ufbgc_test_frame * tframe){
+    for(ufbgc_fixture * const * fixture = tframe->fixtures; fixture != NULL && *fixture != NULL; ++fixture){
+        internal_ufbgc_fixture_state * state = (internal_ufbgc_fixture_state *) __atomic_load_n(&(*fixture)->internal,__ATOMIC_ACQUIRE);
+        if(state == NULL || __atomic_sub_fetch(&state->users,1,__ATOMIC_ACQ_REL) != 0){
+            continue;
+        }
+        #ifdef UFBGC_POSIX
+            pthread_mutex_lock(&state->lock);
+        #endif
+        if(!state->pinned){
+            ufbgc_fixture_teardown(state);
+        }
+        #ifdef UFBGC_POSIX
+            pthread_mutex_unlock(&state->lock);
+        #endif
+    }
+}
+
+//Worker forked in the middle of a run uses the fixtures its parent built, but does not tear them down
+static void ufbgc_fixtures_inherit(){
+    for(internal_ufbgc_fixture_state * state = fixtures; state != NULL; state = state->next){
+        state->inherited = state->status == UFBGC_FIXTURE_READY;
+    }
+}
+
+//End of a run or of an isolated worker, every fixture is torn down and forgotten
+static void ufbgc_fixtures_finish(){
+    internal_ufbgc_fixture_state * state = fixtures;
+    while(state != NULL){
+        internal_ufbgc_fixture_state * next = state->next;
+        ufbgc_fixture_teardown(state);
+        __atomic_store_n(&state->fixture->internal,NULL,__ATOMIC_RELEASE);
+        #ifdef UFBGC_POSIX
+            pthread_mutex_destroy(&state->lock);
+        #endif
+        ufbgc_internal_free(state);
+        state = next;
+    }
+    fixtures = NULL;
+}
+
+/*
+    Builds the fixture on its first use, other threads asking for it wait until it is built
+    Build time is left out of the timer of the running test and its allocations are not tracked
+*/
+const void * ufbgc_get_fixture(ufbgc_fixture * fixture){
+    if(fixture == NULL){
+        return NULL;
+    }
+    internal_ufbgc_fixture_state * state = (internal_ufbgc_fixture_state *) __atomic_load_n(&fixture->internal,__ATOMIC_ACQUIRE);
+    if(state != NULL && __atomic_load_n(&state->status,__ATOMIC_ACQUIRE) == UFBGC_FIXTURE_READY){
+        return state->data;
+    }
+    if(state == NULL){
+        #ifdef UFBGC_POSIX
+            pthread_mutex_lock(&fixtures_lock);
+        #endif
+        state = ufbgc_fixture_register(fixture);
+        if(state != NULL){
+            state->pinned = true;
+        }
+        #ifdef UFBGC_POSIX
+            pthread_mutex_unlock(&fixtures_lock);
+        #endif
+        if(state == NULL){
+            return NULL;
+        }
+    }
+    bool listed = current_test_frame.frame == NULL;
+    for(ufbgc_fixture * const * frame_fixture = listed ? NULL : current_test_frame.frame->fixtures; frame_fixture != NULL && *frame_fixture != NULL; ++frame_fixture){
+        listed = listed || *frame_fixture == fixture;
+    }
+
+    #ifdef UFBGC_POSIX
+        pthread_mutex_lock(&state->lock);
+    #endif
+    if(!listed){
+        state->pinned = true;
+    }
+    if(state->status == UFBGC_FIXTURE_EMPTY){
+        FILE * out = ufbgc_get_current_test_file();
+        internal_ufbgc_alloc_tracker * tracker = ufbgc_alloc_suspend();
+        ufbgc_timer timer;
+        ufbgc_timer_start(&timer);
+        void * data = NULL;
+        ufbgc_return_t result = fixture->setup_f != NULL ? fixture->setup_f(&data) : UFBGC_OK;
+        ufbgc_timer_stop(&timer);
+        ufbgc_alloc_resume(tracker);
+
+        if(current_test_frame.frame != NULL){
+            ufbgc_time_sample * start = &current_test_frame.test_timer.start;
+            start->wall_ns += timer.elapsed.wall_ns;
+            start->cpu_ns += timer.elapsed.cpu_ns;
+            start->cycles += timer.elapsed.cycles;
+        }
+        if(result == UFBGC_OK){
+            state->data = data;
+            ufbgc_print_cyan(out,"Fixture '%s' is built in %gms\n",fixture->name ? fixture->name : "NULL",(double) timer.elapsed.wall_ns / 1e6);
+        }
+        else{
+            ufbgc_print_red(out,"Fixture '%s' setup failed\n",fixture->name ? fixture->name : "NULL");
+        }
+        __atomic_store_n(&state->status,result == UFBGC_OK ? UFBGC_FIXTURE_READY : UFBGC_FIXTURE_FAILED,__ATOMIC_RELEASE);
+    }
+    void * data = state->status == UFBGC_FIXTURE_READY ? state->data : NULL;
+    #ifdef UFBGC_POSIX
+        pthread_mutex_unlock(&state->lock);
+    #endif
+    return data;
+}
+
+//xoshiro256** of the calling thread, used tells if the current iteration drew a random number
+typedef struct{
+    uint64_t state[4];
+    uint64_t seed;
+    bool seeded;
+    bool used;
+}internal_ufbgc_random;
+
+static UFBGC_THREAD_LOCAL internal_ufbgc_random thread_random;
+
+static uint64_t ufbgc_splitmix64(uint64_t * x){
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t ufbgc_rotl64(uint64_t x, int k){
+    return (x << k) | (x >> (64 - k));
+}
+
+void ufbgc_seed_random(uint64_t seed){
+    internal_ufbgc_random * random = &thread_random;
+    uint64_t x = seed;
+    for(int i = 0; i < 4; ++i){
+        random->state[i] = ufbgc_splitmix64(&x);
+    }
+    random->seed = seed;
+    random->seeded = true;
+    random->used = false;
+}
+
+//Same seed for an iteration whichever thread, process or shard runs it
+static uint64_t ufbgc_iteration_seed(const char * name, size_t iteration){
+    uint64_t x = runner_options.seed ^ ufbgc_hash_bytes(0xcbf29ce484222325ull,name != NULL ? name : "",name != NULL ? strlen(name) : 0);
+    x += (uint64_t) iteration * 0xd1b54a32d192ed03ull;
+    return ufbgc_splitmix64(&x);
+}
+
+uint64_t ufbgc_get_seed(){
+    if(!thread_random.seeded){
+        ufbgc_seed_random(ufbgc_iteration_seed(NULL,(size_t)(uintptr_t) &thread_random));
+    }
+    return thread_random.seed;
+}
+
+uint64_t ufbgc_rand_u64(){
+    internal_ufbgc_random * random = &thread_random;
+    if(UFBGC_EXPECT_FALSE(!random->seeded)){
+        ufbgc_get_seed();
+    }
+    random->used = true;
+    uint64_t * s = random->state;
+    uint64_t result = ufbgc_rotl64(s[1] * 5,7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = ufbgc_rotl64(s[3],45);
+    return result;
+}
+
+//Lemire's multiply and shift, rejection keeps it unbiased
+uint64_t ufbgc_rand_below(uint64_t bound){
+    if(bound == 0){
+        return 0;
+    }
+    #ifdef __SIZEOF_INT128__
+        unsigned __int128 m = (unsigned __int128) ufbgc_rand_u64() * bound;
+        uint64_t low = (uint64_t) m;
+        if(low < bound){
+            uint64_t threshold = -bound % bound;
+            while(low < threshold){
+                m = (unsigned __int128) ufbgc_rand_u64() * bound;
+                low = (uint64_t) m;
+            }
+        }
+        return (uint64_t)(m >> 64);
+    #else
+        uint64_t threshold = -bound % bound;
+        uint64_t r;
+        do{
+            r = ufbgc_rand_u64();
+        }while(r < threshold);
+        return r % bound;
+    #endif
+}
+
+int ufbgc_randint(int min, int max){
+    if(max <= min){
+        return min;
+    }
+    return (int)((int64_t) min + (int64_t) ufbgc_rand_below((uint64_t)((int64_t) max - min) + 1));
+}
+
+double ufbgc_rand_double(){
+    return (double)(ufbgc_rand_u64() >> 11) * 0x1.0p-53;
+}
+
+void ufbgc_rand_bytes(void * dest, size_t size){
+    unsigned char * p = (unsigned char *) dest;
+    while(size >= 8){
+        uint64_t r = ufbgc_rand_u64();
+        memcpy(p,&r,8);
+        p += 8;
+        size -= 8;
+    }
+    if(size > 0){
+        uint64_t r = ufbgc_rand_u64();
+        memcpy(p,&r,size);
+    }
+}
+
+/*
+    Environment of a run, collected when the run starts and given to the reporters
+    Frames which measure time are preceded by a check of the noise sources of the CPU they run on
+*/
+#ifndef UFBGC_COMPILE_FLAGS
+    #ifdef __OPTIMIZE__
+        #define UFBGC_COMPILE_FLAGS "optimized"
+    #else
+        #define UFBGC_COMPILE_FLAGS "not optimized"
+    #endif
+#endif
+
+#if defined(__clang__)
+    #define UFBGC_COMPILER "clang " __clang_version__
+#elif defined(__GNUC__)
+    #define UFBGC_COMPILER "gcc " __VERSION__
+#elif defined(_MSC_VER)
+    #define UFBGC_COMPILER "msvc"
+#else
+    #define UFBGC_COMPILER "unknown compiler"
+#endif
+
+static ufbgc_environment run_environment;
+
+const ufbgc_environment * ufbgc_get_environment(){
+    return &run_environment;
+}
+
+static size_t ufbgc_online_cpus(){
+    #ifdef UFBGC_POSIX
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        return cpus > 0 ? (size_t) cpus : 1;
+    #else
+        return 1;
+    #endif
+}
+
+static int ufbgc_current_cpu(){
+    #ifdef __linux__
+        return sched_getcpu();
+    #else
+        return -1;
+    #endif
+}
+
+//Appends to a comma separated list, output is cut at the end of dest
+static void ufbgc_list_append(char * dest, size_t size, size_t * len, const char * format, ...){
+    if(*len + 1 >= size){
+        return;
+    }
+    if(*len > 0){
+        *len += (size_t) snprintf(dest + *len,size - *len,", ");
+    }
+    va_list args;
+    va_start(args,format);
+    int written = *len + 1 < size ? vsnprintf(dest + *len,size - *len,format,args) : 0;
+    va_end(args);
+    *len += written > 0 ? (size_t) written : 0;
+    if(*len >= size){
+        *len = size - 1;
+    }
+}
+
+//First line of a system file without the new line, false if it can't be read
+static bool ufbgc_read_line(const char * path, char * dest, size_t size){
+    FILE * fl = fopen(path,"r");
+    if(fl == NULL){
+        return false;
+    }
+    bool ok = fgets(dest,(int) size,fl) != NULL;
+    fclose(fl);
+    if(ok){
+        dest[strcspn(dest,"\n")] = '\0';
+    }
+    return ok;
+}
+
+static void ufbgc_copy_trimmed(char * dest, size_t size, const char * str){
+    while(*str == ' ' || *str == '\t'){
+        str++;
+    }
+    size_t len = strcspn(str,"\n");
+    while(len > 0 && (str[len - 1] == ' ' || str[len - 1] == '\t')){
+        len--;
+    }
+    snprintf(dest,size,"%.*s",(int) len,str);
+}
+
+static void ufbgc_cpu_model(char * dest, size_t size){
+    snprintf(dest,size,"unknown CPU");
+    #if defined(__x86_64__) || defined(__i386__)
+        unsigned regs[13];
+        if(__get_cpuid_max(0x80000000,NULL) >= 0x80000004){
+            for(unsigned i = 0; i < 3; ++i){
+                __get_cpuid(0x80000002 + i,&regs[i * 4],&regs[i * 4 + 1],&regs[i * 4 + 2],&regs[i * 4 + 3]);
+            }
+            regs[12] = 0;
+            ufbgc_copy_trimmed(dest,size,(const char *) regs);
+            return;
+        }
+    #endif
+    FILE * fl = fopen("/proc/cpuinfo","r");
+    if(fl == NULL){
+        return;
+    }
+    char line[256];
+    while(fgets(line,sizeof(line),fl) != NULL){
+        const char * colon = strchr(line,':');
+        if(colon != NULL && (!strncmp(line,"model name",10) || !strncmp(line,"Hardware",8))){
+            ufbgc_copy_trimmed(dest,size,colon + 1);
+            break;
+        }
+    }
+    fclose(fl);
+}
+
+static bool ufbgc_cpu_governor(int cpu, char * dest, size_t size){
+    char path[96];
+    snprintf(path,sizeof(path),"/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor",cpu < 0 ? 0 : cpu);
+    return ufbgc_read_line(path,dest,size);
+}
+
+//Hardware threads sharing the core of cpu, false if the core has only one
+static bool ufbgc_cpu_siblings(int cpu, char * dest, size_t size){
+    char path[96];
+    snprintf(path,sizeof(path),"/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",cpu < 0 ? 0 : cpu);
+    return ufbgc_read_line(path,dest,size) && strpbrk(dest,",-") != NULL;
+}
+
+static bool ufbgc_turbo_enabled(){
+    char value[16];
+    if(ufbgc_read_line("/sys/devices/system/cpu/intel_pstate/no_turbo",value,sizeof(value))){
+        return value[0] == '0';
+    }
+    return ufbgc_read_line("/sys/devices/system/cpu/cpufreq/boost",value,sizeof(value)) && value[0] == '1';
+}
+
+//One minute load average, negative if it is unknown
+static double ufbgc_load_average(){
+    char value[128];
+    double load;
+    if(!ufbgc_read_line("/proc/loadavg",value,sizeof(value)) || sscanf(value,"%lf",&load) != 1){
+        return -1;
+    }
+    return load;
+}
+
+static void ufbgc_collect_environment(ufbgc_environment * env){
+    memset(env,0,sizeof(*env));
+    ufbgc_cpu_model(env->cpu_model,sizeof(env->cpu_model));
+    env->online_cpus = ufbgc_online_cpus();
+    snprintf(env->kernel,sizeof(env->kernel),"unknown kernel");
+    #ifdef UFBGC_POSIX
+        struct utsname name;
+        if(uname(&name) == 0){
+            snprintf(env->kernel,sizeof(env->kernel),"%.32s %.64s %.24s",name.sysname,name.release,name.machine);
+        }
+    #endif
+    if(!ufbgc_cpu_governor(ufbgc_current_cpu(),env->governor,sizeof(env->governor))){
+        env->governor[0] = '\0';
+    }
+    snprintf(env->compiler,sizeof(env->compiler),"%s",UFBGC_COMPILER);
+    snprintf(env->compile_flags,sizeof(env->compile_flags),"%s",UFBGC_COMPILE_FLAGS);
+}
+
+//Frames whose timings are compared or counted, the noise check runs before them
+static bool ufbgc_perf_sensitive(const ufbgc_test_frame * tframe){
+    return (tframe->option & (BENCHMARK_TEST | PERF_COUNTERS)) || runner_options.perf_counters || runner_options.baseline_path != NULL ||
+        tframe->budget.wall_ms > 0 || tframe->budget.cpu_ms > 0;
+}
+
+/*
+    Noise sources of the CPU the calling thread runs on as a comma separated list, false if there is none
+    Load average is noise when there are more runnable tasks than the workers of the run and one more
+*/
+static bool ufbgc_check_noise(char * dest, size_t size){
+    int cpu = ufbgc_current_cpu();
+    size_t len = 0;
+    char value[64];
+    dest[0] = '\0';
+    if(ufbgc_cpu_governor(cpu,value,sizeof(value)) && strcmp(value,"performance") != 0){
+        ufbgc_list_append(dest,size,&len,"governor '%s'",value);
+    }
+    if(ufbgc_turbo_enabled()){
+        ufbgc_list_append(dest,size,&len,"turbo boost");
+    }
+    if(ufbgc_cpu_siblings(cpu,value,sizeof(value))){
+        ufbgc_list_append(dest,size,&len,"SMT siblings %s",value);
+    }
+    size_t workers = runner_options.processes > runner_options.threads ? runner_options.processes : runner_options.threads;
+    double load = ufbgc_load_average();
+    if(load > (double)(workers > 1 ? workers : 1) + 1.0){
+        ufbgc_list_append(dest,size,&len,"load average %.2f",load);
+    }
+    return len > 0;
+}
+
+#ifdef __linux__
+typedef struct{
+    cpu_set_t affinity;
+    bool affinity_saved;
+    int policy;
+    struct sched_param param;
+    int nice;
+}internal_ufbgc_runner_policy;
+
+//Worker N of a run is pinned to the Nth CPU of the list, SIZE_MAX allows every CPU of the list, returns an error number
+static int ufbgc_pin_worker(size_t worker){
+    if(runner_options.no_pin_cpus == 0){
+        return 0;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(size_t i = 0; i < runner_options.no_pin_cpus; ++i){
+        if(worker == SIZE_MAX || i == worker % runner_options.no_pin_cpus){
+            CPU_SET(runner_options.pin_cpus[i],&set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(),sizeof(set),&set);
+}
+
+//Runner thread is set up before the first frame, worker threads and processes inherit the policy and the nice value
+static void ufbgc_apply_runner_policy(internal_ufbgc_runner_policy * saved){
+    saved->affinity_saved = pthread_getaffinity_np(pthread_self(),sizeof(saved->affinity),&saved->affinity) == 0;
+    pthread_getschedparam(pthread_self(),&saved->policy,&saved->param);
+    errno = 0;
+    saved->nice = getpriority(PRIO_PROCESS,0);
+
+    //Linux sets the nice value of the calling thread
+    if(runner_options.nice_given && setpriority(PRIO_PROCESS,0,runner_options.nice) != 0){
+        ufbgc_print_yellow(stdout,"ufbgc - can't set nice %d: %s\n",runner_options.nice,strerror(errno));
+    }
+    if(runner_options.fifo_priority > 0){
+        struct sched_param param;
+        memset(&param,0,sizeof(param));
+        param.sched_priority = runner_options.fifo_priority;
+        int sched_error = pthread_setschedparam(pthread_self(),SCHED_FIFO,&param);
+        if(sched_error != 0){
+            ufbgc_print_yellow(stdout,"ufbgc - can't use SCHED_FIFO priority %d: %s\n",runner_options.fifo_priority,strerror(sched_error));
+        }
+    }
+    for(size_t i = 0; i < runner_options.no_pin_cpus; ++i){
+        if(saved->affinity_saved && !CPU_ISSET(runner_options.pin_cpus[i],&saved->affinity)){
+            ufbgc_print_yellow(stdout,"ufbgc - cpu %d is not available to the run\n",runner_options.pin_cpus[i]);
+        }
+    }
+    int error = ufbgc_pin_worker(0);
+    if(error != 0){
+        ufbgc_print_yellow(stdout,"ufbgc - can't pin the runner to cpu %d: %s\n",runner_options.pin_cpus[0],strerror(error));
+    }
+}
+
+static void ufbgc_restore_runner_policy(const internal_ufbgc_runner_policy * saved){
+    if(runner_options.fifo_priority > 0){
+        pthread_setschedparam(pthread_self(),saved->policy,&saved->param);
+    }
+    if(runner_options.nice_given){
+        setpriority(PRIO_PROCESS,0,saved->nice);
+    }
+    if(runner_options.no_pin_cpus > 0 && saved->affinity_saved){
+        pthread_setaffinity_np(pthread_self(),sizeof(saved->affinity),&saved->affinity);
+    }
+}
+#endif
+
+
+/*
+    Budgets are checked after the test function of an iteration passed, exceeded ones make it [OVER BUDGET]
+    Peak RSS is process wide, frames running next to each other in --jobs share it
+*/
+static double ufbgc_frame_deadline(const ufbgc_test_frame * tframe){
+    return tframe->budget.deadline_ms > 0 ? tframe->budget.deadline_ms : (double) runner_options.timeout_ms;
+}
+
+//Size budgets are checked when they are not 0 or when their UFBGC_BUDGET_* flag is set in checked
+static bool ufbgc_budget_checked(const ufbgc_budget * budget, size_t limit, unsigned flag){
+    return limit != 0 || (budget->checked & flag);
+}
+
+#ifdef __linux__
+//Resident set size and its peak of the process in bytes from /proc/self/status
+static bool ufbgc_rss_read(size_t * rss, size_t * peak){
+    char status[4096];
+    int fd = open("/proc/self/status",O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    ssize_t len = read(fd,status,sizeof(status) - 1);
+    close(fd);
+    if(len <= 0){
+        return false;
+    }
+    status[len] = '\0';
+    const char * vm_rss = strstr(status,"VmRSS:");
+    const char * vm_hwm = strstr(status,"VmHWM:");
+    if(vm_rss == NULL || vm_hwm == NULL){
+        return false;
+    }
+    *rss = (size_t) strtoull(vm_rss + 6,NULL,10) * 1024;
+    *peak = (size_t) strtoull(vm_hwm + 6,NULL,10) * 1024;
+    return true;
+}
+
+//Peak is reset to the current RSS (Linux 4.0), otherwise only growth over the earlier peak is seen
+static bool ufbgc_rss_start(size_t * base){
+    int fd = open("/proc/self/clear_refs",O_WRONLY);
+    bool reset = fd >= 0 && write(fd,"5",1) == 1;
+    if(fd >= 0){
+        close(fd);
+    }
+    size_t rss, peak;
+    if(!ufbgc_rss_read(&rss,&peak)){
+        return false;
+    }
+    *base = reset ? rss : peak;
+    return true;
+}
+
+static size_t ufbgc_rss_growth(size_t base){
+    size_t rss, peak;
+    return ufbgc_rss_read(&rss,&peak) && peak > base ? peak - base : 0;
+}
+#else
+static bool ufbgc_rss_start(size_t * base){
+    *base = 0;
+    return false;
+}
+
+static size_t ufbgc_rss_growth(size_t base){
+    (void) base;
+    return 0;
+}
+#endif
+
+//Exceeded budgets of an iteration as a comma separated list, false if it is within its budget
+//Times of a benchmark are the ones of an operation
+static bool ufbgc_check_budget(const ufbgc_test_frame * tframe, double wall_ns, double cpu_ns, const ufbgc_alloc_stats * allocs,
+    const size_t * rss_growth, char * dest, size_t size){
+    const ufbgc_budget * budget = &tframe->budget;
+    const char * per_op = (tframe->option & BENCHMARK_TEST) ? " per op" : "";
+    char value[32], limit[32];
+    size_t len = 0;
+    dest[0] = '\0';
+    if(budget->wall_ms > 0 && wall_ns > budget->wall_ms * 1e6){
+        ufbgc_list_append(dest,size,&len,"wall %s > %s%s",ufbgc_format_ns(wall_ns,value,sizeof(value)),
+            ufbgc_format_ns(budget->wall_ms * 1e6,limit,sizeof(limit)),per_op);
+    }
+    if(budget->cpu_ms > 0 && cpu_ns > budget->cpu_ms * 1e6){
+        ufbgc_list_append(dest,size,&len,"cpu %s > %s%s",ufbgc_format_ns(cpu_ns,value,sizeof(value)),
+            ufbgc_format_ns(budget->cpu_ms * 1e6,limit,sizeof(limit)),per_op);
+    }
+    //Budget which can't be measured is not met, e.g. allocations without the tracker
+    if(ufbgc_budget_checked(budget,budget->allocs,UFBGC_BUDGET_ALLOCS)){
+        if(allocs == NULL){
+            ufbgc_list_append(dest,size,&len,"allocs budget cannot be verified");
+        }
+        else if(allocs->allocations > budget->allocs){
+            ufbgc_list_append(dest,size,&len,"allocs %lu > %lu",(unsigned long) allocs->allocations,(unsigned long) budget->allocs);
+        }
+    }
+    if(ufbgc_budget_checked(budget,budget->rss_growth,UFBGC_BUDGET_RSS_GROWTH)){
+        if(rss_growth == NULL){
+            ufbgc_list_append(dest,size,&len,"rss budget cannot be verified");
+        }
+        else if(*rss_growth > budget->rss_growth){
+            ufbgc_list_append(dest,size,&len,"rss +%s > %s",ufbgc_format_bytes((double) *rss_growth,value,sizeof(value)),
+                ufbgc_format_bytes((double) budget->rss_growth,limit,sizeof(limit)));
+        }
+    }
+    return len > 0;
+}
+
+static ufbgc_return_t ufbgc_run_stress(const ufbgc_test_frame * tframe, void * user_arg, FILE * out, uint64_t * threads_cpu_ns);
+
+/*
+    Runs every iteration of a single frame and prints the results into out
+    Result of the frame is failed if any of its iterations fails, execution time is the sum of the iterations
+*/
+static void ufbgc_run_frame(const ufbgc_test_frame * tframe, FILE * out, bool colored, internal_ufbgc_test_result * result){
+
+    result->tframe = tframe;
+    result->test_result = UFBGC_OK;
+    result->execution_time = 0;
+    result->cpu_time = 0;
+    result->cycles = 0;
+    result->regression = 0;
+    result->allocs_tracked = false;
+    memset(&result->allocs,0,sizeof(result->allocs));
+    memset(&result->throughput,0,sizeof(result->throughput));
+    result->over_budget = false;
+    result->timed_out = false;
+
+    current_test_frame.frame = tframe;
+    current_test_frame.frame_iterator = 0;
+    current_test_frame.frame_iterateable = false;
+    current_test_frame.output_file = out;
+    current_test_frame.colored_output = colored;
+    current_test_frame.used_golden = false;
+
+    //Passing assertions of every running test check this counter only
+    bool report_passes = tframe->log_level >= UFBGC_LOG_INFO;
+    if(report_passes){
+        __atomic_add_fetch(&ufbgc_pass_reporting,1,__ATOMIC_RELAXED);
+    }
+
+    struct tm current_time;
+    ufbgc_get_current_time(&current_time);
+    char time_str[64];
+    strftime(time_str,sizeof(time_str),"%c\n",&current_time);
+
+    ufbgc_print_cyan(out,"Starting test : '%s' @ %s",tframe->name ? tframe->name : "NULL" ,time_str);
+
+    char noise[256] = "";
+    if(!(tframe->option & PASS_TEST) && !result->cached && tframe->test_f != NULL && ufbgc_perf_sensitive(tframe) && ufbgc_check_noise(noise,sizeof(noise))){
+        ufbgc_print_yellow(out,"'%s'\t\t\ttimings are noisy: %s\n",tframe->name,noise);
+    }
+
+    char budget_message[256] = "";     //Exceeded budgets of the first iteration which is over budget
+
+    ufbgc_event event;
+    memset(&event,0,sizeof(event));
+    event.type = UFBGC_EVENT_TEST_START;
+    event.test = tframe->name;
+    event.message = noise;
+    ufbgc_emit_event(&event);
+
+    if(tframe->option & PASS_TEST){
+        ufbgc_print_yellow(out,"'%s'\t\t\t%-10s\n",tframe->name,"[PASS]");
+    }
+    else if(result->cached){
+        ufbgc_print_cyan(out,"'%s'\t\t\t%-10s key %016llx\n",tframe->name,"[CACHED]",(unsigned long long) result->cache_key);
+    }
+    else if(tframe->test_f != NULL){
+        //Generated frames iterate until the generator is exhausted, others until no_iteration
+        bool generated = tframe->generator != NULL;
+        bool next_iteration = true;
+        if(generated){
+            next_iteration = ufbgc_gen_start(&current_test_frame,tframe->generator,out);
+            current_test_frame.frame_iterateable = true;
+            if(!next_iteration && !ufbgc_gen_failed(&current_test_frame)){
+                ufbgc_print_yellow(out,"'%s'\t\t\tgenerator has no values\n",tframe->name);
+            }
+        }
+        if(tframe->parameters != NULL){
+            current_test_frame.frame_iterateable = true;
+        }
+        if(current_test_frame.frame_iterateable){
+            ufbgc_param_index_build(&current_test_frame.params,tframe->parameters,current_test_frame.gen_nodes,current_test_frame.no_gen_nodes);
+        }
+
+        internal_ufbgc_perf_session perf_session;
+        bool perf_enabled = (tframe->option & PERF_COUNTERS) || runner_options.perf_counters;
+        if(perf_enabled && !ufbgc_perf_open(&perf_session)){
+            ufbgc_print_yellow(out,"Performance counters are not available (%s), time only\n",strerror(perf_session.error));
+            perf_enabled = false;
+        }
+        internal_ufbgc_profiler profiler;
+        bool profile_enabled = (tframe->option & PROFILE_STACKS) || runner_options.profile;
+        if(profile_enabled && (tframe->option & STRESS_TEST)){
+            ufbgc_print_yellow(out,"Stress frames are not profiled\n");
+            profile_enabled = false;
+        }
+        if(profile_enabled && !ufbgc_profile_open(&profiler)){
+            ufbgc_print_yellow(out,"Profiler is not available (%s)\n",strerror(profiler.error));
+            profile_enabled = false;
+        }
+
+        bool track_allocs = (tframe->option & TRACK_ALLOCS) || runner_options.track_allocs ||
+            ufbgc_budget_checked(&tframe->budget,tframe->budget.allocs,UFBGC_BUDGET_ALLOCS);
+        #ifndef UFBGC_ALLOC_TRACKER
+            if(track_allocs){
+                ufbgc_print_yellow(out,"Allocation tracking is not available in this build\n");
+                track_allocs = false;
+            }
+        #endif
+        result->allocs_tracked = track_allocs;
+
+        bool check_rss = ufbgc_budget_checked(&tframe->budget,tframe->budget.rss_growth,UFBGC_BUDGET_RSS_GROWTH);
+        #ifndef __linux__
+            if(check_rss){
+                ufbgc_print_yellow(out,"Peak RSS is not available on this platform, RSS budget cannot be verified\n");
+            }
+        #endif
+        double deadline_ms = ufbgc_frame_deadline(tframe);
+        #ifndef UFBGC_POSIX
+            if(deadline_ms > 0){
+                ufbgc_print_yellow(out,"Watchdog is not available on this platform, deadline is not enforced\n");
+            }
+        #endif
+
+        while(next_iteration){
+            #ifdef UFBGC_POSIX
+                ufbgc_isolated_iteration_start(current_test_frame.frame_iterator);
+                if(deadline_ms > 0){
+                    ufbgc_watchdog_arm(tframe,current_test_frame.frame_iterator,deadline_ms,colored);
+                }
+            #endif
+            internal_ufbgc_alloc_tracker alloc_tracker;
+            if(track_allocs){
+                ufbgc_alloc_attach(&alloc_tracker);
+            }
+            ufbgc_seed_random(ufbgc_iteration_seed(tframe->name,current_test_frame.frame_iterator));
+            current_test_frame.no_histograms = 0;
+            current_test_frame.bytes_processed = 0;
+            current_test_frame.items_processed = 0;
+            if(current_test_frame.frame_iterateable){
+                ufbgc_print_blue(out,"Iteration : %lu",current_test_frame.frame_iterator);
+                ufbgc_gen_print_values(out,&current_test_frame);
+                ufbgc_print_blue(out,"\n");
+            }
+
+            void * user_arg = NULL;
+
+            if(tframe->setup_f != NULL){
+                ufbgc_alloc_set_phase(UFBGC_ALLOC_PHASE_SETUP);
+                tframe->setup_f(tframe->parameters, &user_arg);
+                ufbgc_alloc_set_phase(UFBGC_ALLOC_PHASE_NONE);
+            }
+
+            ufbgc_return_t test_result;
+            uint64_t stress_cpu_ns = 0;
+            double * bench_samples = NULL;
+            size_t no_bench_samples = 0;
+            internal_ufbgc_perf_values perf_values;
+            size_t rss_base = 0;
+            bool rss_measured = check_rss && ufbgc_rss_start(&rss_base);
+            if(profile_enabled){
+                ufbgc_profile_start(&profiler);
+            }
+            if(perf_enabled){
+                ufbgc_perf_start(&perf_session);
+            }
+            ufbgc_timer_start(&current_test_frame.test_timer);
+            if(tframe->option & BENCHMARK_TEST){
+                test_result = ufbgc_run_benchmark(tframe,user_arg,&result->bench,&bench_samples,&no_bench_samples);
+                result->benchmarked = test_result == UFBGC_OK;
+            }
+            else if(tframe->option & STRESS_TEST){
+                test_result = ufbgc_run_stress(tframe,user_arg,out,&stress_cpu_ns);
+            }
+            else{
+                ufbgc_alloc_set_phase(UFBGC_ALLOC_PHASE_TEST);
+                ufbgc_profile_enter((uintptr_t) __builtin_frame_address(0));
+                test_result = tframe->test_f(tframe->parameters,user_arg);
+                ufbgc_profile_leave();
+                ufbgc_alloc_set_phase(UFBGC_ALLOC_PHASE_NONE);
+            }
+            ufbgc_timer_stop(&current_test_frame.test_timer);
+            //Runner thread of a stress frame only waits, CPU time of the frame is the time of its threads
+            current_test_frame.test_timer.elapsed.cpu_ns += stress_cpu_ns;
+            if(perf_enabled){
+                ufbgc_perf_stop(&perf_session,&perf_values);
+                ufbgc_perf_accumulate(&result->perf,&perf_values);
+            }
+            if(profile_enabled){
+                ufbgc_profile_stop(&profiler);
+            }
+            size_t rss_growth = rss_measured ? ufbgc_rss_growth(rss_base) : 0;
+
+            const ufbgc_time_sample * elapsed = &current_test_frame.test_timer.elapsed;
+            double execution_time = (double) elapsed->wall_ns / 1e6;
+            result->execution_time += execution_time;
+            result->cpu_time += (double) elapsed->cpu_ns / 1e6;
+            result->cycles += elapsed->cycles;
+
+            int iteration_regression = 0;
+            bool iteration_over_budget = false;
+            char iteration_budget[256] = "";
+            if(test_result == UFBGC_OK){
+                //Benchmarks set the work of one operation, it is done in the median time of an operation
+                internal_ufbgc_throughput throughput;
+                memset(&throughput,0,sizeof(throughput));
+                ufbgc_throughput_add(&throughput,current_test_frame.bytes_processed,current_test_frame.items_processed,
+                    bench_samples != NULL ? result->bench.median : (double) elapsed->wall_ns);
+                result->throughput.bytes += throughput.bytes;
+                result->throughput.bytes_ns += throughput.bytes_ns;
+                result->throughput.items += throughput.items;
+                result->throughput.items_ns += throughput.items_ns;
+
+                //Benchmarks are held to their budget per operation
+                iteration_over_budget = ufbgc_check_budget(tframe,bench_samples != NULL ? result->bench.median : (double) elapsed->wall_ns,
+                    bench_samples != NULL ? result->bench.cpu_mean : (double) elapsed->cpu_ns,
+                    track_allocs ? &alloc_tracker.test : NULL,rss_measured ? &rss_growth : NULL,iteration_budget,sizeof(iteration_budget));
+                const char * color = iteration_over_budget ? ANSI_COLOR_RED : ANSI_COLOR_GREEN;
+                ufbgc_print_colored(out,color,"'%s'\t\t\t%-10s %gms",tframe->name,iteration_over_budget ? "[OVER BUDGET]" : "[OK]",execution_time);
+                ufbgc_print_time_details(out,color,elapsed->cpu_ns,elapsed->cycles,&throughput);
+                if(iteration_over_budget){
+                    ufbgc_print_red(out,"  over budget: %s\n",iteration_budget);
+                    if(!result->over_budget){
+                        snprintf(budget_message,sizeof(budget_message),"%s @ iteration %lu",iteration_budget,current_test_frame.frame_iterator);
+                    }
+                    result->over_budget = true;
+                }
+                if(perf_enabled){
+                    ufbgc_print_perf_values(out,ANSI_COLOR_GREEN,"  ",&perf_values,"\n");
+                }
+                if(tframe->option & BENCHMARK_TEST){
+                    ufbgc_print_bench_stats(out,&result->bench);
+                }
+                ufbgc_print_histograms(out,&current_test_frame);
+
+                //Benchmarks are compared per operation, other tests by their wall time
+                if(runner_options.baseline_path != NULL){
+                    double wall_ns = (double) elapsed->wall_ns;
+                    const double * samples = bench_samples != NULL ? bench_samples : &wall_ns;
+                    size_t no_samples = bench_samples != NULL ? no_bench_samples : 1;
+                    iteration_regression = ufbgc_check_regression(out,tframe->name,current_test_frame.frame_iterator,samples,no_samples);
+                    if(iteration_regression > 0 || (iteration_regression < 0 && result->regression == 0)){
+                        result->regression = iteration_regression;
+                    }
+                    ufbgc_collect_samples(tframe->name,current_test_frame.frame_iterator,samples,no_samples);
+                }
+            }
+            else{
+                ufbgc_print_red(out,"'%s'\t\t\t%-10s\n",tframe->name,"[FAILED]");
+                ufbgc_print_histograms(out,&current_test_frame);
+                if(thread_random.used){
+                    ufbgc_print_yellow(out,"Random seed of the iteration 0x%016llx, repeat with --seed=0x%016llx\n",
+                        (unsigned long long) thread_random.seed,(unsigned long long) runner_options.seed);
+                }
+                result->test_result = UFBGC_FAIL;
+            }
+            free(bench_samples);
+            result->used_random = result->used_random || thread_random.used;
+
+            if(profile_enabled && profiler.samples == 0){
+                ufbgc_print_white(out,"  profile has no samples, test function ran shorter than a sample period\n");
+            }
+            else if(profile_enabled){
+                char profile_path[512];
+                if(ufbgc_profile_write(&profiler,tframe->name,current_test_frame.frame_iterator,profile_path,sizeof(profile_path))){
+                    ufbgc_print_white(out,"  profile %llu samples",(unsigned long long) profiler.samples);
+                    if(profiler.dropped > 0){
+                        ufbgc_print_yellow(out," (%llu dropped, table is full)",(unsigned long long) profiler.dropped);
+                    }
+                    ufbgc_print_white(out," -> %s\n",profile_path);
+                }
+                else{
+                    ufbgc_print_red(out,"Can't write profile '%s'\n",profile_path);
+                }
+            }
+
+            if(tframe->teardown_f != NULL){
+                ufbgc_alloc_set_phase(UFBGC_ALLOC_PHASE_TEARDOWN);
+                tframe->teardown_f(tframe->parameters, user_arg);
+                ufbgc_alloc_set_phase(UFBGC_ALLOC_PHASE_NONE);
+            }
+
+            if(track_allocs){
+                ufbgc_alloc_stats iteration_allocs = alloc_tracker.total;
+                ufbgc_alloc_detach(&alloc_tracker);
+                ufbgc_print_alloc_stats(out,test_result == UFBGC_OK ? ANSI_COLOR_GREEN : ANSI_COLOR_RED,"  ",&iteration_allocs,"\n");
+                ufbgc_alloc_accumulate(&result->allocs,&iteration_allocs);
+            }
+
+            #ifdef UFBGC_POSIX
+                ufbgc_watchdog_disarm();
+            #endif
+
+            memset(&event,0,sizeof(event));
+            event.type = UFBGC_EVENT_ITERATION_END;
+            event.test = tframe->name;
+            event.iteration = current_test_frame.frame_iterator;
+            event.status = test_result != UFBGC_OK ? UFBGC_STATUS_FAILED : iteration_over_budget ? UFBGC_STATUS_OVER_BUDGET :
+                iteration_regression > 0 ? UFBGC_STATUS_REGRESSED : UFBGC_STATUS_OK;
+            event.message = iteration_budget;
+            event.wall_ms = execution_time;
+            event.cpu_ms = (double) elapsed->cpu_ns / 1e6;
+            event.cycles = elapsed->cycles;
+            ufbgc_emit_event(&event);
+
+            current_test_frame.frame_iterator++;
+            next_iteration = current_test_frame.frame_iterateable && (generated ? ufbgc_gen_advance(current_test_frame.gen_nodes,0,out) :
+                current_test_frame.frame_iterator < tframe->parameters->no_iteration);
+        }
+
+        if(generated){
+            if(ufbgc_gen_failed(&current_test_frame)){
+                ufbgc_print_red(out,"'%s'\t\t\t%-10s\n",tframe->name,"[FAILED]");
+                result->test_result = UFBGC_FAIL;
+            }
+            ufbgc_gen_stop(&current_test_frame);
+        }
+        if(perf_enabled){
+            ufbgc_perf_close(&perf_session);
+        }
+        if(profile_enabled){
+            ufbgc_profile_close(&profiler);
+        }
+        ufbgc_param_index_free(&current_test_frame.params);
+    }
+
+    ufbgc_print_magenta(out,"------------------------------------------------------------\n");
+
+    memset(&event,0,sizeof(event));
+    event.type = UFBGC_EVENT_TEST_END;
+    event.test = tframe->name;
+    event.iteration = current_test_frame.frame_iterator;
+    event.status = (tframe->option & PASS_TEST) ? UFBGC_STATUS_SKIPPED : result->cached ? UFBGC_STATUS_CACHED : result->test_result != UFBGC_OK ? UFBGC_STATUS_FAILED :
+        result->over_budget ? UFBGC_STATUS_OVER_BUDGET : result->regression > 0 ? UFBGC_STATUS_REGRESSED : UFBGC_STATUS_OK;
+    event.message = budget_message;
+    event.wall_ms = result->execution_time;
+    event.cpu_ms = result->cpu_time;
+    event.cycles = result->cycles;
+    ufbgc_emit_event(&event);
+
+    if(report_passes){
+        __atomic_sub_fetch(&ufbgc_pass_reporting,1,__ATOMIC_RELAXED);
+    }
+    ufbgc_fixtures_release(tframe);
+    result->used_golden = current_test_frame.used_golden;
+    current_test_frame.frame = NULL;
+    current_test_frame.frame_iterator = 0;
+    current_test_frame.frame_iterateable = false;
+    current_test_frame.output_file = NULL;
+    current_test_frame.colored_output = false;
+}
+
+//A run fails when a test fails, crashes, times out, exceeds its budget or regresses against the baseline
+static bool ufbgc_result_failed(const internal_ufbgc_test_result * result){
+    if(result->tframe == NULL || (result->tframe->option & PASS_TEST)){
+        return false;
+    }
+    return result->crashed || result->timed_out || result->test_result != UFBGC_OK || result->over_budget || result->regression > 0;
+}
+
+static void ufbgc_print_summary(const internal_ufbgc_test_result * results, size_t len){
+    ufbgc_print_magenta(stdout,"ufbgc - tests summary:\n");
+    for(size_t i = 0; i<len; ++i){
+        const ufbgc_test_frame * tframe = results[i].tframe;
+        if(tframe == NULL) continue;
+        int test_name_len = (int)strlen(tframe->name);
+        int right_row = 50;
+
+        if(tframe->option & PASS_TEST){
+            ufbgc_print_yellow(stdout,"'%s'%*s\n",tframe->name,right_row-test_name_len,"[PASS]");
+            continue;
+        }
+        if(results[i].cached){
+            ufbgc_print_cyan(stdout,"'%s'%*s\n",tframe->name,right_row-test_name_len,"[CACHED]");
+            continue;
+        }
+        if(results[i].timed_out){
+            ufbgc_print_red(stdout,"'%s'%*s (deadline %g ms)\n",tframe->name,right_row-test_name_len,"[TIMEOUT]",ufbgc_frame_deadline(tframe));
+        }
+        else if(results[i].crashed){
+            ufbgc_print_red(stdout,"'%s'%*s (%s %d)\n",tframe->name,right_row-test_name_len,"[CRASHED]",
+                results[i].crash_signal ? "signal" : "exit status",results[i].crash_signal ? results[i].crash_signal : results[i].exit_status);
+        }
+        else if(results[i].test_result == UFBGC_OK){
+            const char * color = ANSI_COLOR_GREEN;
+            const char * status = "[OK]";
+            if(results[i].over_budget){
+                color = ANSI_COLOR_RED;
+                status = "[OVER BUDGET]";
+            }
+            else if(results[i].regression > 0){
+                color = ANSI_COLOR_RED;
+                status = "[REGRESSED]";
+            }
+            else if(results[i].regression < 0){
+                color = ANSI_COLOR_CYAN;
+                status = "[IMPROVED]";
+            }
+            ufbgc_print_colored(stdout,color,"'%s'%*s (%g ms, cpu %g ms",tframe->name,right_row-test_name_len,status,results[i].execution_time,results[i].cpu_time);
+            if(results[i].cycles > 0){
+                ufbgc_print_colored(stdout,color,", %llu cycles",(unsigned long long) results[i].cycles);
+            }
+            if(results[i].benchmarked){
+                char median[32];
+                ufbgc_print_colored(stdout,color,", median %s/op",ufbgc_format_ns(results[i].bench.median,median,sizeof(median)));
+            }
+            ufbgc_print_throughput(stdout,color,&results[i].throughput);
+            if(results[i].perf.available){
+                ufbgc_print_perf_values(stdout,color,", ",&results[i].perf,"");
+            }
+            if(results[i].allocs_tracked){
+                ufbgc_print_alloc_stats(stdout,color,", ",&results[i].allocs,"");
+            }
+            ufbgc_print_colored(stdout,color,")\n");
+        }
+        else{
+            ufbgc_print_red(stdout,"'%s'%*s\n",tframe->name,right_row-test_name_len,"[FAILED]");
+        }
+    }
+}
+
+/*
+    Log sink, output of a frame is collected in memory and written to its destination with a single write
+    Output files are opened once per run and shared by every frame which writes to the same path
+    Output of the running frame is written by a crash handler too, so a crashing test keeps its output
+*/
+typedef struct{
+    const char * path;
+    FILE * file;                    //NULL if the file can't be opened
+}internal_ufbgc_output_file;
+
+static internal_ufbgc_output_file * output_files = NULL;
+static size_t output_files_size = 0;
+static size_t output_files_len = 0;
+
+static internal_ufbgc_output_file * ufbgc_output_file_slot(const char * path){
+    size_t slot = (size_t) ufbgc_hash_bytes(0xcbf29ce484222325ull,path,strlen(path)) & (output_files_size - 1);
+    while(output_files[slot].path != NULL && strcmp(output_files[slot].path,path)){
+        slot = (slot + 1) & (output_files_size - 1);
+    }
+    return &output_files[slot];
+}
+
+//Files are opened by the main thread before the frames run, workers only look them up
+static bool ufbgc_open_output_file(const char * path){
+    if(2 * (output_files_len + 1) > output_files_size){
+        internal_ufbgc_output_file * old_files = output_files;
+        size_t old_size = output_files_size;
+        size_t size = old_size ? old_size * 2 : 16;
+        internal_ufbgc_output_file * files = (internal_ufbgc_output_file *) calloc(size,sizeof(*files));
+        if(files == NULL){
+            return false;
+        }
+        output_files = files;
+        output_files_size = size;
+        for(size_t i = 0; i < old_size; ++i){
+            if(old_files[i].path != NULL){
+                *ufbgc_output_file_slot(old_files[i].path) = old_files[i];
+            }
+        }
+        free(old_files);
+    }
+    internal_ufbgc_output_file * entry = ufbgc_output_file_slot(path);
+    if(entry->path == NULL){
+        entry->path = path;
+        entry->file = fopen(path,"a");
+        output_files_len++;
+    }
+    return entry->file != NULL;
+}
+
+static FILE * ufbgc_get_output_file(const char * path){
+    if(output_files_size == 0){
+        return NULL;
+    }
+    return ufbgc_output_file_slot(path)->file;
+}
+
+static void ufbgc_close_output_files(){
+    for(size_t i = 0; i < output_files_size; ++i){
+        if(output_files[i].file != NULL){
+            fclose(output_files[i].file);
+        }
+    }
+    free(output_files);
+    output_files = NULL;
+    output_files_size = 0;
+    output_files_len = 0;
+}
+
+//Destination of a frame, stdout or its output file
+static FILE * ufbgc_frame_destination(const ufbgc_test_frame * tframe){
+    return tframe->output_file != NULL ? ufbgc_get_output_file(tframe->output_file) : stdout;
+}
+
+#ifdef UFBGC_POSIX
+static bool ufbgc_write_all(int fd, const void * data, size_t size){
+    const char * p = (const char *) data;
+    while(size > 0){
+        ssize_t n = write(fd,p,size);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= (size_t) n;
+    }
+    return true;
+}
+#endif
+
+//Appends buffered output of a frame to its destination with one write
+static void ufbgc_write_frame_output(const ufbgc_test_frame * tframe, const char * output, size_t output_size){
+    FILE * out = ufbgc_frame_destination(tframe);
+    if(out == NULL || output == NULL || output_size == 0){
+        return;
+    }
+    #ifdef UFBGC_POSIX
+        fflush(out);
+        ufbgc_write_all(fileno(out),output,output_size);
+    #else
+        fwrite(output,1,output_size,out);
+        fflush(out);
+    #endif
+}
+
+#ifdef UFBGC_COOKIE_STREAM
+/*
+    Memory stream which grows outside of the allocation tracker, stdio buffer is allocated with the stream
+    so printing in a test never allocates and the crash handler knows where the unflushed output is
+    Output is a regular heap block and released with free() like the one of open_memstream
+*/
+#define UFBGC_OUTPUT_STDIO_BUFFER 8192
+
+typedef struct{
+    char ** output;
+    size_t * output_size;
+    size_t capacity;
+    char stdio_buffer[UFBGC_OUTPUT_STDIO_BUFFER];
+}internal_ufbgc_output_buffer;
+
+static ssize_t ufbgc_output_buffer_write(void * cookie, const char * data, size_t size){
+    internal_ufbgc_output_buffer * buffer = (internal_ufbgc_output_buffer *) cookie;
+    size_t needed = *buffer->output_size + size + 1;
+    if(needed > buffer->capacity){
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while(capacity < needed){
+            capacity *= 2;
+        }
+        char * output = (char *) ufbgc_internal_realloc(*buffer->output,capacity);
+        if(output == NULL){
+            return -1;
+        }
+        *buffer->output = output;
+        buffer->capacity = capacity;
+    }
+    memcpy(*buffer->output + *buffer->output_size,data,size);
+    (*buffer->output)[*buffer->output_size + size] = '\0';
+    *buffer->output_size += size;
+    return (ssize_t) size;
+}
+
+static int ufbgc_output_buffer_close(void * cookie){
+    ufbgc_internal_free(cookie);
+    return 0;
+}
+#endif
+
+static FILE * ufbgc_open_output_buffer(char ** output, size_t * output_size, const char ** stdio_buffer){
+    *output = NULL;
+    *output_size = 0;
+    if(stdio_buffer != NULL){
+        *stdio_buffer = NULL;
+    }
+    #ifdef UFBGC_COOKIE_STREAM
+        internal_ufbgc_output_buffer * buffer = (internal_ufbgc_output_buffer *) ufbgc_internal_malloc(sizeof(*buffer));
+        if(buffer != NULL){
+            buffer->output = output;
+            buffer->output_size = output_size;
+            buffer->capacity = 0;
+            cookie_io_functions_t functions = {NULL,ufbgc_output_buffer_write,NULL,ufbgc_output_buffer_close};
+            FILE * out = fopencookie(buffer,"w",functions);
+            if(out != NULL){
+                //Stream belongs to a single frame, stdio locking is not needed
+                setvbuf(out,buffer->stdio_buffer,_IOFBF,sizeof(buffer->stdio_buffer));
+                __fsetlocking(out,FSETLOCKING_BYCALLER);
+                if(stdio_buffer != NULL){
+                    *stdio_buffer = buffer->stdio_buffer;
+                }
+                return out;
+            }
+            ufbgc_internal_free(buffer);
+        }
+    #endif
+    #ifdef UFBGC_POSIX
+        FILE * out = open_memstream(output,output_size);
+        if(out != NULL){
+            return out;
+        }
+    #endif
+    return tmpfile();
+}
+
+#ifdef UFBGC_POSIX
+/*
+    Output of the frame running on this thread, the crash handler writes it to the destination of the frame
+    Isolated workers send it to the parent, which prints it before the [CRASHED] line
+    A frame printed directly to its destination has no output buffer, only the stdio buffer of the destination is pending
+*/
+typedef struct{
+    char * const * output;          //NULL if the frame prints directly to its destination
+    const size_t * output_size;
+    FILE * stream;                  //NULL if no frame runs on this thread
+    const char * stdio_buffer;      //Output which is not flushed into the stream yet, NULL if unknown
+    const internal_ufbgc_event_buffer * events;
+    int fd;
+}internal_ufbgc_pending_output;
+
+static UFBGC_THREAD_LOCAL internal_ufbgc_pending_output pending_output = {NULL,NULL,NULL,NULL,NULL,-1};
+
+#endif
+
+/*
+    Runs a frame into an output buffer, frame output is printed and its events are reported by the caller
+    Used by the threaded and isolated runners, whose frames finish out of list order
+*/
+static void ufbgc_run_frame_buffered(const ufbgc_test_frame * tframe, internal_ufbgc_test_result * result, char ** output, size_t * output_size,
+    internal_ufbgc_event_buffer * events){
+
+    memset(events,0,sizeof(*events));
+    current_test_frame.events = no_reporters > 0 ? events : NULL;
+
+    const char * stdio_buffer;
+    FILE * out = ufbgc_open_output_buffer(output,output_size,&stdio_buffer);
+    if(out == NULL){
+        FILE * destination = ufbgc_frame_destination(tframe);
+        ufbgc_run_frame(tframe,destination != NULL ? destination : stdout,tframe->output_file == NULL,result);
+        current_test_frame.events = NULL;
+        return;
+    }
+    #ifdef UFBGC_POSIX
+        FILE * destination = ufbgc_frame_destination(tframe);
+        pending_output.output = output;
+        pending_output.output_size = output_size;
+        pending_output.stream = out;
+        pending_output.stdio_buffer = stdio_buffer;
+        pending_output.events = current_test_frame.events;
+        pending_output.fd = destination != NULL ? fileno(destination) : -1;
+    #endif
+    ufbgc_run_frame(tframe,out,tframe->output_file == NULL,result);
+    #ifdef UFBGC_POSIX
+        pending_output.stream = NULL;
+        pending_output.output = NULL;
+    #endif
+    fclose(out);
+    current_test_frame.events = NULL;
+}
+
+/*
+    Runs a frame printing straight to its destination, so the output of the framework and printf of the test stay in order
+    Unflushed output of the destination is written by the crash handler, events are reported by the caller
+*/
+static void ufbgc_run_frame_direct(const ufbgc_test_frame * tframe, FILE * destination, internal_ufbgc_test_result * result,
+    internal_ufbgc_event_buffer * events){
+
+    memset(events,0,sizeof(*events));
+    current_test_frame.events = no_reporters > 0 ? events : NULL;
+
+    #ifdef UFBGC_POSIX
+        pending_output.output = NULL;
+        pending_output.output_size = NULL;
+        pending_output.stream = destination;
+        pending_output.stdio_buffer = NULL;
+        pending_output.events = current_test_frame.events;
+        pending_output.fd = fileno(destination);
+    #endif
+    ufbgc_run_frame(tframe,destination,tframe->output_file == NULL,result);
+    #ifdef UFBGC_POSIX
+        pending_output.stream = NULL;
+    #endif
+    fflush(destination);
+    current_test_frame.events = NULL;
+}
+
+#ifdef UFBGC_POSIX
+static bool ufbgc_run_in_worker(internal_ufbgc_test_run * run, size_t i);
+#endif
+
+static void ufbgc_run_sequential(internal_ufbgc_test_run * run){
+    for(size_t i = 0; i < run->len; ++i){
+        const ufbgc_test_frame * tframe = &run->test_list[run->indices[i]];
+
+        if(tframe->output_file != NULL && ufbgc_get_output_file(tframe->output_file) == NULL){
+            ufbgc_print_red(stdout,"Can't open file:%s\n",tframe->output_file);
+            run->results[i].tframe = tframe;
+            run->results[i].test_result = UFBGC_FAIL;
+        }
+        else{
+            //Earlier output must be out before the crash handler writes this frame
+            fflush(stdout);
+            bool ran = false;
+            #ifdef UFBGC_POSIX
+                ran = ufbgc_frame_deadline(tframe) > 0 && ufbgc_run_in_worker(run,i);
+            #endif
+            if(!ran){
+                internal_ufbgc_event_buffer events;
+                ufbgc_run_frame_direct(tframe,ufbgc_frame_destination(tframe),&run->results[i],&events);
+                ufbgc_report_events(&events);
+                ufbgc_event_buffer_free(&events);
+            }
+        }
+
+        if(runner_options.fail_fast && ufbgc_result_failed(&run->results[i])){
+            break;
+        }
+    }
+}
+
+
+#ifdef UFBGC_POSIX
+
+//Frames owned by a worker are every n_workers-th position, the owner takes from the head and thieves take from the tail
+typedef struct{
+    pthread_mutex_t lock;
+    size_t head;
+    size_t tail;
+}internal_ufbgc_work_deque;
+
+typedef struct{
+    char * output;
+    size_t output_size;
+    internal_ufbgc_event_buffer events;
+    bool started;
+    bool done;
+}internal_ufbgc_parallel_slot;
+
+typedef struct{
+    internal_ufbgc_test_run * run;
+    internal_ufbgc_parallel_slot * slots;
+    internal_ufbgc_work_deque * deques;
+    size_t n_workers;
+    bool stop;                      //Fail fast, frames which are not started yet are not run
+    pthread_mutex_t done_lock;
+    pthread_cond_t done_cond;
+}internal_ufbgc_parallel_run;
+
+typedef struct{
+    internal_ufbgc_parallel_run * prun;
+    size_t worker_id;
+    pthread_t thread;
+}internal_ufbgc_worker;
+
+static bool ufbgc_deque_pop_head(internal_ufbgc_work_deque * dq, size_t * pos){
+    bool found = false;
+    pthread_mutex_lock(&dq->lock);
+    if(dq->head < dq->tail){
+        *pos = dq->head++;
+        found = true;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static bool ufbgc_deque_steal_tail(internal_ufbgc_work_deque * dq, size_t * pos){
+    bool found = false;
+    pthread_mutex_lock(&dq->lock);
+    if(dq->head < dq->tail){
+        *pos = --dq->tail;
+        found = true;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static bool ufbgc_next_frame_position(internal_ufbgc_parallel_run * prun, size_t worker_id, size_t * pos){
+    if(ufbgc_deque_pop_head(&prun->deques[worker_id],pos)){
+        *pos = *pos * prun->n_workers + worker_id;
+        return true;
+    }
+    for(size_t i = 1; i < prun->n_workers; ++i){
+        size_t owner = (worker_id + i) % prun->n_workers;
+        if(ufbgc_deque_steal_tail(&prun->deques[owner],pos)){
+            *pos = *pos * prun->n_workers + owner;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void * ufbgc_parallel_worker(void * arg){
+    internal_ufbgc_worker * worker = (internal_ufbgc_worker *) arg;
+    internal_ufbgc_parallel_run * prun = worker->prun;
+    internal_ufbgc_test_run * run = prun->run;
+    size_t pos;
+
+    #ifdef __linux__
+        ufbgc_pin_worker(worker->worker_id);
+    #endif
+    while(ufbgc_next_frame_position(prun,worker->worker_id,&pos)){
+        const ufbgc_test_frame * tframe = &run->test_list[run->indices[pos]];
+        internal_ufbgc_parallel_slot * slot = &prun->slots[pos];
+        char * output;
+        size_t output_size;
+        internal_ufbgc_event_buffer events;
+
+        //Start is marked under the lock of the stop flag, so the main thread knows which frames it must wait for
+        pthread_mutex_lock(&prun->done_lock);
+        bool stop = prun->stop;
+        slot->started = !stop;
+        pthread_mutex_unlock(&prun->done_lock);
+        if(stop){
+            break;
+        }
+
+        //Output is kept in memory and printed by the main thread in list order
+        ufbgc_run_frame_buffered(tframe,&run->results[pos],&output,&output_size,&events);
+
+        pthread_mutex_lock(&prun->done_lock);
+        slot->output = output;
+        slot->output_size = output_size;
+        slot->events = events;
+        slot->done = true;
+        if(runner_options.fail_fast && ufbgc_result_failed(&run->results[pos])){
+            prun->stop = true;
+        }
+        pthread_cond_broadcast(&prun->done_cond);
+        pthread_mutex_unlock(&prun->done_lock);
+    }
+    return NULL;
+}
+
+static void ufbgc_run_threads(internal_ufbgc_test_run * run, size_t n_workers){
+
+    internal_ufbgc_parallel_run prun = {
+        .run = run,
+        .slots = (internal_ufbgc_parallel_slot*) calloc(run->len, sizeof(internal_ufbgc_parallel_slot)),
+        .deques = (internal_ufbgc_work_deque*) calloc(n_workers, sizeof(internal_ufbgc_work_deque)),
+        .n_workers = n_workers,
+    };
+    internal_ufbgc_worker * workers = (internal_ufbgc_worker*) calloc(n_workers, sizeof(internal_ufbgc_worker));
+    if(prun.slots == NULL || prun.deques == NULL || workers == NULL){
+        free(prun.slots);
+        free(prun.deques);
+        free(workers);
+        ufbgc_run_sequential(run);
+        return;
+    }
+
+    pthread_mutex_init(&prun.done_lock,NULL);
+    pthread_cond_init(&prun.done_cond,NULL);
+
+    //Round robin, workers start at the head of the list together, so it finishes first and output streams early
+    //and the longest frames of the longest first order are spread over the workers
+    for(size_t w = 0; w < n_workers; ++w){
+        pthread_mutex_init(&prun.deques[w].lock,NULL);
+        prun.deques[w].head = 0;
+        prun.deques[w].tail = w < run->len ? (run->len - w + n_workers - 1) / n_workers : 0;
+    }
+
+    size_t started = 0;
+    for(size_t w = 0; w < n_workers; ++w){
+        workers[w].prun = &prun;
+        workers[w].worker_id = w;
+        if(pthread_create(&workers[w].thread,NULL,ufbgc_parallel_worker,&workers[w]) != 0){
+            break;
+        }
+        started++;
+    }
+    //Frames of the workers which could not be started are stolen by the others
+    if(started == 0){
+        ufbgc_parallel_worker(&workers[0]);
+    }
+
+    for(size_t i = 0; i < run->len; ++i){
+        internal_ufbgc_parallel_slot * slot = &prun.slots[i];
+
+        pthread_mutex_lock(&prun.done_lock);
+        while(!slot->done && !(prun.stop && !slot->started)){
+            pthread_cond_wait(&prun.done_cond,&prun.done_lock);
+        }
+        pthread_mutex_unlock(&prun.done_lock);
+        if(!slot->done){
+            continue;
+        }
+
+        ufbgc_write_frame_output(&run->test_list[run->indices[i]],slot->output,slot->output_size);
+        ufbgc_report_events(&slot->events);
+        ufbgc_event_buffer_free(&slot->events);
+        free(slot->output);
+        slot->output = NULL;
+    }
+
+    for(size_t w = 0; w < started; ++w){
+        pthread_join(workers[w].thread,NULL);
+    }
+
+    for(size_t w = 0; w < n_workers; ++w){
+        pthread_mutex_destroy(&prun.deques[w].lock);
+    }
+    pthread_mutex_destroy(&prun.done_lock);
+    pthread_cond_destroy(&prun.done_cond);
+    free(workers);
+    free(prun.deques);
+    free(prun.slots);
+}
+
+
+/*
+    Isolated runs fork worker processes, each worker runs its own shard of the frames
+    and streams result records to the parent over a pipe
+    Record is a fixed header followed by payload_size bytes, frame end payload is the result of the frame and its output
+    Workers are forked from the parent, so frame pointers inside the result are valid in the parent too
+*/
+typedef enum{
+    UFBGC_RECORD_FRAME_START = 1,
+    UFBGC_RECORD_ITERATION_START,
+    UFBGC_RECORD_FRAME_END,
+    UFBGC_RECORD_SAMPLES,           //Timing samples of an iteration for the baseline
+    UFBGC_RECORD_OUTPUT,            //Output of a frame which is crashing
+    UFBGC_RECORD_EVENTS,            //Reporter events of a frame
+    UFBGC_RECORD_TIMEOUT,           //Watchdog stopped an iteration, the worker exits
+}internal_ufbgc_record_type;
+
+typedef struct{
+    uint32_t type;
+    uint32_t position;
+    uint32_t iteration;
+    uint32_t payload_size;
+}internal_ufbgc_record;
+
+typedef struct{
+    pid_t pid;
+    int fd;
+    size_t worker_id;
+    size_t * positions;         //Positions of the shard in run order
+    size_t no_positions;
+    size_t next;                //First position which is not finished yet
+    bool running_frame;         //Frame start is received but its end is not
+    size_t current_iteration;
+    bool timed_out;                 //Worker reported a timeout before it exited
+    bool direct_output;             //Worker prints its frames to their destinations, only their results are sent
+    char * crash_output;        //Output of the running frame sent by the crash handler
+    size_t crash_output_size;
+    char * buffer;
+    size_t buffer_size;
+    size_t buffer_capacity;
+}internal_ufbgc_process;
+
+static void ufbgc_send_record(int fd, uint32_t type, size_t position, size_t iteration, const internal_ufbgc_test_result * result, const char * output, size_t output_size){
+    internal_ufbgc_record record = {
+        .type = type,
+        .position = (uint32_t) position,
+        .iteration = (uint32_t) iteration,
+        .payload_size = (uint32_t)((result != NULL ? sizeof(*result) : 0) + output_size),
+    };
+    ufbgc_write_all(fd,&record,sizeof(record));
+    if(result != NULL){
+        ufbgc_write_all(fd,result,sizeof(*result));
+    }
+    if(output_size > 0){
+        ufbgc_write_all(fd,output,output_size);
+    }
+}
+
+//Worker side, reports every iteration start so the parent knows where a crash happened
+static int isolated_record_fd = -1;
+static size_t isolated_position = 0;
+
+//Crash handlers are installed by every run, previous handlers are restored before the signal is raised again
+static const int crash_signals[] = {SIGSEGV,SIGBUS,SIGILL,SIGFPE,SIGABRT};
+static struct sigaction crash_previous_actions[sizeof(crash_signals) / sizeof(crash_signals[0])];
+
+static void ufbgc_write_crash_output(int fd, const char * output, size_t output_size){
+    if(output == NULL || output_size == 0){
+        return;
+    }
+    if(isolated_record_fd >= 0){
+        ufbgc_send_record(isolated_record_fd,UFBGC_RECORD_OUTPUT,isolated_position,0,NULL,output,output_size);
+    }
+    else if(fd >= 0){
+        ufbgc_write_all(fd,output,output_size);
+    }
+}
+
+//Only async signal safe calls, stdio buffer of the stream is read but not flushed
+static void ufbgc_write_pending_output(internal_ufbgc_pending_output * pending){
+    if(pending->stream == NULL){
+        return;
+    }
+    if(pending->output != NULL){
+        ufbgc_write_crash_output(pending->fd,*pending->output,*pending->output_size);
+        #ifdef UFBGC_COOKIE_STREAM
+            if(pending->stdio_buffer != NULL){
+                ufbgc_write_crash_output(pending->fd,pending->stdio_buffer,__fpending(pending->stream));
+            }
+        #endif
+    }
+    #ifdef UFBGC_COOKIE_STREAM
+    else{
+        //Buffer of the destination is dropped once written, exit() would flush it again
+        ufbgc_write_crash_output(pending->fd,pending->stream->_IO_write_base,__fpending(pending->stream));
+        __fpurge(pending->stream);
+    }
+    #endif
+    //Reporters of the parent get the events which happened before the crash
+    if(isolated_record_fd >= 0 && pending->events != NULL && pending->events->size > 0){
+        ufbgc_send_record(isolated_record_fd,UFBGC_RECORD_EVENTS,isolated_position,0,NULL,pending->events->data,pending->events->size);
+    }
+    pending->stream = NULL;
+    pending->output = NULL;
+}
+
+static void ufbgc_crash_handler(int signal_number){
+    ufbgc_write_pending_output(&pending_output);
+    for(size_t i = 0; i < sizeof(crash_signals) / sizeof(crash_signals[0]); ++i){
+        if(crash_signals[i] == signal_number){
+            sigaction(signal_number,&crash_previous_actions[i],NULL);
+        }
+    }
+    raise(signal_number);
+}
+
+//exit() called by a test
+static void ufbgc_exit_handler(){
+    ufbgc_write_pending_output(&pending_output);
+}
+
+static void ufbgc_install_crash_handlers(){
+    static bool installed = false;
+    if(installed){
+        return;
+    }
+    installed = true;
+    struct sigaction action;
+    memset(&action,0,sizeof(action));
+    action.sa_handler = ufbgc_crash_handler;
+    sigemptyset(&action.sa_mask);
+    for(size_t i = 0; i < sizeof(crash_signals) / sizeof(crash_signals[0]); ++i){
+        sigaction(crash_signals[i],&action,&crash_previous_actions[i]);
+    }
+    atexit(ufbgc_exit_handler);
+}
+
+static void ufbgc_isolated_iteration_start(size_t iteration){
+    if(isolated_record_fd >= 0){
+        ufbgc_send_record(isolated_record_fd,UFBGC_RECORD_ITERATION_START,isolated_position,iteration,NULL,NULL,0);
+    }
+}
+
+static bool ufbgc_isolated_send_samples(size_t iteration, const double * samples, size_t no_samples){
+    if(isolated_record_fd < 0){
+        return false;
+    }
+    ufbgc_send_record(isolated_record_fd,UFBGC_RECORD_SAMPLES,isolated_position,iteration,NULL,(const char *) samples,no_samples * sizeof(double));
+    return true;
+}
+
+/*
+    Watchdog thread stops an iteration which runs past its deadline, the thread running it is signalled and the handler
+    writes the output of the frame. A hung test can't be abandoned inside the process, so frames with deadlines run in
+    worker processes: the worker reports the timeout and exits, the parent goes on with a new worker
+    Only when no worker can be started the frame runs in the runner and the run ends with the process
+*/
+#ifdef SIGRTMIN
+    #define UFBGC_WATCHDOG_SIGNAL (SIGRTMIN + 3)
+#else
+    #define UFBGC_WATCHDOG_SIGNAL SIGXCPU
+#endif
+#define UFBGC_WATCHDOG_GRACE_MS 1000     //Thread which doesn't run the handler in time is stopped by the watchdog thread
+
+typedef struct internal_ufbgc_watchdog_entry{
+    struct internal_ufbgc_watchdog_entry * next;
+    pthread_t thread;
+    internal_ufbgc_pending_output * pending;    //Output of the frame on the thread of the entry
+    uint64_t deadline_ns;           //Wall time of ufbgc_get_wall_time_ns, 0 if the entry is not armed
+    size_t iteration;
+    int fd;                         //Destination of the frame output
+    char line[320];                 //[TIMEOUT] line, formatted when the entry is armed
+    size_t line_size;
+}internal_ufbgc_watchdog_entry;
+
+static pthread_mutex_t watchdog_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t watchdog_cond = PTHREAD_COND_INITIALIZER;
+static internal_ufbgc_watchdog_entry * watchdog_entries = NULL;
+static pid_t watchdog_pid = 0;      //Process running the watchdog thread, a forked worker starts its own
+static UFBGC_THREAD_LOCAL internal_ufbgc_watchdog_entry watchdog_entry;
+
+/*
+    Only async signal safe calls, the process exits
+    Handler and the watchdog thread may both expire the entry, the first one writes the output and the other waits for the exit
+*/
+static void ufbgc_watchdog_expire(const internal_ufbgc_watchdog_entry * entry){
+    static const char stopped[] = "ufbgc - run is stopped at a hung test, no worker process could be started for it\n";
+    static int expired = 0;
+    if(__atomic_exchange_n(&expired,1,__ATOMIC_ACQ_REL)){
+        for(;;){
+            pause();
+        }
+    }
+    ufbgc_write_pending_output(entry->pending);
+    if(isolated_record_fd >= 0){
+        ufbgc_send_record(isolated_record_fd,UFBGC_RECORD_TIMEOUT,isolated_position,entry->iteration,NULL,NULL,0);
+    }
+    else{
+        ufbgc_write_all(entry->fd,entry->line,entry->line_size);
+        ufbgc_write_all(STDOUT_FILENO,stopped,sizeof(stopped) - 1);
+    }
+    _exit(1);
+}
+
+static void ufbgc_watchdog_handler(int signal_number){
+    (void) signal_number;
+    const internal_ufbgc_watchdog_entry * entry = &watchdog_entry;
+    if(entry->deadline_ns == 0 || ufbgc_get_wall_time_ns() < entry->deadline_ns){
+        return;
+    }
+    ufbgc_watchdog_expire(entry);
+}
+
+static void * ufbgc_watchdog_run(void * arg){
+    (void) arg;
+    pthread_mutex_lock(&watchdog_lock);
+    for(;;){
+        uint64_t now = ufbgc_get_wall_time_ns();
+        uint64_t next = UINT64_MAX;
+        for(internal_ufbgc_watchdog_entry * entry = watchdog_entries; entry != NULL; entry = entry->next){
+            if(entry->deadline_ns <= now){
+                //Lock is kept, the entry stays armed until the process exits
+                pthread_kill(entry->thread,UFBGC_WATCHDOG_SIGNAL);
+                struct timespec grace = {UFBGC_WATCHDOG_GRACE_MS / 1000,(UFBGC_WATCHDOG_GRACE_MS % 1000) * 1000000L};
+                while(nanosleep(&grace,&grace) != 0 && errno == EINTR);
+                ufbgc_watchdog_expire(entry);
+            }
+            if(entry->deadline_ns < next){
+                next = entry->deadline_ns;
+            }
+        }
+        if(next == UINT64_MAX){
+            pthread_cond_wait(&watchdog_cond,&watchdog_lock);
+        }
+        else{
+            //Condition variable waits on the real time clock
+            uint64_t wake = ufbgc_get_unix_time_ns() + (next - now);
+            struct timespec until = {(time_t)(wake / 1000000000ull),(long)(wake % 1000000000ull)};
+            pthread_cond_timedwait(&watchdog_cond,&watchdog_lock,&until);
+        }
+    }
+    return NULL;
+}
+
+static void ufbgc_watchdog_arm(const ufbgc_test_frame * tframe, size_t iteration, double deadline_ms, bool colored){
+    internal_ufbgc_watchdog_entry * entry = &watchdog_entry;
+    FILE * destination = ufbgc_frame_destination(tframe);
+    entry->thread = pthread_self();
+    entry->pending = &pending_output;
+    entry->iteration = iteration;
+    entry->fd = destination != NULL ? fileno(destination) : STDOUT_FILENO;
+    int len = snprintf(entry->line,sizeof(entry->line),UFBGC_COLOR_SANDWICH(colored,ANSI_COLOR_RED,"'%s'\t\t\t%-10s deadline %g ms @ iteration %lu\n"),
+        tframe->name,"[TIMEOUT]",deadline_ms,(unsigned long) iteration);
+    entry->line_size = len < 0 ? 0 : (size_t) len < sizeof(entry->line) ? (size_t) len : sizeof(entry->line) - 1;
+
+    pid_t pid = getpid();
+    if(__atomic_load_n(&watchdog_pid,__ATOMIC_ACQUIRE) != pid){
+        //Forked worker has no watchdog thread, the lock may have been copied while it was held
+        if(watchdog_pid != 0){
+            pthread_mutex_init(&watchdog_lock,NULL);
+            pthread_cond_init(&watchdog_cond,NULL);
+            watchdog_entries = NULL;
+        }
+        pthread_mutex_lock(&watchdog_lock);
+        if(watchdog_pid != pid){
+            struct sigaction action;
+            memset(&action,0,sizeof(action));
+            action.sa_handler = ufbgc_watchdog_handler;
+            action.sa_flags = SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            sigaction(UFBGC_WATCHDOG_SIGNAL,&action,NULL);
+
+            pthread_t thread;
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+            pthread_attr_setdetachstate(&attr,PTHREAD_CREATE_DETACHED);
+            if(pthread_create(&thread,&attr,ufbgc_watchdog_run,NULL) == 0){
+                __atomic_store_n(&watchdog_pid,pid,__ATOMIC_RELEASE);
+            }
+            pthread_attr_destroy(&attr);
+        }
+        pthread_mutex_unlock(&watchdog_lock);
+    }
+
+    pthread_mutex_lock(&watchdog_lock);
+    entry->deadline_ns = ufbgc_get_wall_time_ns() + (uint64_t)(deadline_ms * 1e6);
+    entry->next = watchdog_entries;
+    watchdog_entries = entry;
+    pthread_cond_signal(&watchdog_cond);
+    pthread_mutex_unlock(&watchdog_lock);
+}
+
+static void ufbgc_watchdog_disarm(){
+    internal_ufbgc_watchdog_entry * entry = &watchdog_entry;
+    if(entry->deadline_ns == 0){
+        return;
+    }
+    pthread_mutex_lock(&watchdog_lock);
+    internal_ufbgc_watchdog_entry ** link = &watchdog_entries;
+    while(*link != NULL && *link != entry){
+        link = &(*link)->next;
+    }
+    if(*link != NULL){
+        *link = entry->next;
+    }
+    entry->deadline_ns = 0;
+    pthread_mutex_unlock(&watchdog_lock);
+}
+
+static void ufbgc_isolated_worker(internal_ufbgc_test_run * run, internal_ufbgc_process * proc){
+    isolated_record_fd = proc->fd;
+    #ifdef __linux__
+        ufbgc_pin_worker(proc->worker_id);
+    #endif
+    //Worker builds its own fixtures, only for the frames it runs
+    ufbgc_fixtures_inherit();
+    ufbgc_fixtures_count_users(run,proc->positions + proc->next,proc->no_positions - proc->next);
+
+    for(size_t k = proc->next; k < proc->no_positions; ++k){
+        size_t pos = proc->positions[k];
+        const ufbgc_test_frame * tframe = &run->test_list[run->indices[pos]];
+        char * output;
+        size_t output_size;
+        internal_ufbgc_event_buffer events;
+
+        isolated_position = pos;
+        ufbgc_send_record(proc->fd,UFBGC_RECORD_FRAME_START,pos,0,NULL,NULL,0);
+
+        if(proc->direct_output){
+            ufbgc_run_frame_direct(tframe,ufbgc_frame_destination(tframe),&run->results[pos],&events);
+            output = NULL;
+            output_size = 0;
+        }
+        else{
+            ufbgc_run_frame_buffered(tframe,&run->results[pos],&output,&output_size,&events);
+        }
+
+        if(events.size > 0){
+            ufbgc_send_record(proc->fd,UFBGC_RECORD_EVENTS,pos,0,NULL,events.data,events.size);
+        }
+        ufbgc_send_record(proc->fd,UFBGC_RECORD_FRAME_END,pos,0,&run->results[pos],output,output_size);
+        ufbgc_event_buffer_free(&events);
+        free(output);
+    }
+    ufbgc_fixtures_finish();
+    fflush(stdout);
+    close(proc->fd);
+    _exit(0);
+}
+
+static bool ufbgc_spawn_process(internal_ufbgc_test_run * run, internal_ufbgc_process * proc){
+    int fds[2];
+    if(pipe(fds) != 0){
+        return false;
+    }
+    //Pending stdout must not be duplicated into the child
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid < 0){
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if(pid == 0){
+        close(fds[0]);
+        proc->fd = fds[1];
+        ufbgc_isolated_worker(run,proc);
+    }
+    close(fds[1]);
+    proc->pid = pid;
+    proc->fd = fds[0];
+    proc->running_frame = false;
+    proc->timed_out = false;
+    proc->buffer_size = 0;
+    return true;
+}
+
+static void ufbgc_handle_records(internal_ufbgc_test_run * run, internal_ufbgc_process * proc, char ** outputs, size_t * output_sizes,
+    internal_ufbgc_event_buffer * events, bool * done){
+    size_t offset = 0;
+    while(proc->buffer_size - offset >= sizeof(internal_ufbgc_record)){
+        internal_ufbgc_record record;
+        memcpy(&record,proc->buffer + offset,sizeof(record));
+        if(proc->buffer_size - offset - sizeof(record) < record.payload_size){
+            break;
+        }
+        const char * payload = proc->buffer + offset + sizeof(record);
+        size_t pos = record.position;
+
+        if(pos < run->len){
+            if(record.type == UFBGC_RECORD_FRAME_START){
+                proc->running_frame = true;
+                proc->current_iteration = 0;
+            }
+            else if(record.type == UFBGC_RECORD_EVENTS){
+                ufbgc_event_buffer_append(&events[pos],payload,record.payload_size);
+            }
+            else if(record.type == UFBGC_RECORD_OUTPUT){
+                char * crash_output = (char *) realloc(proc->crash_output,proc->crash_output_size + record.payload_size);
+                if(crash_output != NULL){
+                    memcpy(crash_output + proc->crash_output_size,payload,record.payload_size);
+                    proc->crash_output = crash_output;
+                    proc->crash_output_size += record.payload_size;
+                }
+            }
+            else if(record.type == UFBGC_RECORD_ITERATION_START){
+                proc->current_iteration = record.iteration;
+            }
+            else if(record.type == UFBGC_RECORD_TIMEOUT){
+                proc->current_iteration = record.iteration;
+                proc->timed_out = true;
+            }
+            else if(record.type == UFBGC_RECORD_SAMPLES){
+                const ufbgc_test_frame * tframe = &run->test_list[run->indices[pos]];
+                double samples[UFBGC_BASELINE_MAX_SAMPLES];
+                size_t no_samples = record.payload_size / sizeof(double);
+                if(no_samples > UFBGC_BASELINE_MAX_SAMPLES){
+                    payload += (no_samples - UFBGC_BASELINE_MAX_SAMPLES) * sizeof(double);
+                    no_samples = UFBGC_BASELINE_MAX_SAMPLES;
+                }
+                memcpy(samples,payload,no_samples * sizeof(double));
+                ufbgc_baseline_add(&baseline_current,tframe->name,record.iteration,samples,no_samples);
+            }
+            else if(record.type == UFBGC_RECORD_FRAME_END && record.payload_size >= sizeof(internal_ufbgc_test_result)){
+                size_t output_size = record.payload_size - sizeof(internal_ufbgc_test_result);
+                memcpy(&run->results[pos],payload,sizeof(internal_ufbgc_test_result));
+                outputs[pos] = (char *) malloc(output_size + 1);
+                if(outputs[pos] != NULL){
+                    memcpy(outputs[pos],payload + sizeof(internal_ufbgc_test_result),output_size);
+                    output_sizes[pos] = output_size;
+                }
+                done[pos] = true;
+                proc->running_frame = false;
+                proc->next++;
+            }
+        }
+        offset += sizeof(record) + record.payload_size;
+    }
+    memmove(proc->buffer,proc->buffer + offset,proc->buffer_size - offset);
+    proc->buffer_size -= offset;
+}
+
+//Frame which was running when the worker died is reported as crashed, the rest of the shard goes to a new worker
+static void ufbgc_handle_process_exit(internal_ufbgc_test_run * run, internal_ufbgc_process * proc, int status, char ** outputs, size_t * output_sizes,
+    internal_ufbgc_event_buffer * events, bool * done){
+    if(proc->next >= proc->no_positions){
+        return;
+    }
+    size_t pos = proc->positions[proc->next];
+    const ufbgc_test_frame * tframe = &run->test_list[run->indices[pos]];
+    internal_ufbgc_test_result * result = &run->results[pos];
+
+    result->tframe = tframe;
+    result->test_result = UFBGC_FAIL;
+    result->timed_out = proc->timed_out;
+    result->crashed = !proc->timed_out;
+    result->crash_signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+    result->exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 0;
+    proc->timed_out = false;
+
+    char * output;
+    size_t output_size;
+    FILE * out = ufbgc_open_output_buffer(&output,&output_size,NULL);
+    bool colored = tframe->output_file == NULL;
+    if(proc->crash_output != NULL){
+        fwrite(proc->crash_output,1,proc->crash_output_size,out);
+        free(proc->crash_output);
+        proc->crash_output = NULL;
+        proc->crash_output_size = 0;
+    }
+    if(result->timed_out){
+        fprintf(out,UFBGC_COLOR_SANDWICH(colored,ANSI_COLOR_RED,"'%s'\t\t\t%-10s deadline %g ms @ iteration %lu\n"),
+            tframe->name,"[TIMEOUT]",ufbgc_frame_deadline(tframe),proc->current_iteration);
+    }
+    else if(result->crash_signal){
+        fprintf(out,UFBGC_COLOR_SANDWICH(colored,ANSI_COLOR_RED,"'%s'\t\t\t%-10s signal %d (%s) @ iteration %lu\n"),
+            tframe->name,"[CRASHED]",result->crash_signal,strsignal(result->crash_signal),proc->current_iteration);
+    }
+    else{
+        fprintf(out,UFBGC_COLOR_SANDWICH(colored,ANSI_COLOR_RED,"'%s'\t\t\t%-10s exit status %d @ iteration %lu\n"),
+            tframe->name,"[CRASHED]",result->exit_status,proc->current_iteration);
+    }
+    fprintf(out,UFBGC_COLOR_SANDWICH(colored,ANSI_COLOR_MAGENTA,"------------------------------------------------------------\n"));
+    fclose(out);
+
+    //Test start is missing if the worker died before it sent the events of the frame
+    if(no_reporters > 0){
+        char message[128];
+        ufbgc_event event;
+        memset(&event,0,sizeof(event));
+        event.test = tframe->name;
+        event.timestamp_ns = ufbgc_get_unix_time_ns();
+        if(events[pos].size == 0){
+            event.type = UFBGC_EVENT_TEST_START;
+            ufbgc_encode_event(&events[pos],&event);
+        }
+        if(result->timed_out){
+            snprintf(message,sizeof(message),"deadline %g ms @ iteration %lu",ufbgc_frame_deadline(tframe),proc->current_iteration);
+        }
+        else if(result->crash_signal){
+            snprintf(message,sizeof(message),"signal %d (%s) @ iteration %lu",result->crash_signal,strsignal(result->crash_signal),proc->current_iteration);
+        }
+        else{
+            snprintf(message,sizeof(message),"exit status %d @ iteration %lu",result->exit_status,proc->current_iteration);
+        }
+        event.type = UFBGC_EVENT_TEST_END;
+        event.status = result->timed_out ? UFBGC_STATUS_TIMEOUT : UFBGC_STATUS_CRASHED;
+        event.iteration = proc->current_iteration + 1;
+        event.message = message;
+        ufbgc_encode_event(&events[pos],&event);
+    }
+
+    outputs[pos] = output;
+    output_sizes[pos] = output_size;
+    done[pos] = true;
+    proc->next++;
+}
+
+/*
+    False if the workers can't be set up, frames are not run then
+    With direct_output workers print the frames themselves, which keeps the order only with a single worker
+*/
+static bool ufbgc_run_processes(internal_ufbgc_test_run * run, size_t n_workers, bool direct_output){
+
+    internal_ufbgc_process * procs = (internal_ufbgc_process*) calloc(n_workers, sizeof(internal_ufbgc_process));
+    size_t * positions = (size_t*) malloc(sizeof(size_t) * run->len);
+    char ** outputs = (char**) calloc(run->len, sizeof(char*));
+    internal_ufbgc_event_buffer * events = (internal_ufbgc_event_buffer*) calloc(run->len, sizeof(internal_ufbgc_event_buffer));
+    size_t * output_sizes = (size_t*) calloc(run->len, sizeof(size_t));
+    bool * done = (bool*) calloc(run->len, sizeof(bool));
+    struct pollfd * pfds = (struct pollfd*) calloc(n_workers, sizeof(struct pollfd));
+
+    if(procs == NULL || positions == NULL || outputs == NULL || events == NULL || output_sizes == NULL || done == NULL || pfds == NULL){
+        free(procs); free(positions); free(outputs); free(events); free(output_sizes); free(done); free(pfds);
+        return false;
+    }
+
+    //Round robin shards, so the head of the list is finished early and printed while the rest runs
+    size_t k = 0;
+    for(size_t w = 0; w < n_workers; ++w){
+        procs[w].worker_id = w;
+        procs[w].positions = positions + k;
+        for(size_t pos = w; pos < run->len; pos += n_workers){
+            positions[k++] = pos;
+            procs[w].no_positions++;
+        }
+        procs[w].fd = -1;
+        procs[w].direct_output = direct_output;
+        if(!ufbgc_spawn_process(run,&procs[w])){
+            procs[w].fd = -1;
+        }
+    }
+
+    size_t next_print = 0;
+    bool stop = false;
+    for(;;){
+        size_t alive = 0;
+        for(size_t w = 0; w < n_workers; ++w){
+            pfds[w].fd = procs[w].fd;
+            pfds[w].events = POLLIN;
+            pfds[w].revents = 0;
+            if(procs[w].fd >= 0) alive++;
+        }
+        if(alive == 0){
+            break;
+        }
+        if(poll(pfds,n_workers,-1) < 0){
+            if(errno == EINTR) continue;
+            break;
+        }
+
+        for(size_t w = 0; w < n_workers; ++w){
+            internal_ufbgc_process * proc = &procs[w];
+            if(proc->fd < 0 || pfds[w].revents == 0){
+                continue;
+            }
+            if(proc->buffer_capacity - proc->buffer_size < 4096){
+                size_t capacity = proc->buffer_capacity ? proc->buffer_capacity * 2 : 65536;
+                char * buffer = (char *) realloc(proc->buffer,capacity);
+                if(buffer == NULL){
+                    continue;
+                }
+                proc->buffer = buffer;
+                proc->buffer_capacity = capacity;
+            }
+            ssize_t n = read(proc->fd,proc->buffer + proc->buffer_size,proc->buffer_capacity - proc->buffer_size);
+            if(n < 0 && errno == EINTR){
+                continue;
+            }
+            size_t finished = proc->next;
+            if(n > 0){
+                proc->buffer_size += (size_t) n;
+                ufbgc_handle_records(run,proc,outputs,output_sizes,events,done);
+            }
+            else{
+                close(proc->fd);
+                proc->fd = -1;
+                int status = 0;
+                while(waitpid(proc->pid,&status,0) < 0 && errno == EINTR);
+                //Worker killed by fail fast is not a crash
+                if(!stop){
+                    ufbgc_handle_process_exit(run,proc,status,outputs,output_sizes,events,done);
+                }
+
+                if(!stop && proc->next < proc->no_positions && !ufbgc_spawn_process(run,proc)){
+                    //Worker can't be replaced, remaining frames are reported as crashed
+                    while(proc->next < proc->no_positions){
+                        ufbgc_handle_process_exit(run,proc,status,outputs,output_sizes,events,done);
+                    }
+                }
+            }
+
+            for(; runner_options.fail_fast && !stop && finished < proc->next; ++finished){
+                stop = ufbgc_result_failed(&run->results[proc->positions[finished]]);
+            }
+            if(stop){
+                //Frames which are running are abandoned, their workers are reaped when the pipe closes
+                for(size_t v = 0; v < n_workers; ++v){
+                    if(procs[v].fd >= 0){
+                        kill(procs[v].pid,SIGKILL);
+                    }
+                }
+            }
+        }
+
+        while(next_print < run->len && done[next_print]){
+            ufbgc_write_frame_output(&run->test_list[run->indices[next_print]],outputs[next_print],output_sizes[next_print]);
+            ufbgc_report_events(&events[next_print]);
+            ufbgc_event_buffer_free(&events[next_print]);
+            free(outputs[next_print]);
+            outputs[next_print] = NULL;
+            next_print++;
+        }
+    }
+
+    //Frames finished after a frame which was abandoned by fail fast
+    for(; next_print < run->len; ++next_print){
+        if(done[next_print]){
+            ufbgc_write_frame_output(&run->test_list[run->indices[next_print]],outputs[next_print],output_sizes[next_print]);
+            ufbgc_report_events(&events[next_print]);
+        }
+    }
+
+    for(size_t w = 0; w < n_workers; ++w){
+        free(procs[w].buffer);
+        free(procs[w].crash_output);
+    }
+    for(size_t i = 0; i < run->len; ++i){
+        free(outputs[i]);
+        ufbgc_event_buffer_free(&events[i]);
+    }
+    free(procs); free(positions); free(outputs); free(events); free(output_sizes); free(done); free(pfds);
+    return true;
+}
+
+/*
+    Frame with a deadline of a sequential run is run by a worker process of its own, the watchdog can stop a hung test
+    by ending the worker and the run goes on. Worker prints the frame to its destination like the runner would
+    Fixtures of the frame are built by the runner, so the workers share them and they are built once in a run
+*/
+static bool ufbgc_run_in_worker(internal_ufbgc_test_run * run, size_t i){
+    const ufbgc_test_frame * tframe = &run->test_list[run->indices[i]];
+    for(ufbgc_fixture * const * fixture = tframe->fixtures; fixture != NULL && *fixture != NULL; ++fixture){
+        ufbgc_get_fixture(*fixture);
+    }
+    fflush(stdout);
+    internal_ufbgc_test_run single = {run->test_list,&run->indices[i],1,&run->results[i]};
+    if(!ufbgc_run_processes(&single,1,true)){
+        return false;
+    }
+    ufbgc_fixtures_release(tframe);
+    return true;
+}
+
+//Frames of the run which the watchdog may stop
+static bool ufbgc_run_has_deadline(const internal_ufbgc_test_run * run){
+    for(size_t i = 0; i < run->len; ++i){
+        if(ufbgc_frame_deadline(&run->test_list[run->indices[i]]) > 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
+
+
+/*
+    Stress frames run the test function on every thread for each round, a spinning barrier releases the threads of
+    a round together. A failing thread stops the rounds after the current one
+    Threads print into output buffers of their own, the buffers and the events are appended in thread order when all joined
+*/
+typedef struct{
+    size_t count;
+    size_t waiting;
+    unsigned generation;
+}internal_ufbgc_spin_barrier;
+
+#define UFBGC_SPINS_BEFORE_YIELD 4096       //Spinning threads yield when there are more threads than CPUs
+
+static inline void ufbgc_spin_pause(unsigned spins){
+    #if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+    #elif defined(__aarch64__)
+        __asm__ volatile("yield");
+    #endif
+    #ifdef UFBGC_POSIX
+        if(spins >= UFBGC_SPINS_BEFORE_YIELD){
+            sched_yield();
+        }
+    #else
+        (void) spins;
+    #endif
+}
+
+static void ufbgc_spin_barrier_wait(internal_ufbgc_spin_barrier * barrier){
+    unsigned generation = __atomic_load_n(&barrier->generation,__ATOMIC_ACQUIRE);
+    if(__atomic_add_fetch(&barrier->waiting,1,__ATOMIC_ACQ_REL) == barrier->count){
+        __atomic_store_n(&barrier->waiting,0,__ATOMIC_RELAXED);
+        __atomic_store_n(&barrier->generation,generation + 1,__ATOMIC_RELEASE);
+        return;
+    }
+    for(unsigned spins = 0; __atomic_load_n(&barrier->generation,__ATOMIC_ACQUIRE) == generation; ++spins){
+        ufbgc_spin_pause(spins);
+    }
+}
+
+typedef struct{
+    const ufbgc_test_frame * tframe;
+    void * user_arg;
+    const internal_ufbgc_test_frame * context;      //Frame of the runner thread
+    size_t threads;
+    size_t rounds;
+    internal_ufbgc_spin_barrier barrier;
+    int start;                                      //Threads wait for 1, 2 stops them before the first round
+    size_t stop;                                    //Round after a failed one, 0 if no thread failed
+}internal_ufbgc_stress_run;
+
+typedef struct{
+    internal_ufbgc_stress_run * run;
+    size_t thread;
+    size_t failed_round;                            //SIZE_MAX if the thread did not fail
+    bool used_random;
+    char * output;
+    size_t output_size;
+    internal_ufbgc_event_buffer events;
+    internal_ufbgc_histogram_report histograms[UFBGC_MAX_REPORTED_HISTOGRAMS];
+    size_t no_histograms;
+    uint64_t bytes_processed;                       //Summed over the rounds of the thread
+    uint64_t items_processed;
+    uint64_t cpu_ns;                                //CPU time of the thread
+}internal_ufbgc_stress_thread;
+
+//Thread takes the parameters and generated values of the runner, they are not changed while the rounds run
+static void * ufbgc_stress_thread_run(void * arg){
+    internal_ufbgc_stress_thread * thread = (internal_ufbgc_stress_thread *) arg;
+    internal_ufbgc_stress_run * run = thread->run;
+    const ufbgc_test_frame * tframe = run->tframe;
+    uint64_t cpu_start = ufbgc_get_thread_cpu_time_ns();
+
+    current_test_frame = *run->context;
+    FILE * out = ufbgc_open_output_buffer(&thread->output,&thread->output_size,NULL);
+    current_test_frame.output_file = out;
+    current_test_frame.quiet = current_test_frame.quiet || out == NULL;
+    current_test_frame.events = run->context->events != NULL ? &thread->events : NULL;
+    current_test_frame.no_histograms = 0;
+    current_test_frame.stress_threads = run->threads;
+    current_test_frame.stress_thread = thread->thread;
+    ufbgc_seed_random(ufbgc_iteration_seed(tframe->name,run->context->frame_iterator) ^ ((thread->thread + 1) * 0x9e3779b97f4a7c15ull));
+    #ifdef __linux__
+        //Threads of a stress frame contend on every pinned CPU, not only on the one of their worker
+        ufbgc_pin_worker(SIZE_MAX);
+    #endif
+
+    int start;
+    for(unsigned spins = 0; (start = __atomic_load_n(&run->start,__ATOMIC_ACQUIRE)) == 0; ++spins){
+        ufbgc_spin_pause(spins);
+    }
+    //Stop is compared with the round, a thread late to read it must not see a failure of the round it is in
+    for(size_t round = 0; start == 1 && round < run->rounds; ++round){
+        ufbgc_spin_barrier_wait(&run->barrier);
+        size_t stop = __atomic_load_n(&run->stop,__ATOMIC_ACQUIRE);
+        if(stop != 0 && stop <= round){
+            break;
+        }
+        current_test_frame.stress_round = round;
+        current_test_frame.bytes_processed = 0;
+        current_test_frame.items_processed = 0;
+        if(tframe->test_f(tframe->parameters,run->user_arg) != UFBGC_OK){
+            thread->failed_round = round;
+            __atomic_store_n(&run->stop,round + 1,__ATOMIC_RELEASE);
+        }
+        thread->bytes_processed += current_test_frame.bytes_processed;
+        thread->items_processed += current_test_frame.items_processed;
+    }
+
+    thread->used_random = thread_random.used;
+    memcpy(thread->histograms,current_test_frame.histograms,sizeof(thread->histograms));
+    thread->no_histograms = current_test_frame.no_histograms;
+    if(out != NULL){
+        fclose(out);
+    }
+    memset(&current_test_frame,0,sizeof(current_test_frame));
+    thread->cpu_ns = ufbgc_get_thread_cpu_time_ns() - cpu_start;
+    return NULL;
+}
+
+/*
+    CPU time of the stress threads is summed into threads_cpu_ns, it is 0 when the threads run on the runner thread
+*/
+static ufbgc_return_t ufbgc_run_stress(const ufbgc_test_frame * tframe, void * user_arg, FILE * out, uint64_t * threads_cpu_ns){
+    internal_ufbgc_stress_run run;
+    memset(&run,0,sizeof(run));
+    run.tframe = tframe;
+    run.user_arg = user_arg;
+    run.context = &current_test_frame;
+    run.threads = tframe->threads ? tframe->threads : ufbgc_online_cpus();
+    run.rounds = tframe->rounds ? tframe->rounds : 1;
+    run.barrier.count = run.threads;
+
+    internal_ufbgc_stress_thread * threads = (internal_ufbgc_stress_thread *) calloc(run.threads,sizeof(internal_ufbgc_stress_thread));
+    if(threads == NULL){
+        ufbgc_print_red(out,"Cannot allocate %lu stress threads\n",(unsigned long) run.threads);
+        return UFBGC_FAIL;
+    }
+    for(size_t i = 0; i < run.threads; ++i){
+        threads[i].run = &run;
+        threads[i].thread = i;
+        threads[i].failed_round = SIZE_MAX;
+    }
+
+    size_t started = 0;
+    #ifdef UFBGC_POSIX
+        pthread_t * ids = (pthread_t *) malloc(run.threads * sizeof(pthread_t));
+        while(ids != NULL && started < run.threads && pthread_create(&ids[started],NULL,ufbgc_stress_thread_run,&threads[started]) == 0){
+            started++;
+        }
+        __atomic_store_n(&run.start,started == run.threads ? 1 : 2,__ATOMIC_RELEASE);
+        for(size_t i = 0; i < started; ++i){
+            pthread_join(ids[i],NULL);
+        }
+        free(ids);
+    #else
+        //Without threads the threads of a round run one after the other on the runner thread
+        internal_ufbgc_test_frame context = current_test_frame;
+        current_test_frame.stress_threads = run.threads;
+        for(size_t round = 0; round < run.rounds && run.stop == 0; ++round){
+            current_test_frame.stress_round = round;
+            for(size_t i = 0; i < run.threads; ++i){
+                current_test_frame.stress_thread = i;
+                current_test_frame.bytes_processed = 0;
+                current_test_frame.items_processed = 0;
+                if(tframe->test_f(tframe->parameters,user_arg) != UFBGC_OK){
+                    threads[i].failed_round = round;
+                    run.stop = round + 1;
+                }
+                threads[i].bytes_processed += current_test_frame.bytes_processed;
+                threads[i].items_processed += current_test_frame.items_processed;
+            }
+        }
+        current_test_frame.stress_threads = context.stress_threads;
+        started = run.threads;
+    #endif
+
+    //Work of a stress frame is the work of every thread in every round
+    const internal_ufbgc_stress_thread * failed = NULL;
+    bool used_random = false;
+    current_test_frame.bytes_processed = 0;
+    current_test_frame.items_processed = 0;
+    for(size_t i = 0; i < run.threads; ++i){
+        internal_ufbgc_stress_thread * thread = &threads[i];
+        if(thread->output_size > 0){
+            fwrite(thread->output,1,thread->output_size,out);
+        }
+        free(thread->output);
+        if(current_test_frame.events != NULL && thread->events.size > 0){
+            ufbgc_event_buffer_append(current_test_frame.events,thread->events.data,thread->events.size);
+        }
+        ufbgc_event_buffer_free(&thread->events);
+        for(size_t j = 0; j < thread->no_histograms; ++j){
+            ufbgc_add_histogram_report(&current_test_frame,&thread->histograms[j]);
+        }
+        if(thread->failed_round != SIZE_MAX && (failed == NULL || thread->failed_round < failed->failed_round)){
+            failed = thread;
+        }
+        used_random = used_random || thread->used_random;
+        current_test_frame.bytes_processed += thread->bytes_processed;
+        current_test_frame.items_processed += thread->items_processed;
+        *threads_cpu_ns += thread->cpu_ns;
+    }
+    thread_random.used = thread_random.used || used_random;
+
+    ufbgc_return_t result = UFBGC_OK;
+    if(started < run.threads){
+        ufbgc_print_red(out,"Cannot start %lu stress threads, %lu started\n",(unsigned long) run.threads,(unsigned long) started);
+        result = UFBGC_FAIL;
+    }
+    else if(failed != NULL){
+        ufbgc_print_yellow(out,"Thread %lu failed in round %lu (%lu threads x %lu rounds)\n",(unsigned long) failed->thread,
+            (unsigned long) failed->failed_round,(unsigned long) run.threads,(unsigned long) run.rounds);
+        result = UFBGC_FAIL;
+    }
+    free(threads);
+    return result;
+}
+
+size_t ufbgc_stress_threads(){
+    return current_test_frame.stress_threads;
+}
+
+size_t ufbgc_stress_thread(){
+    return current_test_frame.stress_thread;
+}
+
+size_t ufbgc_stress_round(){
+    return current_test_frame.stress_round;
+}
+
+/*
+    History keeps the outcome and the duration of every frame over the runs, keyed by frame name
+    File format is "UFBGCHS1", uint32 run count, uint32 entry count, and for every entry sorted by name:
+    uint16 name length, name, uint32 runs, uint32 failures, uint32 last run, uint32 last failed run, double duration (ms)
+*/
+#define UFBGC_HISTORY_MAGIC "UFBGCHS1"
+#define UFBGC_HISTORY_MAX_AGE 256          //Entries of frames which did not run for this many runs are dropped
+#define UFBGC_HISTORY_DURATION_WEIGHT 0.3  //Weight of the last duration in the moving average
+
+typedef struct{
+    char * name;
+    uint32_t runs;
+    uint32_t failures;
+    uint32_t last_run;              //Run number of the last run of the frame
+    uint32_t last_failed_run;       //Run number of the last failure, zero if it never failed
+    double duration;                //Moving average of the wall time in ms
+}internal_ufbgc_history_entry;
+
+typedef struct{
+    internal_ufbgc_history_entry * entries;
+    size_t len;
+    size_t sorted_len;              //Entries before this are sorted by name
+    size_t capacity;
+    uint32_t run;                   //Number of this run, the first run is 1
+}internal_ufbgc_history;
+
+static int ufbgc_history_compare(const void * a, const void * b){
+    return strcmp(((const internal_ufbgc_history_entry *) a)->name,((const internal_ufbgc_history_entry *) b)->name);
+}
+
+static internal_ufbgc_history_entry * ufbgc_history_find(const internal_ufbgc_history * history, const char * name){
+    internal_ufbgc_history_entry key = {.name = (char *) name};
+    if(history->sorted_len == 0){
+        return NULL;
+    }
+    return (internal_ufbgc_history_entry *) bsearch(&key,history->entries,history->sorted_len,sizeof(key),ufbgc_history_compare);
+}
+
+static internal_ufbgc_history_entry * ufbgc_history_add(internal_ufbgc_history * history, const char * name){
+    if(history->len == history->capacity){
+        size_t capacity = history->capacity ? history->capacity * 2 : 64;
+        internal_ufbgc_history_entry * entries = (internal_ufbgc_history_entry *) realloc(history->entries,capacity * sizeof(*entries));
+        if(entries == NULL){
+            return NULL;
+        }
+        history->entries = entries;
+        history->capacity = capacity;
+    }
+    internal_ufbgc_history_entry * entry = &history->entries[history->len];
+    memset(entry,0,sizeof(*entry));
+    entry->name = strdup(name);
+    if(entry->name == NULL){
+        return NULL;
+    }
+    history->len++;
+    return entry;
+}
+
+static void ufbgc_history_free(internal_ufbgc_history * history){
+    for(size_t i = 0; i < history->len; ++i){
+        free(history->entries[i].name);
+    }
+    free(history->entries);
+    memset(history,0,sizeof(*history));
+}
+
+static bool ufbgc_history_load(internal_ufbgc_history * history, const char * path){
+    FILE * fl = fopen(path,"rb");
+    if(fl == NULL){
+        return false;
+    }
+    char magic[8];
+    uint32_t no_entries = 0;
+    bool ok = fread(magic,1,8,fl) == 8 && !memcmp(magic,UFBGC_HISTORY_MAGIC,8);
+    ok = ok && fread(&history->run,sizeof(history->run),1,fl) == 1 && fread(&no_entries,sizeof(no_entries),1,fl) == 1;
+    for(uint32_t i = 0; ok && i < no_entries; ++i){
+        uint16_t name_len;
+        char name[65536];
+        internal_ufbgc_history_entry entry;
+        ok = fread(&name_len,sizeof(name_len),1,fl) == 1 && fread(name,1,name_len,fl) == name_len;
+        name[ok ? name_len : 0] = '\0';
+        ok = ok && fread(&entry.runs,sizeof(entry.runs),1,fl) == 1 && fread(&entry.failures,sizeof(entry.failures),1,fl) == 1;
+        ok = ok && fread(&entry.last_run,sizeof(entry.last_run),1,fl) == 1 && fread(&entry.last_failed_run,sizeof(entry.last_failed_run),1,fl) == 1;
+        ok = ok && fread(&entry.duration,sizeof(entry.duration),1,fl) == 1;
+        internal_ufbgc_history_entry * added = ok ? ufbgc_history_add(history,name) : NULL;
+        if(added != NULL){
+            entry.name = added->name;
+            *added = entry;
+        }
+        ok = added != NULL;
+    }
+    fclose(fl);
+    //Broken file is ignored, the history starts over
+    if(!ok){
+        ufbgc_history_free(history);
+        return false;
+    }
+    qsort(history->entries,history->len,sizeof(internal_ufbgc_history_entry),ufbgc_history_compare);
+    history->sorted_len = history->len;
+    return true;
+}
+
+static bool ufbgc_history_save(const internal_ufbgc_history * history, const char * path){
+    uint32_t no_entries = 0;
+    for(size_t i = 0; i < history->len; ++i){
+        if(history->run - history->entries[i].last_run < UFBGC_HISTORY_MAX_AGE){
+            no_entries++;
+        }
+    }
+
+    char * tmp_path;
+    FILE * fl = ufbgc_open_atomic(path,&tmp_path);
+    bool ok = fl != NULL;
+    ok = ok && fwrite(UFBGC_HISTORY_MAGIC,1,8,fl) == 8 && fwrite(&history->run,sizeof(history->run),1,fl) == 1 && fwrite(&no_entries,sizeof(no_entries),1,fl) == 1;
+    for(size_t i = 0; ok && i < history->len; ++i){
+        const internal_ufbgc_history_entry * entry = &history->entries[i];
+        if(history->run - entry->last_run >= UFBGC_HISTORY_MAX_AGE){
+            continue;
+        }
+        size_t name_len = strlen(entry->name);
+        uint16_t len16 = (uint16_t)(name_len > 65535 ? 65535 : name_len);
+        ok = fwrite(&len16,sizeof(len16),1,fl) == 1 && fwrite(entry->name,1,len16,fl) == len16;
+        ok = ok && fwrite(&entry->runs,sizeof(entry->runs),1,fl) == 1 && fwrite(&entry->failures,sizeof(entry->failures),1,fl) == 1;
+        ok = ok && fwrite(&entry->last_run,sizeof(entry->last_run),1,fl) == 1 && fwrite(&entry->last_failed_run,sizeof(entry->last_failed_run),1,fl) == 1;
+        ok = ok && fwrite(&entry->duration,sizeof(entry->duration),1,fl) == 1;
+    }
+    return ufbgc_close_atomic(fl,tmp_path,path,ok);
+}
+
+//Frames which did not run or were cached are not recorded, so a fail fast or sharded run keeps the history of the others
+static void ufbgc_history_update(internal_ufbgc_history * history, const internal_ufbgc_test_result * results, size_t len){
+    for(size_t i = 0; i < len; ++i){
+        const internal_ufbgc_test_result * result = &results[i];
+        if(result->tframe == NULL || result->cached){
+            continue;
+        }
+        internal_ufbgc_history_entry * entry = ufbgc_history_find(history,result->tframe->name);
+        if(entry == NULL && (entry = ufbgc_history_add(history,result->tframe->name)) == NULL){
+            continue;
+        }
+        entry->runs++;
+        entry->last_run = history->run;
+        if(ufbgc_result_failed(result)){
+            entry->failures++;
+            entry->last_failed_run = history->run;
+        }
+        //Crashed frame has no duration
+        if(!result->crashed){
+            entry->duration = entry->runs == 1 ? result->execution_time :
+                entry->duration + UFBGC_HISTORY_DURATION_WEIGHT * (result->execution_time - entry->duration);
+        }
+    }
+    qsort(history->entries,history->len,sizeof(internal_ufbgc_history_entry),ufbgc_history_compare);
+    history->sorted_len = history->len;
+}
+
+typedef struct{
+    size_t index;
+    double key;
+}internal_ufbgc_order_key;
+
+//Bigger key runs first, equal keys keep the declared order
+static int ufbgc_order_compare(const void * a, const void * b){
+    const internal_ufbgc_order_key * ka = (const internal_ufbgc_order_key *) a;
+    const internal_ufbgc_order_key * kb = (const internal_ufbgc_order_key *) b;
+    if(ka->key != kb->key){
+        return ka->key > kb->key ? -1 : 1;
+    }
+    return ka->index < kb->index ? -1 : (ka->index > kb->index);
+}
+
+/*
+    Failed first: the latest failure first, frames without history are next as they are likely new or changed
+    Longest first: frames without history are assumed to be the longest
+    Random: same seed gives the same order, the seed is printed in the header
+*/
+static void ufbgc_order_run(internal_ufbgc_test_run * run, const internal_ufbgc_history * history, internal_ufbgc_order order){
+    if(order == UFBGC_ORDER_DECLARED || run->len < 2){
+        return;
+    }
+    if(order == UFBGC_ORDER_RANDOM){
+        uint64_t x = runner_options.seed ^ 0x6f72646572ull;
+        for(size_t i = run->len - 1; i > 0; --i){
+            size_t j = (size_t)(ufbgc_splitmix64(&x) % (i + 1));
+            size_t index = run->indices[i];
+            run->indices[i] = run->indices[j];
+            run->indices[j] = index;
+        }
+        return;
+    }
+    internal_ufbgc_order_key * keys = (internal_ufbgc_order_key *) malloc(run->len * sizeof(internal_ufbgc_order_key));
+    if(keys == NULL){
+        return;
+    }
+    for(size_t i = 0; i < run->len; ++i){
+        const internal_ufbgc_history_entry * entry = ufbgc_history_find(history,run->test_list[run->indices[i]].name);
+        keys[i].index = run->indices[i];
+        if(order == UFBGC_ORDER_FAILED_FIRST){
+            keys[i].key = entry == NULL ? 1 : (entry->last_failed_run ? (double) entry->last_failed_run + 1 : 0);
+        }
+        else{
+            keys[i].key = entry == NULL ? INFINITY : entry->duration;
+        }
+    }
+    qsort(keys,run->len,sizeof(internal_ufbgc_order_key),ufbgc_order_compare);
+    for(size_t i = 0; i < run->len; ++i){
+        run->indices[i] = keys[i].index;
+    }
+    free(keys);
+}
+
+/*
+    Result cache keeps the keys of the frames which passed, a frame whose key is found is reported as [CACHED] without running
+    Key is a hash of the executable (or --cache-key), the frame name, version and options, and the values of every iteration
+    File format is "UFBGCCA1", uint32 entry count, and for every entry sorted by key: uint64 key, uint64 last use (unix seconds)
+*/
+#define UFBGC_CACHE_MAGIC "UFBGCCA1"
+#define UFBGC_CACHE_MAX_AGE (30 * 24 * 3600)   //Entries which are not used for 30 days are dropped
+
+typedef struct{
+    uint64_t key;
+    uint64_t last_used;
+}internal_ufbgc_cache_entry;
+
+typedef struct{
+    internal_ufbgc_cache_entry * entries;
+    size_t len;
+    size_t sorted_len;              //Entries before this are sorted by key
+    size_t capacity;
+}internal_ufbgc_cache;
+
+static int ufbgc_cache_compare(const void * a, const void * b){
+    uint64_t ka = ((const internal_ufbgc_cache_entry *) a)->key;
+    uint64_t kb = ((const internal_ufbgc_cache_entry *) b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+static internal_ufbgc_cache_entry * ufbgc_cache_find(const internal_ufbgc_cache * cache, uint64_t key){
+    internal_ufbgc_cache_entry entry = {key,0};
+    if(cache->sorted_len == 0){
+        return NULL;
+    }
+    return (internal_ufbgc_cache_entry *) bsearch(&entry,cache->entries,cache->sorted_len,sizeof(entry),ufbgc_cache_compare);
+}
+
+static bool ufbgc_cache_add(internal_ufbgc_cache * cache, uint64_t key, uint64_t last_used){
+    if(cache->len == cache->capacity){
+        size_t capacity = cache->capacity ? cache->capacity * 2 : 256;
+        internal_ufbgc_cache_entry * entries = (internal_ufbgc_cache_entry *) realloc(cache->entries,capacity * sizeof(*entries));
+        if(entries == NULL){
+            return false;
+        }
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+    cache->entries[cache->len].key = key;
+    cache->entries[cache->len].last_used = last_used;
+    cache->len++;
+    return true;
+}
+
+static void ufbgc_cache_free(internal_ufbgc_cache * cache){
+    free(cache->entries);
+    memset(cache,0,sizeof(*cache));
+}
+
+static bool ufbgc_cache_load(internal_ufbgc_cache * cache, const char * path){
+    FILE * fl = fopen(path,"rb");
+    if(fl == NULL){
+        return false;
+    }
+    char magic[8];
+    uint32_t no_entries = 0;
+    bool ok = fread(magic,1,8,fl) == 8 && !memcmp(magic,UFBGC_CACHE_MAGIC,8) && fread(&no_entries,sizeof(no_entries),1,fl) == 1;
+    for(uint32_t i = 0; ok && i < no_entries; ++i){
+        internal_ufbgc_cache_entry entry;
+        ok = fread(&entry.key,sizeof(entry.key),1,fl) == 1 && fread(&entry.last_used,sizeof(entry.last_used),1,fl) == 1;
+        ok = ok && ufbgc_cache_add(cache,entry.key,entry.last_used);
+    }
+    fclose(fl);
+    if(!ok){
+        ufbgc_cache_free(cache);
+        return false;
+    }
+    qsort(cache->entries,cache->len,sizeof(internal_ufbgc_cache_entry),ufbgc_cache_compare);
+    cache->sorted_len = cache->len;
+    return true;
+}
+
+static bool ufbgc_cache_save(internal_ufbgc_cache * cache, const char * path, uint64_t now){
+    qsort(cache->entries,cache->len,sizeof(internal_ufbgc_cache_entry),ufbgc_cache_compare);
+    size_t len = 0;
+    for(size_t i = 0; i < cache->len; ++i){
+        const internal_ufbgc_cache_entry * entry = &cache->entries[i];
+        if(now - entry->last_used > UFBGC_CACHE_MAX_AGE || (len > 0 && cache->entries[len - 1].key == entry->key)){
+            continue;
+        }
+        cache->entries[len++] = *entry;
+    }
+    cache->len = cache->sorted_len = len;
+
+    char * tmp_path;
+    FILE * fl = ufbgc_open_atomic(path,&tmp_path);
+    uint32_t no_entries = (uint32_t) len;
+    bool ok = fl != NULL && fwrite(UFBGC_CACHE_MAGIC,1,8,fl) == 8 && fwrite(&no_entries,sizeof(no_entries),1,fl) == 1;
+    for(size_t i = 0; ok && i < len; ++i){
+        ok = fwrite(&cache->entries[i].key,sizeof(uint64_t),1,fl) == 1 && fwrite(&cache->entries[i].last_used,sizeof(uint64_t),1,fl) == 1;
+    }
+    return ufbgc_close_atomic(fl,tmp_path,path,ok);
+}
+
+static uint64_t ufbgc_hash_string(uint64_t hash, const char * str){
+    static const unsigned char null_marker = 0xff;
+    return str != NULL ? ufbgc_hash_bytes(hash,str,strlen(str) + 1) : ufbgc_hash_bytes(hash,&null_marker,1);
+}
+
+static bool ufbgc_hash_file(uint64_t * hash, const char * path){
+    FILE * fl = path != NULL ? fopen(path,"rb") : NULL;
+    if(fl == NULL){
+        return false;
+    }
+    unsigned char buffer[65536];
+    size_t n;
+    while((n = fread(buffer,1,sizeof(buffer),fl)) > 0){
+        *hash = ufbgc_hash_bytes(*hash,buffer,n);
+    }
+    bool ok = !ferror(fl);
+    fclose(fl);
+    return ok;
+}
+
+//Untyped values have no known size, they are part of the executable and covered by its hash
+static uint64_t ufbgc_hash_values(uint64_t hash, ufbgc_param_type_t type, const void * values, size_t count){
+    hash = ufbgc_hash_bytes(hash,&type,sizeof(type));
+    hash = ufbgc_hash_bytes(hash,&count,sizeof(count));
+    if(values == NULL){
+        return hash;
+    }
+    switch(type){
+        case UFBGC_PARAM_INT:
+            return ufbgc_hash_bytes(hash,values,count * sizeof(int));
+        case UFBGC_PARAM_DOUBLE:
+            return ufbgc_hash_bytes(hash,values,count * sizeof(double));
+        case UFBGC_PARAM_STRING:
+            for(size_t i = 0; i < count; ++i){
+                hash = ufbgc_hash_string(hash,((const char * const *) values)[i]);
+            }
+            return hash;
+        case UFBGC_PARAM_BLOB:
+            for(size_t i = 0; i < count; ++i){
+                const ufbgc_blob * blob = &((const ufbgc_blob *) values)[i];
+                hash = ufbgc_hash_bytes(hash,&blob->size,sizeof(blob->size));
+                hash = ufbgc_hash_bytes(hash,blob->data,blob->data != NULL ? blob->size : 0);
+            }
+            return hash;
+        case UFBGC_PARAM_UNTYPED:
+            break;
+    }
+    return hash;
+}
+
+//Values of files are hashed with their content, frame is not cacheable if a file can't be read
+static bool ufbgc_hash_generator(uint64_t * hash, const ufbgc_generator * gen){
+    *hash = ufbgc_hash_bytes(*hash,&gen->kind,sizeof(gen->kind));
+    *hash = ufbgc_hash_string(*hash,gen->key);
+    *hash = ufbgc_hash_bytes(*hash,&gen->type,sizeof(gen->type));
+    switch(gen->kind){
+        case UFBGC_GENERATOR_INT_RANGE:
+            *hash = ufbgc_hash_bytes(*hash,&gen->int_range,sizeof(gen->int_range));
+            return true;
+        case UFBGC_GENERATOR_DOUBLE_RANGE:
+            *hash = ufbgc_hash_bytes(*hash,&gen->double_range,sizeof(gen->double_range));
+            return true;
+        case UFBGC_GENERATOR_VALUES:
+            *hash = ufbgc_hash_values(*hash,gen->type,gen->values.values,gen->values.count);
+            return true;
+        case UFBGC_GENERATOR_FILE:
+            *hash = ufbgc_hash_string(*hash,gen->path);
+            return ufbgc_hash_file(hash,gen->path);
+        case UFBGC_GENERATOR_CARTESIAN:
+        case UFBGC_GENERATOR_ZIP:
+            *hash = ufbgc_hash_bytes(*hash,&gen->combine.count,sizeof(gen->combine.count));
+            for(size_t i = 0; i < gen->combine.count; ++i){
+                if(!ufbgc_hash_generator(hash,gen->combine.generators[i])){
+                    return false;
+                }
+            }
+            return true;
+    }
+    return false;
+}
+
+//Benchmarks, stress tests, profiled and skipped frames are never cached
+static bool ufbgc_cache_frame_key(uint64_t fingerprint, const ufbgc_test_frame * tframe, uint64_t * key){
+    if((tframe->option & (PASS_TEST | BENCHMARK_TEST | STRESS_TEST | PROFILE_STACKS)) || runner_options.profile){
+        return false;
+    }
+    //Time and memory budgets depend on the machine, an allocation budget is a part of the key
+    if(tframe->budget.wall_ms > 0 || tframe->budget.cpu_ms > 0 || ufbgc_budget_checked(&tframe->budget,tframe->budget.rss_growth,UFBGC_BUDGET_RSS_GROWTH)){
+        return false;
+    }
+    uint64_t hash = ufbgc_hash_bytes(0xcbf29ce484222325ull,&fingerprint,sizeof(fingerprint));
+    hash = ufbgc_hash_string(hash,tframe->name);
+    hash = ufbgc_hash_string(hash,tframe->version);
+    hash = ufbgc_hash_bytes(hash,&tframe->option,sizeof(tframe->option));
+    if(ufbgc_budget_checked(&tframe->budget,tframe->budget.allocs,UFBGC_BUDGET_ALLOCS)){
+        hash = ufbgc_hash_bytes(hash,&tframe->budget.allocs,sizeof(tframe->budget.allocs));
+    }
+    if(tframe->parameters != NULL){
+        const ufbgc_test_parameters * params = tframe->parameters;
+        hash = ufbgc_hash_bytes(hash,&params->no_iteration,sizeof(params->no_iteration));
+        for(const ufbgc_args * arg = params->parameters; arg->key != NULL; ++arg){
+            hash = ufbgc_hash_string(hash,arg->key);
+            hash = ufbgc_hash_values(hash,arg->type,arg->value,params->no_iteration);
+        }
+    }
+    if(tframe->generator != NULL && !ufbgc_hash_generator(&hash,tframe->generator)){
+        return false;
+    }
+    *key = hash;
+    return true;
+}
+
+//Executable is hashed when no fingerprint is given, code of shared libraries is not part of it
+static bool ufbgc_cache_fingerprint(uint64_t * fingerprint){
+    *fingerprint = 0xcbf29ce484222325ull;
+    if(runner_options.cache_fingerprint != NULL){
+        *fingerprint = ufbgc_hash_string(*fingerprint,runner_options.cache_fingerprint);
+        return true;
+    }
+    #ifdef __linux__
+        return ufbgc_hash_file(fingerprint,"/proc/self/exe");
+    #else
+        return false;
+    #endif
+}
+
+//Results are pre-set before the frames run, runners print [CACHED] for them
+static size_t ufbgc_cache_lookup(internal_ufbgc_cache * cache, internal_ufbgc_test_run * run, uint64_t fingerprint, uint64_t now){
+    size_t hits = 0;
+    for(size_t i = 0; i < run->len; ++i){
+        internal_ufbgc_test_result * result = &run->results[i];
+        result->cacheable = ufbgc_cache_frame_key(fingerprint,&run->test_list[run->indices[i]],&result->cache_key);
+        internal_ufbgc_cache_entry * entry = result->cacheable ? ufbgc_cache_find(cache,result->cache_key) : NULL;
+        if(entry != NULL){
+            entry->last_used = now;
+            result->cached = true;
+            hits++;
+        }
+    }
+    return hits;
+}
+
+//Frames which drew random numbers may fail with another seed and golden files may change, they are run every time
+static void ufbgc_cache_update(internal_ufbgc_cache * cache, const internal_ufbgc_test_run * run, uint64_t now){
+    for(size_t i = 0; i < run->len; ++i){
+        const internal_ufbgc_test_result * result = &run->results[i];
+        if(result->tframe != NULL && result->cacheable && !result->cached && !result->used_random && !result->used_golden &&
+            !result->crashed && result->test_result == UFBGC_OK && !ufbgc_result_failed(result)){
+            ufbgc_cache_add(cache,result->cache_key,now);
+        }
+    }
+}
+
+//'*' matches any run of characters and '?' a single character, the last '*' is retried on a mismatch
+static bool ufbgc_glob_match(const char * pattern, size_t pattern_len, const char * str, size_t str_len){
+    size_t p = 0, s = 0, star = (size_t) -1, star_s = 0;
+    while(s < str_len){
+        if(p < pattern_len && (pattern[p] == '?' || pattern[p] == str[s])){
+            p++;
+            s++;
+        }
+        else if(p < pattern_len && pattern[p] == '*'){
+            star = p++;
+            star_s = s;
+        }
+        else if(star != (size_t) -1){
+            p = star + 1;
+            s = ++star_s;
+        }
+        else{
+            return false;
+        }
+    }
+    while(p < pattern_len && pattern[p] == '*'){
+        p++;
+    }
+    return p == pattern_len;
+}
+
+static bool ufbgc_is_list_separator(char c){
+    return c == ',' || c == ' ';
+}
+
+//Calls match for every item of a comma separated list until it returns true
+static bool ufbgc_any_item(const char * list, bool (*match)(const char * item, size_t item_len, const void * arg), const void * arg){
+    while(list != NULL && *list != '\0'){
+        while(ufbgc_is_list_separator(*list)){
+            list++;
+        }
+        size_t len = 0;
+        while(list[len] != '\0' && !ufbgc_is_list_separator(list[len])){
+            len++;
+        }
+        if(len > 0 && match(list,len,arg)){
+            return true;
+        }
+        list += len;
+    }
+    return false;
+}
+
+typedef struct{
+    const char * pattern;
+    size_t pattern_len;
+}internal_ufbgc_glob;
+
+static bool ufbgc_match_tag(const char * tag, size_t tag_len, const void * arg){
+    const internal_ufbgc_glob * glob = (const internal_ufbgc_glob *) arg;
+    return ufbgc_glob_match(glob->pattern,glob->pattern_len,tag,tag_len);
+}
+
+typedef struct{
+    const char * name;              //Name of the frame, NULL matches against the tags
+    const char * tags;
+    bool exclude;                   //Only the patterns with '-' are checked, otherwise only the ones without
+}internal_ufbgc_filter_match;
+
+static bool ufbgc_match_filter(const char * pattern, size_t pattern_len, const void * arg){
+    const internal_ufbgc_filter_match * filter = (const internal_ufbgc_filter_match *) arg;
+    if((pattern[0] == '-') != filter->exclude){
+        return false;
+    }
+    if(filter->exclude){
+        pattern++;
+        pattern_len--;
+    }
+    if(filter->name != NULL){
+        return ufbgc_glob_match(pattern,pattern_len,filter->name,strlen(filter->name));
+    }
+    internal_ufbgc_glob glob = {pattern,pattern_len};
+    return ufbgc_any_item(filter->tags,ufbgc_match_tag,&glob);
+}
+
+static bool ufbgc_has_included(const char * pattern, size_t pattern_len, const void * arg){
+    (void) pattern_len;
+    (void) arg;
+    return pattern[0] != '-';
+}
+
+//Filter passes if there is no include pattern or one of them matches, and no exclude pattern matches
+static bool ufbgc_filter_passes(const char * filter, const char * name, const char * tags){
+    if(filter == NULL){
+        return true;
+    }
+    internal_ufbgc_filter_match include = {name,tags,false};
+    internal_ufbgc_filter_match exclude = {name,tags,true};
+    if(ufbgc_any_item(filter,ufbgc_match_filter,&exclude)){
+        return false;
+    }
+    return !ufbgc_any_item(filter,ufbgc_has_included,NULL) || ufbgc_any_item(filter,ufbgc_match_filter,&include);
+}
+
+static bool ufbgc_frame_selected(const ufbgc_test_frame * tframe){
+    return ufbgc_filter_passes(runner_options.name_filter,tframe->name,NULL) &&
+        ufbgc_filter_passes(runner_options.tag_filter,NULL,tframe->tags);
+}
+
+//Listing does not build fixtures or run setup functions
+static void ufbgc_list_frames(const internal_ufbgc_test_run * run){
+    for(size_t i = 0; i < run->len; ++i){
+        const ufbgc_test_frame * tframe = &run->test_list[run->indices[i]];
+        if(tframe->tags != NULL && tframe->tags[0] != '\0'){
+            fprintf(stdout,"%s [%s]\n",tframe->name,tframe->tags);
+        }
+        else{
+            fprintf(stdout,"%s\n",tframe->name);
+        }
+    }
+    fflush(stdout);
+}
+
+/*
+    Selects the frames to run, frames after the first frame without a test function are not run
+    and only the frames of the current shard which pass the name and tag filters are selected
+*/
+static bool ufbgc_prepare_run(internal_ufbgc_test_run * run, const ufbgc_test_frame * test_list, size_t list_len){
+    run->test_list = test_list;
+    run->len = 0;
+    run->indices = (size_t*) malloc(sizeof(size_t) * (list_len ? list_len : 1));
+    run->results = (internal_ufbgc_test_result*) calloc(list_len ? list_len : 1, sizeof(internal_ufbgc_test_result));
+    if(run->indices == NULL || run->results == NULL){
+        free(run->indices);
+        free(run->results);
+        return false;
+    }
+
+    for(size_t i = 0; i < list_len && test_list[i].test_f != NULL; ++i){
+        if(i % runner_options.shard_count == runner_options.shard_index && ufbgc_frame_selected(&test_list[i])){
+            run->indices[run->len++] = i;
+        }
+    }
+    return true;
+}
+
+static ufbgc_return_t ufbgc_execute(const ufbgc_test_frame * test_list, size_t list_len, size_t n_threads, size_t n_processes){
+
+    __ufbgc_internal_assert_(test_list != NULL,"Test frame pointer is NULL");
+    __ufbgc_internal_assert_(list_len > 0,"Test list length must be bigger than zero");
+
+    internal_ufbgc_test_run run;
+    __ufbgc_internal_assert_(ufbgc_prepare_run(&run,test_list,list_len),"Can't allocate test run");
+
+    internal_ufbgc_history history;
+    memset(&history,0,sizeof(history));
+    bool history_exists = runner_options.history_path != NULL && ufbgc_history_load(&history,runner_options.history_path);
+    history.run++;
+
+    if(runner_options.list){
+        ufbgc_list_frames(&run);
+        ufbgc_history_free(&history);
+        free(run.indices);
+        free(run.results);
+        return UFBGC_OK;
+    }
+
+    if(n_threads == 0) n_threads = ufbgc_online_cpus();
+    if(n_threads > run.len) n_threads = run.len;
+    if(n_processes > run.len) n_processes = run.len;
+    #ifdef UFBGC_POSIX
+        //Hung test on a worker thread can't be stopped without ending the run, workers with deadlines are processes
+        bool deadline_processes = n_processes == 0 && n_threads > 1 && ufbgc_run_has_deadline(&run);
+        if(deadline_processes){
+            n_processes = n_threads;
+        }
+    #endif
+
+    ufbgc_print_magenta(stdout,"ufbgc - starting tests");
+    if(runner_options.shard_count > 1){
+        ufbgc_print_magenta(stdout," (shard %lu/%lu)",runner_options.shard_index,runner_options.shard_count);
+    }
+    if(n_processes > 0){
+        ufbgc_print_magenta(stdout," (%lu worker processes)",n_processes);
+    }
+    else if(n_threads > 1){
+        ufbgc_print_magenta(stdout," (%lu workers)",n_threads);
+    }
+    ufbgc_print_magenta(stdout,"\n");
+    #ifdef UFBGC_POSIX
+        if(deadline_processes){
+            ufbgc_print_yellow(stdout,"ufbgc - frames have deadlines, workers are processes as with --isolate\n");
+        }
+    #endif
+    #ifdef __linux__
+        internal_ufbgc_runner_policy runner_policy;
+        ufbgc_apply_runner_policy(&runner_policy);
+    #else
+        if(runner_options.no_pin_cpus > 0 || runner_options.fifo_priority > 0 || runner_options.nice_given){
+            ufbgc_print_yellow(stdout,"ufbgc - pinning and scheduling of the runner need Linux, they are ignored\n");
+        }
+    #endif
+    ufbgc_collect_environment(&run_environment);
+    ufbgc_print_magenta(stdout,"ufbgc - %s (%lu cpus), %s",run_environment.cpu_model,run_environment.online_cpus,run_environment.kernel);
+    if(run_environment.governor[0] != '\0'){
+        ufbgc_print_magenta(stdout,", governor '%s'",run_environment.governor);
+    }
+    ufbgc_print_magenta(stdout,"\nufbgc - %s, %s\n",run_environment.compiler,run_environment.compile_flags);
+    if(runner_options.no_pin_cpus > 0 || runner_options.fifo_priority > 0 || runner_options.nice_given){
+        char policy[256] = "";
+        size_t len = 0;
+        if(runner_options.no_pin_cpus > 0){
+            char cpus[128] = "";
+            size_t cpus_len = 0;
+            for(size_t i = 0; i < runner_options.no_pin_cpus && cpus_len + 12 < sizeof(cpus); ++i){
+                cpus_len += (size_t) snprintf(cpus + cpus_len,sizeof(cpus) - cpus_len,i == 0 ? "%d" : ",%d",runner_options.pin_cpus[i]);
+            }
+            ufbgc_list_append(policy,sizeof(policy),&len,"pinned to cpu %s",cpus);
+        }
+        if(runner_options.fifo_priority > 0){
+            ufbgc_list_append(policy,sizeof(policy),&len,"SCHED_FIFO priority %d",runner_options.fifo_priority);
+        }
+        if(runner_options.nice_given){
+            ufbgc_list_append(policy,sizeof(policy),&len,"nice %d",runner_options.nice);
+        }
+        ufbgc_print_magenta(stdout,"ufbgc - runner %s\n",policy);
+    }
+    if(ufbgc_get_cycle_frequency() > 0){
+        ufbgc_print_magenta(stdout,"ufbgc - cycle counter @ %.3f GHz\n",ufbgc_get_cycle_frequency() / 1e9);
+    }
+    if(!runner_options.seed_given){
+        uint64_t x = ufbgc_get_unix_time_ns() ^ ufbgc_get_wall_time_ns();
+        #ifdef UFBGC_POSIX
+            x ^= (uint64_t) getpid() << 32;
+        #endif
+        runner_options.seed = ufbgc_splitmix64(&x);
+    }
+    ufbgc_print_magenta(stdout,"ufbgc - random seed 0x%016llx\n",(unsigned long long) runner_options.seed);
+    ufbgc_order_run(&run,&history,runner_options.order);
+    ufbgc_fixtures_count_users(&run,NULL,run.len);
+    if(run.len == 0){
+        ufbgc_print_yellow(stdout,"ufbgc - no test is selected\n");
+    }
+
+    bool baseline_exists = false;
+    if(runner_options.baseline_path != NULL){
+        baseline_exists = ufbgc_baseline_load(&baseline_loaded,runner_options.baseline_path);
+        if(baseline_exists){
+            ufbgc_print_magenta(stdout,"ufbgc - comparing with baseline '%s' (%lu entries)\n",runner_options.baseline_path,baseline_loaded.len);
+        }
+        else{
+            ufbgc_baseline_free(&baseline_loaded);
+            ufbgc_print_magenta(stdout,"ufbgc - no baseline at '%s', it will be created\n",runner_options.baseline_path);
+        }
+    }
+    internal_ufbgc_cache cache;
+    memset(&cache,0,sizeof(cache));
+    uint64_t cache_now = ufbgc_get_unix_time_ns() / 1000000000ull;
+    bool cache_enabled = false;
+    if(runner_options.cache_path != NULL){
+        uint64_t fingerprint;
+        cache_enabled = ufbgc_cache_fingerprint(&fingerprint);
+        if(!cache_enabled){
+            ufbgc_print_red(stdout,"ufbgc - can't fingerprint the executable, use --cache-key, result cache is disabled\n");
+        }
+        else{
+            bool cache_exists = ufbgc_cache_load(&cache,runner_options.cache_path);
+            size_t hits = ufbgc_cache_lookup(&cache,&run,fingerprint,cache_now);
+            ufbgc_print_magenta(stdout,"ufbgc - result cache '%s' (%lu entries%s), %lu of %lu tests cached\n",runner_options.cache_path,
+                cache.len,cache_exists ? "" : ", new",hits,run.len);
+        }
+    }
+    if(runner_options.history_path != NULL){
+        static const char * order_names[] = {"declared","failed-first","longest-first","random"};
+        if(history_exists){
+            ufbgc_print_magenta(stdout,"ufbgc - history '%s' (%lu tests, run %lu), %s order\n",runner_options.history_path,history.len,
+                (unsigned long) history.run,order_names[runner_options.order]);
+        }
+        else{
+            ufbgc_print_magenta(stdout,"ufbgc - no history at '%s', it will be created\n",runner_options.history_path);
+        }
+    }
+    ufbgc_print_magenta(stdout,"\n");
+
+    for(size_t i = 0; i < run.len; ++i){
+        const ufbgc_test_frame * tframe = &run.test_list[run.indices[i]];
+        if(tframe->output_file != NULL && !ufbgc_open_output_file(tframe->output_file) && n_processes + n_threads > 1){
+            ufbgc_print_red(stdout,"Can't open file:%s\n",tframe->output_file);
+        }
+    }
+
+    ufbgc_report_run_start(run.len);
+
+    //Header must be out before a crash handler writes a frame
+    fflush(stdout);
+
+    #ifdef UFBGC_POSIX
+        ufbgc_install_crash_handlers();
+        if(n_processes > 0){
+            if(!ufbgc_run_processes(&run,n_processes,false)){
+                ufbgc_run_sequential(&run);
+            }
+        }
+        else if(n_threads > 1){
+            ufbgc_run_threads(&run,n_threads);
+        }
+        else{
+            ufbgc_run_sequential(&run);
+        }
+    #else
+        ufbgc_run_sequential(&run);
+    #endif
+
+    size_t not_run = 0;
+    for(size_t i = 0; i < run.len; ++i){
+        if(run.results[i].tframe == NULL) not_run++;
+    }
+    if(not_run > 0){
+        ufbgc_print_red(stdout,"ufbgc - stopped after the first failure (%lu tests not run)\n",not_run);
+    }
+    ufbgc_print_magenta(stdout,"ufbgc - tests completed\n\n");
+
+    #ifdef UFBGC_PRINT_SUMMARY
+    ufbgc_print_summary(run.results,run.len);
+    #endif
+
+    ufbgc_fixtures_finish();
+
+    ufbgc_return_t run_result = UFBGC_OK;
+    for(size_t i = 0; i < run.len; ++i){
+        if(ufbgc_result_failed(&run.results[i])){
+            run_result = UFBGC_FAIL;
+        }
+    }
+    ufbgc_report_run_end(run_result);
+    #ifdef __linux__
+        ufbgc_restore_runner_policy(&runner_policy);
+    #endif
+
+    //Baseline is created by the first run, later runs only merge their samples when asked
+    if(runner_options.baseline_path != NULL && (runner_options.update_baseline || !baseline_exists)){
+        for(size_t i = 0; i < baseline_current.len; ++i){
+            const internal_ufbgc_baseline_entry * entry = &baseline_current.entries[i];
+            ufbgc_baseline_add(&baseline_loaded,entry->name,entry->iteration,entry->samples,entry->no_samples);
+        }
+        if(!ufbgc_baseline_save(&baseline_loaded,runner_options.baseline_path)){
+            ufbgc_print_red(stdout,"ufbgc - can't write baseline '%s'\n",runner_options.baseline_path);
+        }
+    }
+    ufbgc_baseline_free(&baseline_loaded);
+    ufbgc_baseline_free(&baseline_current);
+
+    if(cache_enabled){
+        ufbgc_cache_update(&cache,&run,cache_now);
+        if(!ufbgc_cache_save(&cache,runner_options.cache_path,cache_now)){
+            ufbgc_print_red(stdout,"ufbgc - can't write result cache '%s'\n",runner_options.cache_path);
+        }
+    }
+    ufbgc_cache_free(&cache);
+
+    if(runner_options.history_path != NULL){
+        ufbgc_history_update(&history,run.results,run.len);
+        if(!ufbgc_history_save(&history,runner_options.history_path)){
+            ufbgc_print_red(stdout,"ufbgc - can't write history '%s'\n",runner_options.history_path);
+        }
+    }
+    ufbgc_history_free(&history);
+    ufbgc_close_output_files();
+    ufbgc_profile_free_modules();
+
+    free(run.indices);
+    free(run.results);
+
+    return run_result;
+}
+
+ufbgc_return_t ufbgc_start_test(const ufbgc_test_frame * test_list, size_t list_len){
+    return ufbgc_execute(test_list,list_len,runner_options.threads ? runner_options.threads : 1,runner_options.processes);
+}
+
+ufbgc_return_t ufbgc_start_test_parallel(const ufbgc_test_frame * test_list, size_t list_len, size_t n_workers){
+    return ufbgc_execute(test_list,list_len,n_workers,0);
+}
+
+ufbgc_return_t ufbgc_start_test_isolated(const ufbgc_test_frame * test_list, size_t list_len, size_t n_workers){
+    return ufbgc_execute(test_list,list_len,1,n_workers ? n_workers : ufbgc_online_cpus());
+}
+
+static int ufbgc_registration_compare(const void * a, const void * b){
+    const ufbgc_registration * ra = *(const ufbgc_registration * const *) a;
+    const ufbgc_registration * rb = *(const ufbgc_registration * const *) b;
+    int cmp = strcmp(ra->file,rb->file);
+    return cmp != 0 ? cmp : (ra->line > rb->line) - (ra->line < rb->line);
+}
+
+//Section order depends on the linker, registered frames are sorted by file and line so the declared order is stable
+ufbgc_return_t ufbgc_run_registered(const ufbgc_registration * const * begin, const ufbgc_registration * const * end, int argc, char const * argv[]){
+    if(ufbgc_parse_args(argc,argv) != UFBGC_OK){
+        return UFBGC_FAIL;
+    }
+    size_t capacity = begin != NULL && end > begin ? (size_t)(end - begin) : 0;
+    if(capacity == 0){
+        #ifdef UFBGC_AUTO_REGISTRATION
+            ufbgc_print_red(stdout,"ufbgc - no registered tests\n");
+        #else
+            ufbgc_print_red(stdout,"ufbgc - automatic registration is not supported on this target, use ufbgc_start_test\n");
+        #endif
+        return UFBGC_FAIL;
+    }
+
+    const ufbgc_registration ** registrations = (const ufbgc_registration **) malloc(capacity * sizeof(*registrations));
+    ufbgc_test_frame * test_list = (ufbgc_test_frame *) malloc(capacity * sizeof(ufbgc_test_frame));
+    if(registrations == NULL || test_list == NULL){
+        free(registrations);
+        free(test_list);
+        ufbgc_print_red(stdout,"ufbgc - can't allocate the test list\n");
+        return UFBGC_FAIL;
+    }
+    //Sanitizers and linkers may leave empty slots between the registrations
+    size_t len = 0;
+    for(const ufbgc_registration * const * it = begin; it < end; ++it){
+        if(*it != NULL && (*it)->frame != NULL && (*it)->frame->test_f != NULL){
+            registrations[len++] = *it;
+        }
+    }
+    qsort(registrations,len,sizeof(*registrations),ufbgc_registration_compare);
+    for(size_t i = 0; i < len; ++i){
+        test_list[i] = *registrations[i]->frame;
+    }
+    free(registrations);
+
+    ufbgc_return_t result = len > 0 ? ufbgc_execute(test_list,len,runner_options.threads ? runner_options.threads : 1,runner_options.processes) : UFBGC_FAIL;
+    free(test_list);
+    return result;
+}
+
+
+static bool ufbgc_parse_size(const char * str, size_t * value){
+    char * end = NULL;
+    unsigned long long v = strtoull(str,&end,10);
+    if(end == str || *end != '\0'){
+        return false;
+    }
+    *value = (size_t) v;
+    return true;
+}
+
+//Comma separated CPUs and ranges of --pin-cpu, e.g. "2,4-7"
+static bool ufbgc_parse_cpu_list(const char * list){
+    size_t count = 0;
+    const char * c = list;
+    while(true){
+        char * end;
+        long first = strtol(c,&end,10);
+        long last = first;
+        if(end == c || first < 0){
+            return false;
+        }
+        c = end;
+        if(*c == '-'){
+            last = strtol(c + 1,&end,10);
+            if(end == c + 1 || last < first){
+                return false;
+            }
+            c = end;
+        }
+        #ifdef CPU_SETSIZE
+            if(last >= CPU_SETSIZE){
+                return false;
+            }
+        #endif
+        for(long cpu = first; cpu <= last; ++cpu){
+            if(count >= UFBGC_MAX_PINNED_CPUS){
+                return false;
+            }
+            runner_options.pin_cpus[count++] = (int) cpu;
+        }
+        if(*c == '\0'){
+            break;
+        }
+        if(*c != ','){
+            return false;
+        }
+        c++;
+    }
+    runner_options.no_pin_cpus = count;
+    return true;
+}
+
+ufbgc_return_t ufbgc_parse_args(int argc, char const * argv[]){
+    for(int i = 1; i < argc; ++i){
+        const char * arg = argv[i];
+
+        if(!strncmp(arg,"--shard=",8)){
+            size_t index, count;
+            char buffer[64];
+            const char * slash = strchr(arg + 8,'/');
+            size_t len = slash != NULL ? (size_t)(slash - (arg + 8)) : 0;
+            if(slash == NULL || len == 0 || len >= sizeof(buffer)){
+                ufbgc_print_red(stdout,"ufbgc - invalid shard '%s', expected --shard=i/N\n",arg);
+                return UFBGC_FAIL;
+            }
+            memcpy(buffer,arg + 8,len);
+            buffer[len] = '\0';
+            if(!ufbgc_parse_size(buffer,&index) || !ufbgc_parse_size(slash + 1,&count) || count == 0 || index >= count){
+                ufbgc_print_red(stdout,"ufbgc - invalid shard '%s', expected --shard=i/N with i < N\n",arg);
+                return UFBGC_FAIL;
+            }
+            runner_options.shard_index = index;
+            runner_options.shard_count = count;
+        }
+        else if(!strcmp(arg,"--isolate")){
+            runner_options.processes = ufbgc_online_cpus();
+        }
+        else if(!strncmp(arg,"--isolate=",10)){
+            if(!ufbgc_parse_size(arg + 10,&runner_options.processes)){
+                ufbgc_print_red(stdout,"ufbgc - invalid worker count '%s'\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strncmp(arg,"--jobs=",7)){
+            if(!ufbgc_parse_size(arg + 7,&runner_options.threads)){
+                ufbgc_print_red(stdout,"ufbgc - invalid worker count '%s'\n",arg);
+                return UFBGC_FAIL;
+            }
+            //Zero means every online CPU
+            if(runner_options.threads == 0){
+                runner_options.threads = ufbgc_online_cpus();
+            }
+        }
+        else if(!strncmp(arg,"--baseline=",11)){
+            runner_options.baseline_path = arg + 11;
+        }
+        else if(!strcmp(arg,"--update-baseline")){
+            runner_options.update_baseline = true;
+        }
+        else if(!strncmp(arg,"--regression-threshold=",23)){
+            runner_options.regression_threshold = atof(arg + 23);
+        }
+        else if(!strncmp(arg,"--regression-alpha=",19)){
+            runner_options.regression_alpha = atof(arg + 19);
+        }
+        else if(!strncmp(arg,"--regression-min-delta=",23)){
+            runner_options.regression_min_delta_ns = atof(arg + 23) * 1000.0;
+        }
+        else if(!strcmp(arg,"--perf-counters")){
+            runner_options.perf_counters = true;
+        }
+        else if(!strcmp(arg,"--track-allocs")){
+            runner_options.track_allocs = true;
+        }
+        else if(!strncmp(arg,"--report=",9)){
+            //--report=format:path
+            char format[16];
+            const char * path = strchr(arg + 9,':');
+            size_t format_len = path != NULL ? (size_t)(path - (arg + 9)) : 0;
+            if(path == NULL || format_len >= sizeof(format) || path[1] == '\0'){
+                ufbgc_print_red(stdout,"ufbgc - invalid report '%s', expected --report=junit|jsonl|binary:path\n",arg);
+                return UFBGC_FAIL;
+            }
+            memcpy(format,arg + 9,format_len);
+            format[format_len] = '\0';
+            if(!ufbgc_add_report_file(format,path + 1)){
+                ufbgc_print_red(stdout,"ufbgc - invalid report '%s', expected --report=junit|jsonl|binary:path\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strncmp(arg,"--bench-time=",13)){
+            if(!ufbgc_parse_size(arg + 13,&runner_options.bench_time_ms)){
+                ufbgc_print_red(stdout,"ufbgc - invalid benchmark time '%s'\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strncmp(arg,"--bench-warmup=",15)){
+            if(!ufbgc_parse_size(arg + 15,&runner_options.bench_warmup_ms)){
+                ufbgc_print_red(stdout,"ufbgc - invalid benchmark warm-up time '%s'\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strncmp(arg,"--seed=",7)){
+            char * end = NULL;
+            errno = 0;
+            runner_options.seed = strtoull(arg + 7,&end,0);
+            if(arg[7] == '\0' || *end != '\0' || errno != 0){
+                ufbgc_print_red(stdout,"ufbgc - invalid seed '%s'\n",arg);
+                return UFBGC_FAIL;
+            }
+            runner_options.seed_given = true;
+        }
+        else if(!strncmp(arg,"--property-runs=",16)){
+            if(!ufbgc_parse_size(arg + 16,&runner_options.property_runs) || runner_options.property_runs == 0){
+                ufbgc_print_red(stdout,"ufbgc - invalid property run count '%s'\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strncmp(arg,"--bench-samples=",16)){
+            if(!ufbgc_parse_size(arg + 16,&runner_options.bench_samples) || runner_options.bench_samples == 0){
+                ufbgc_print_red(stdout,"ufbgc - invalid benchmark sample count '%s'\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strncmp(arg,"--history=",10)){
+            runner_options.history_path = arg + 10;
+        }
+        else if(!strncmp(arg,"--order=",8)){
+            if(!strcmp(arg + 8,"declared")){
+                runner_options.order = UFBGC_ORDER_DECLARED;
+            }
+            else if(!strcmp(arg + 8,"failed-first")){
+                runner_options.order = UFBGC_ORDER_FAILED_FIRST;
+            }
+            else if(!strcmp(arg + 8,"longest-first")){
+                runner_options.order = UFBGC_ORDER_LONGEST_FIRST;
+            }
+            else if(!strcmp(arg + 8,"random")){
+                runner_options.order = UFBGC_ORDER_RANDOM;
+            }
+            else{
+                ufbgc_print_red(stdout,"ufbgc - invalid order '%s', expected --order=declared|failed-first|longest-first|random\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strcmp(arg,"--fail-fast")){
+            runner_options.fail_fast = true;
+        }
+        else if(!strcmp(arg,"--list")){
+            runner_options.list = true;
+        }
+        else if(!strncmp(arg,"--filter=",9)){
+            runner_options.name_filter = arg + 9;
+        }
+        else if(!strncmp(arg,"--tag=",6)){
+            runner_options.tag_filter = arg + 6;
+        }
+        else if(!strncmp(arg,"--cache=",8)){
+            runner_options.cache_path = arg + 8;
+        }
+        else if(!strncmp(arg,"--cache-key=",12)){
+            runner_options.cache_fingerprint = arg + 12;
+        }
+        else if(!strncmp(arg,"--pin-cpu=",10)){
+            if(!ufbgc_parse_cpu_list(arg + 10)){
+                ufbgc_print_red(stdout,"ufbgc - invalid cpu list '%s', expected --pin-cpu=2 or --pin-cpu=2,4-7\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strncmp(arg,"--sched=",8)){
+            //--sched=fifo or --sched=fifo:priority
+            const char * policy = arg + 8;
+            long priority = 1;
+            char * end = NULL;
+            if(!strncmp(policy,"fifo:",5)){
+                priority = strtol(policy + 5,&end,10);
+            }
+            bool valid = !strcmp(policy,"fifo") || (end != NULL && end != policy + 5 && *end == '\0');
+            if(!valid || priority < 1 || priority > 99){
+                ufbgc_print_red(stdout,"ufbgc - invalid scheduler '%s', expected --sched=fifo or --sched=fifo:1..99\n",arg);
+                return UFBGC_FAIL;
+            }
+            runner_options.fifo_priority = (int) priority;
+        }
+        else if(!strcmp(arg,"--profile")){
+            runner_options.profile = true;
+        }
+        else if(!strncmp(arg,"--profile=",10)){
+            runner_options.profile = true;
+            runner_options.profile_dir = arg + 10;
+        }
+        else if(!strncmp(arg,"--profile-hz=",13)){
+            if(!ufbgc_parse_size(arg + 13,&runner_options.profile_hz) || runner_options.profile_hz == 0 || runner_options.profile_hz > 100000){
+                ufbgc_print_red(stdout,"ufbgc - invalid profile frequency '%s', expected 1..100000\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strncmp(arg,"--timeout=",10)){
+            if(!ufbgc_parse_size(arg + 10,&runner_options.timeout_ms)){
+                ufbgc_print_red(stdout,"ufbgc - invalid timeout '%s', expected milliseconds\n",arg);
+                return UFBGC_FAIL;
+            }
+        }
+        else if(!strncmp(arg,"--nice=",7)){
+            char * end = NULL;
+            long nice = strtol(arg + 7,&end,10);
+            if(arg[7] == '\0' || *end != '\0' || nice < -20 || nice > 19){
+                ufbgc_print_red(stdout,"ufbgc - invalid nice value '%s', expected -20..19\n",arg);
+                return UFBGC_FAIL;
+            }
+            runner_options.nice = (int) nice;
+            runner_options.nice_given = true;
+        }
+    }
+    if((runner_options.order == UFBGC_ORDER_FAILED_FIRST || runner_options.order == UFBGC_ORDER_LONGEST_FIRST) && runner_options.history_path == NULL){
+        ufbgc_print_red(stdout,"ufbgc - --order needs the history of the earlier runs, use --history=path\n");
+        return UFBGC_FAIL;
+    }
+    return UFBGC_OK;
+}
+
+ufbgc_log_verbosity_t ufbgc_get_current_test_verbosity(){
+    if(current_test_frame.frame != NULL){
+        return current_test_frame.frame->log_level;
+    }
+    return UFBGC_LOG_ERROR;
+}
+
+FILE * ufbgc_get_current_test_file(){
+    if(current_test_frame.frame != NULL && current_test_frame.output_file != NULL){
+        return current_test_frame.output_file;
+    }
+    return stdout;
+}
+
+int ufbgc_pass_reporting = 0;
+
+//Assertion line is printed with a single call: condition  -->  type passed/failed @[file/function:line]
+#define UFBGC_ASSERT_LINE(color,line_color,result)                                                                 \
+    color "%s" ANSI_COLOR_RESET color "  -->  %s " result " @[" ANSI_COLOR_RESET line_color "%s/%s:%u" ANSI_COLOR_RESET  \
+    color "]\n" ANSI_COLOR_RESET
+
+static bool ufbgc_assert_failed_v(ufbgc_log_verbosity_t log_level, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, va_list format_args){
+
+    if(ufbgc_get_current_test_verbosity() < log_level){
+        return false;
+    }
+    if(current_test_frame.quiet){
+        return true;
+    }
+    FILE * fl = ufbgc_get_current_test_file();
+    fprintf(fl,UFBGC_COLORED(fl) ? UFBGC_ASSERT_LINE(ANSI_COLOR_BLACK,ANSI_COLOR_RED_UNDERLINE,"failed") : "%s  -->  %s failed @[%s/%s:%u]\n",
+        condition,type,file,function,line);
+    char stress[64] = "";
+    if(current_test_frame.stress_threads > 0){
+        snprintf(stress,sizeof(stress),"[thread %lu, round %lu]",
+            (unsigned long) current_test_frame.stress_thread,(unsigned long) current_test_frame.stress_round);
+        ufbgc_print_yellow(fl,"  %s\n",stress);
+    }
+
+    if(current_test_frame.events != NULL){
+        char message[1024] = "";
+        int len = stress[0] != '\0' ? snprintf(message,sizeof(message),"%s ",stress) : 0;
+        if(format[0] != '\0'){
+            va_list args;
+            va_copy(args,format_args);
+            vsnprintf(message + len,sizeof(message) - (size_t) len,format,args);
+            va_end(args);
+        }
+        ufbgc_event event;
+        memset(&event,0,sizeof(event));
+        event.type = UFBGC_EVENT_ASSERT_FAIL;
+        event.test = current_test_frame.frame->name;
+        event.iteration = current_test_frame.frame_iterator;
+        event.log_level = log_level;
+        event.assert_type = type;
+        event.condition = condition;
+        event.file = file;
+        event.function = function;
+        event.line = line;
+        event.message = message;
+        ufbgc_emit_event(&event);
+    }
+    if(format[0] != '\0'){
+        va_list args;
+        va_copy(args,format_args);
+        bool colored = UFBGC_COLORED(fl);
+        ufbgc_print_colored(fl,ANSI_COLOR_YELLOW,"\nNote:{");
+        if(colored) fputs(ANSI_COLOR_BLUE,fl);
+        vfprintf(fl,format,args);
+        if(colored) fputs(ANSI_COLOR_RESET,fl);
+        ufbgc_print_colored(fl,ANSI_COLOR_YELLOW,"}\n\n");
+        va_end(args);
+    }
+    return true;
+}
+
+UFBGC_COLD bool ufbgc_assert_failed(ufbgc_log_verbosity_t log_level, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, ...){
+    va_list args;
+    va_start(args,format);
+    bool failed = ufbgc_assert_failed_v(log_level,type,condition,file,function,line,format,args);
+    va_end(args);
+    return failed;
+}
+
+UFBGC_COLD void ufbgc_assert_passed(const char * type, const char * condition, const char * file, const char * function, unsigned line){
+    if(ufbgc_get_current_test_verbosity() < UFBGC_LOG_INFO || current_test_frame.quiet){
+        return;
+    }
+    FILE * fl = ufbgc_get_current_test_file();
+    fprintf(fl,UFBGC_COLORED(fl) ? UFBGC_ASSERT_LINE(ANSI_COLOR_GREEN,ANSI_COLOR_GREEN_UNDERLINE,"passed") : "%s  -->  %s passed @[%s/%s:%u]\n",
+        condition,type,file,function,line);
+}
+
+/*
+    Mismatch scan keeps the first differing byte and counts the elements with a differing byte
+    mask has a bit for every byte of the block at offset, set if the bytes differ
+*/
+typedef struct{
+    size_t elem_size;
+    size_t first;                   //Byte offset of the first mismatch, SIZE_MAX if there is none
+    size_t mismatches;
+    size_t last_elem;               //Element counted last, an element spans blocks when elem_size > 1
+    bool first_only;                //Scan stops at the first mismatch
+}internal_ufbgc_scan;
+
+static inline void ufbgc_scan_mask(internal_ufbgc_scan * scan, size_t offset, uint64_t mask){
+    if(scan->first == SIZE_MAX){
+        scan->first = offset + (size_t) __builtin_ctzll(mask);
+    }
+    if(scan->elem_size == 1){
+        scan->mismatches += (size_t) __builtin_popcountll(mask);
+        return;
+    }
+    while(mask != 0){
+        size_t elem = (offset + (size_t) __builtin_ctzll(mask)) / scan->elem_size;
+        if(elem != scan->last_elem){
+            scan->last_elem = elem;
+            scan->mismatches++;
+        }
+        mask &= mask - 1;
+    }
+}
+
+static void ufbgc_scan_scalar(internal_ufbgc_scan * scan, const unsigned char * a, const unsigned char * b, size_t offset, size_t size){
+    for(; offset + 8 <= size; offset += 8){
+        uint64_t x, y;
+        memcpy(&x,a + offset,8);
+        memcpy(&y,b + offset,8);
+        if(x != y){
+            uint64_t mask = 0;
+            for(size_t i = 0; i < 8; ++i){
+                mask |= (uint64_t)(a[offset + i] != b[offset + i]) << i;
+            }
+            ufbgc_scan_mask(scan,offset,mask);
+            if(scan->first_only) return;
+        }
+    }
+    for(; offset < size; ++offset){
+        if(a[offset] != b[offset]){
+            ufbgc_scan_mask(scan,offset,1);
+            if(scan->first_only) return;
+        }
+    }
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+//Equal blocks of 128 bytes are skipped with a single test, the scan is bound by memory bandwidth
+__attribute__((target("avx2")))
+static void ufbgc_scan_avx2(internal_ufbgc_scan * scan, const unsigned char * a, const unsigned char * b, size_t size){
+    size_t offset = 0;
+    for(; offset + 128 <= size; offset += 128){
+        __m256i e0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + offset)),_mm256_loadu_si256((const __m256i *)(b + offset)));
+        __m256i e1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + offset + 32)),_mm256_loadu_si256((const __m256i *)(b + offset + 32)));
+        __m256i e2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + offset + 64)),_mm256_loadu_si256((const __m256i *)(b + offset + 64)));
+        __m256i e3 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + offset + 96)),_mm256_loadu_si256((const __m256i *)(b + offset + 96)));
+        __m256i all = _mm256_and_si256(_mm256_and_si256(e0,e1),_mm256_and_si256(e2,e3));
+        if(UFBGC_EXPECT_FALSE((uint32_t) _mm256_movemask_epi8(all) != 0xffffffffu)){
+            uint64_t low = (uint64_t)(uint32_t) ~_mm256_movemask_epi8(e0) | ((uint64_t)(uint32_t) ~_mm256_movemask_epi8(e1) << 32);
+            uint64_t high = (uint64_t)(uint32_t) ~_mm256_movemask_epi8(e2) | ((uint64_t)(uint32_t) ~_mm256_movemask_epi8(e3) << 32);
+            if(low != 0) ufbgc_scan_mask(scan,offset,low);
+            if(high != 0 && !(scan->first_only && low != 0)) ufbgc_scan_mask(scan,offset + 64,high);
+            if(scan->first_only) return;
+        }
+    }
+    for(; offset + 32 <= size; offset += 32){
+        __m256i e = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + offset)),_mm256_loadu_si256((const __m256i *)(b + offset)));
+        uint32_t mask = ~(uint32_t) _mm256_movemask_epi8(e);
+        if(mask != 0){
+            ufbgc_scan_mask(scan,offset,mask);
+            if(scan->first_only) return;
+        }
+    }
+    ufbgc_scan_scalar(scan,a,b,offset,size);
+}
+
+//SSE2 is part of x86-64
+static void ufbgc_scan_sse2(internal_ufbgc_scan * scan, const unsigned char * a, const unsigned char * b, size_t size){
+    size_t offset = 0;
+    for(; offset + 64 <= size; offset += 64){
+        __m128i e0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + offset)),_mm_loadu_si128((const __m128i *)(b + offset)));
+        __m128i e1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + offset + 16)),_mm_loadu_si128((const __m128i *)(b + offset + 16)));
+        __m128i e2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + offset + 32)),_mm_loadu_si128((const __m128i *)(b + offset + 32)));
+        __m128i e3 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + offset + 48)),_mm_loadu_si128((const __m128i *)(b + offset + 48)));
+        __m128i all = _mm_and_si128(_mm_and_si128(e0,e1),_mm_and_si128(e2,e3));
+        if(UFBGC_EXPECT_FALSE(_mm_movemask_epi8(all) != 0xffff)){
+            uint64_t mask = (uint64_t)(uint16_t) ~_mm_movemask_epi8(e0) | ((uint64_t)(uint16_t) ~_mm_movemask_epi8(e1) << 16) |
+                ((uint64_t)(uint16_t) ~_mm_movemask_epi8(e2) << 32) | ((uint64_t)(uint16_t) ~_mm_movemask_epi8(e3) << 48);
+            ufbgc_scan_mask(scan,offset,mask);
+            if(scan->first_only) return;
+        }
+    }
+    ufbgc_scan_scalar(scan,a,b,offset,size);
+}
+
+#endif
+
+static void ufbgc_scan(internal_ufbgc_scan * scan, const void * a, const void * b, size_t size){
+    #if defined(__x86_64__) && defined(__GNUC__)
+        static int has_avx2 = -1;
+        if(has_avx2 < 0){
+            has_avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+        }
+        if(has_avx2){
+            ufbgc_scan_avx2(scan,(const unsigned char *) a,(const unsigned char *) b,size);
+        }
+        else{
+            ufbgc_scan_sse2(scan,(const unsigned char *) a,(const unsigned char *) b,size);
+        }
+    #else
+        ufbgc_scan_scalar(scan,(const unsigned char *) a,(const unsigned char *) b,0,size);
+    #endif
+}
+
+static void ufbgc_mismatch_init(ufbgc_mismatch * mismatch, ufbgc_elem_type_t type, size_t elem_size, size_t count, ufbgc_tolerance tolerance){
+    memset(mismatch,0,sizeof(*mismatch));
+    mismatch->type = type;
+    mismatch->elem_size = elem_size;
+    mismatch->count = count;
+    mismatch->first = count;
+    mismatch->tolerance = tolerance;
+}
+
+size_t ufbgc_compare_mem(const void * a, const void * b, size_t count, size_t elem_size, ufbgc_mismatch * mismatch){
+    ufbgc_mismatch_init(mismatch,UFBGC_ELEM_BYTES,elem_size ? elem_size : 1,count,UFBGC_TOLERANCE(0,0,0));
+    if(a == b || count == 0){
+        return 0;
+    }
+    internal_ufbgc_scan scan = {mismatch->elem_size,SIZE_MAX,0,SIZE_MAX,false};
+    ufbgc_scan(&scan,a,b,count * mismatch->elem_size);
+    if(scan.first != SIZE_MAX){
+        mismatch->first = scan.first / mismatch->elem_size;
+    }
+    mismatch->mismatches = scan.mismatches;
+    return scan.mismatches;
+}
+
+//Bits of a float in an order where neighbouring values differ by one, -0 and +0 are the same
+static int64_t ufbgc_ordered_bits(double value, bool is_float){
+    if(is_float){
+        float f = (float) value;
+        int32_t bits;
+        memcpy(&bits,&f,sizeof(bits));
+        return bits < 0 ? (int64_t) INT32_MIN - bits : bits;
+    }
+    int64_t bits;
+    memcpy(&bits,&value,sizeof(bits));
+    return bits < 0 ? (int64_t)((uint64_t) INT64_MIN - (uint64_t) bits) : bits;
+}
+
+static uint64_t ufbgc_ulp_distance(double a, double b, bool is_float){
+    int64_t x = ufbgc_ordered_bits(a,is_float);
+    int64_t y = ufbgc_ordered_bits(b,is_float);
+    return x > y ? (uint64_t) x - (uint64_t) y : (uint64_t) y - (uint64_t) x;
+}
+
+static bool ufbgc_near(double a, double b, const ufbgc_tolerance * tolerance, bool is_float){
+    if(a == b || (isnan(a) && isnan(b))){
+        return true;
+    }
+    if(isnan(a) || isnan(b) || isinf(a) || isinf(b)){
+        return false;
+    }
+    double diff = fabs(a - b);
+    double magnitude = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return diff <= tolerance->abs || diff <= tolerance->rel * magnitude ||
+        (tolerance->ulp > 0 && ufbgc_ulp_distance(a,b,is_float) <= tolerance->ulp);
+}
+
+//Byte offset of the first mismatch, SIZE_MAX if the buffers are equal
+static size_t ufbgc_find_mismatch(const void * a, const void * b, size_t size){
+    internal_ufbgc_scan scan = {1,SIZE_MAX,0,SIZE_MAX,true};
+    ufbgc_scan(&scan,a,b,size);
+    return scan.first;
+}
+
+static double ufbgc_load_value(const void * values, size_t i, bool is_float){
+    return is_float ? (double)((const float *) values)[i] : ((const double *) values)[i];
+}
+
+static bool ufbgc_same_bits(const unsigned char * a, const unsigned char * b, size_t i, bool is_float){
+    if(is_float){
+        uint32_t x, y;
+        memcpy(&x,a + i * sizeof(x),sizeof(x));
+        memcpy(&y,b + i * sizeof(y),sizeof(y));
+        return x == y;
+    }
+    uint64_t x, y;
+    memcpy(&x,a + i * sizeof(x),sizeof(x));
+    memcpy(&y,b + i * sizeof(y),sizeof(y));
+    return x == y;
+}
+
+/*
+    Bitwise equal runs are skipped by the vector scan, differing elements are checked against the tolerance one by one
+    until a run of equal elements is found, so buffers with rounding noise everywhere don't restart the scan per element
+*/
+#define UFBGC_NEAR_EQUAL_RUN 32
+
+static size_t ufbgc_compare_near(const void * a, const void * b, size_t count, bool is_float, ufbgc_tolerance tolerance, ufbgc_mismatch * mismatch){
+    size_t elem_size = is_float ? sizeof(float) : sizeof(double);
+    ufbgc_mismatch_init(mismatch,is_float ? UFBGC_ELEM_FLOAT : UFBGC_ELEM_DOUBLE,elem_size,count,tolerance);
+    const unsigned char * pa = (const unsigned char *) a;
+    const unsigned char * pb = (const unsigned char *) b;
+    size_t i = 0;
+    while(i < count){
+        size_t offset = ufbgc_find_mismatch(pa + i * elem_size,pb + i * elem_size,(count - i) * elem_size);
+        if(offset == SIZE_MAX){
+            break;
+        }
+        size_t equal_run = 0;
+        for(i += offset / elem_size; i < count && equal_run < UFBGC_NEAR_EQUAL_RUN; ++i){
+            if(ufbgc_same_bits(pa,pb,i,is_float)){
+                equal_run++;
+                continue;
+            }
+            equal_run = 0;
+            double x = ufbgc_load_value(a,i,is_float);
+            double y = ufbgc_load_value(b,i,is_float);
+            if(!ufbgc_near(x,y,&tolerance,is_float)){
+                if(mismatch->mismatches++ == 0){
+                    mismatch->first = i;
+                }
+                double diff = fabs(x - y);
+                if(diff > mismatch->max_diff || isnan(diff)){
+                    mismatch->max_diff = diff;
+                }
+            }
+        }
+    }
+    return mismatch->mismatches;
+}
+
+size_t ufbgc_compare_floats(const float * a, const float * b, size_t count, ufbgc_tolerance tolerance, ufbgc_mismatch * mismatch){
+    return ufbgc_compare_near(a,b,count,true,tolerance,mismatch);
+}
+
+size_t ufbgc_compare_doubles(const double * a, const double * b, size_t count, ufbgc_tolerance tolerance, ufbgc_mismatch * mismatch){
+    return ufbgc_compare_near(a,b,count,false,tolerance,mismatch);
+}
+
+#define UFBGC_MISMATCH_HEX_ROW 16
+#define UFBGC_MISMATCH_VALUES 4     //Floating point elements printed before and after the first mismatch
+
+//Window is the row of the first mismatch with a row before and after it
+static void ufbgc_hex_window_range(size_t size, size_t first_byte, size_t * start, size_t * end){
+    size_t row = first_byte / UFBGC_MISMATCH_HEX_ROW * UFBGC_MISMATCH_HEX_ROW;
+    *start = row >= UFBGC_MISMATCH_HEX_ROW ? row - UFBGC_MISMATCH_HEX_ROW : 0;
+    *end = row + 2 * UFBGC_MISMATCH_HEX_ROW < size ? row + 2 * UFBGC_MISMATCH_HEX_ROW : size;
+}
+
+//Rows around the first mismatch, differing bytes are marked on the line below, a and b hold the bytes from base
+static void ufbgc_print_hex_window(FILE * fl, const unsigned char * a, const unsigned char * b, size_t base, size_t size, size_t first_byte){
+    size_t start, end;
+    ufbgc_hex_window_range(size,first_byte,&start,&end);
+    a -= base;
+    b -= base;
+    for(size_t offset = start; offset < end; offset += UFBGC_MISMATCH_HEX_ROW){
+        size_t n = end - offset < UFBGC_MISMATCH_HEX_ROW ? end - offset : UFBGC_MISMATCH_HEX_ROW;
+        char marks[UFBGC_MISMATCH_HEX_ROW * 3 + 1];
+        bool marked = false;
+        fprintf(fl,"  0x%08lx  a:",(unsigned long) offset);
+        for(size_t i = 0; i < n; ++i){
+            fprintf(fl," %02x",a[offset + i]);
+        }
+        fprintf(fl,"\n              b:");
+        for(size_t i = 0; i < n; ++i){
+            bool differs = a[offset + i] != b[offset + i];
+            if(differs && UFBGC_COLORED(fl)){
+                fprintf(fl," " ANSI_COLOR_RED "%02x" ANSI_COLOR_RESET,b[offset + i]);
+            }
+            else{
+                fprintf(fl," %02x",b[offset + i]);
+            }
+            memcpy(marks + i * 3,differs ? " ^^" : "   ",3);
+            marked = marked || differs;
+        }
+        size_t marks_len = n * 3;
+        while(marks_len > 0 && marks[marks_len - 1] == ' '){
+            marks_len--;
+        }
+        marks[marks_len] = '\0';
+        fprintf(fl,"\n");
+        if(marked){
+            fprintf(fl,"                %s\n",marks);
+        }
+    }
+}
+
+static void ufbgc_print_value_window(FILE * fl, const ufbgc_mismatch * mismatch, const void * a, const void * b){
+    bool is_float = mismatch->type == UFBGC_ELEM_FLOAT;
+    size_t start = mismatch->first >= UFBGC_MISMATCH_VALUES ? mismatch->first - UFBGC_MISMATCH_VALUES : 0;
+    size_t end = mismatch->first + UFBGC_MISMATCH_VALUES + 1 < mismatch->count ? mismatch->first + UFBGC_MISMATCH_VALUES + 1 : mismatch->count;
+    for(size_t i = start; i < end; ++i){
+        double x = is_float ? (double)((const float *) a)[i] : ((const double *) a)[i];
+        double y = is_float ? (double)((const float *) b)[i] : ((const double *) b)[i];
+        bool differs = !ufbgc_near(x,y,&mismatch->tolerance,is_float);
+        fprintf(fl,"  [%lu]  a: %.*g  b: %.*g",(unsigned long) i,is_float ? 9 : 17,x,is_float ? 9 : 17,y);
+        if(x != y){
+            fprintf(fl,"  diff %g, %llu ulp",fabs(x - y),(unsigned long long) ufbgc_ulp_distance(x,y,is_float));
+        }
+        fprintf(fl,"%s\n",differs ? "  <--" : "");
+    }
+}
+
+//Summary is the note of a failure without a message, otherwise it is printed after the note
+static bool ufbgc_assert_summary_v(const char * summary, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, va_list format_args){
+
+    if(format[0] == '\0'){
+        return ufbgc_assert_failed(UFBGC_LOG_ERROR,type,condition,file,function,line,"%s",summary);
+    }
+    bool failed = ufbgc_assert_failed_v(UFBGC_LOG_ERROR,type,condition,file,function,line,format,format_args);
+    if(failed && !current_test_frame.quiet){
+        FILE * fl = ufbgc_get_current_test_file();
+        ufbgc_print_yellow(fl,"%s\n",summary);
+    }
+    return failed;
+}
+
+UFBGC_COLD bool ufbgc_assert_mismatch(const ufbgc_mismatch * mismatch, const void * a, const void * b, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, ...){
+
+    char summary[256];
+    if(mismatch->type == UFBGC_ELEM_BYTES && mismatch->elem_size == 1){
+        snprintf(summary,sizeof(summary),"first mismatch at byte %lu, %lu of %lu bytes differ",
+            (unsigned long) mismatch->first,(unsigned long) mismatch->mismatches,(unsigned long) mismatch->count);
+    }
+    else{
+        snprintf(summary,sizeof(summary),"first mismatch at element %lu (byte %lu), %lu of %lu elements differ",
+            (unsigned long) mismatch->first,(unsigned long)(mismatch->first * mismatch->elem_size),
+            (unsigned long) mismatch->mismatches,(unsigned long) mismatch->count);
+    }
+    if(mismatch->type != UFBGC_ELEM_BYTES){
+        size_t len = strlen(summary);
+        snprintf(summary + len,sizeof(summary) - len,", max diff %g",mismatch->max_diff);
+    }
+
+    va_list args;
+    va_start(args,format);
+    bool failed = ufbgc_assert_summary_v(summary,type,condition,file,function,line,format,args);
+    va_end(args);
+    if(!failed || current_test_frame.quiet){
+        return failed;
+    }
+
+    FILE * fl = ufbgc_get_current_test_file();
+    if(mismatch->type == UFBGC_ELEM_BYTES){
+        ufbgc_print_hex_window(fl,(const unsigned char *) a,(const unsigned char *) b,0,mismatch->count * mismatch->elem_size,mismatch->first * mismatch->elem_size);
+    }
+    else{
+        ufbgc_print_value_window(fl,mismatch,a,b);
+    }
+    fprintf(fl,"\n");
+    return failed;
+}
+
+#define UFBGC_GOLDEN_WINDOW ((size_t) 16 << 20)     //Bytes of a file mapped at once, a multiple of the page size
+
+//Read only view of a file, windows are mapped one at a time or read into a buffer without mmap
+typedef struct{
+    FILE * fl;
+    size_t size;
+    void * window;
+    size_t window_size;
+}internal_ufbgc_file_view;
+
+static bool ufbgc_view_open(internal_ufbgc_file_view * view, const char * path){
+    memset(view,0,sizeof(*view));
+    view->fl = fopen(path,"rb");
+    if(view->fl == NULL){
+        return false;
+    }
+    #ifdef UFBGC_POSIX
+        struct stat st;
+        bool ok = fstat(fileno(view->fl),&st) == 0 && S_ISREG(st.st_mode);
+        view->size = ok ? (size_t) st.st_size : 0;
+    #else
+        long size = fseek(view->fl,0,SEEK_END) == 0 ? ftell(view->fl) : -1;
+        bool ok = size >= 0;
+        view->size = ok ? (size_t) size : 0;
+    #endif
+    if(!ok){
+        fclose(view->fl);
+        view->fl = NULL;
+    }
+    return ok;
+}
+
+//offset is a multiple of UFBGC_GOLDEN_WINDOW, the previous window is released
+static const unsigned char * ufbgc_view_window(internal_ufbgc_file_view * view, size_t offset, size_t size){
+    #ifdef UFBGC_POSIX
+        if(view->window != NULL){
+            munmap(view->window,view->window_size);
+            view->window = NULL;
+        }
+        void * window = mmap(NULL,size,PROT_READ,MAP_PRIVATE,fileno(view->fl),(off_t) offset);
+        if(window == MAP_FAILED){
+            return NULL;
+        }
+        madvise(window,size,MADV_SEQUENTIAL);
+        view->window = window;
+        view->window_size = size;
+    #else
+        if(view->window == NULL && (view->window = malloc(UFBGC_GOLDEN_WINDOW)) == NULL){
+            return NULL;
+        }
+        if(fseek(view->fl,(long) offset,SEEK_SET) != 0 || fread(view->window,1,size,view->fl) != size){
+            return NULL;
+        }
+    #endif
+    return (const unsigned char *) view->window;
+}
+
+static void ufbgc_view_close(internal_ufbgc_file_view * view){
+    #ifdef UFBGC_POSIX
+        if(view->window != NULL){
+            munmap(view->window,view->window_size);
+        }
+    #else
+        free(view->window);
+    #endif
+    if(view->fl != NULL){
+        fclose(view->fl);
+    }
+    memset(view,0,sizeof(*view));
+}
+
+static bool ufbgc_read_at(const char * path, size_t offset, unsigned char * buffer, size_t size){
+    FILE * fl = fopen(path,"rb");
+    if(fl == NULL){
+        return false;
+    }
+    #ifdef UFBGC_POSIX
+        bool ok = fseeko(fl,(off_t) offset,SEEK_SET) == 0;
+    #else
+        bool ok = fseek(fl,(long) offset,SEEK_SET) == 0;
+    #endif
+    ok = ok && fread(buffer,1,size,fl) == size;
+    fclose(fl);
+    return ok;
+}
+
+static bool ufbgc_update_golden(void){
+    const char * update = getenv("UFBGC_UPDATE_GOLDEN");
+    return update != NULL && update[0] != '\0' && strcmp(update,"0") != 0;
+}
+
+//Output is data or the view of the output file, the golden file is replaced only after it is written completely
+static bool ufbgc_golden_write(const unsigned char * data, internal_ufbgc_file_view * output, size_t size, const char * golden_path){
+    char * tmp_path;
+    FILE * fl = ufbgc_open_atomic(golden_path,&tmp_path);
+    bool ok = fl != NULL;
+    for(size_t offset = 0; ok && offset < size; offset += UFBGC_GOLDEN_WINDOW){
+        size_t n = size - offset < UFBGC_GOLDEN_WINDOW ? size - offset : UFBGC_GOLDEN_WINDOW;
+        const unsigned char * window = output != NULL ? ufbgc_view_window(output,offset,n) : data + offset;
+        ok = window != NULL && fwrite(window,1,n,fl) == n;
+    }
+    return ufbgc_close_atomic(fl,tmp_path,golden_path,ok);
+}
+
+//Output is data or the file at path, windows of both are compared and released one after the other
+static size_t ufbgc_golden_compare(const void * data, const char * path, size_t size, const char * golden_path, ufbgc_golden * golden){
+    memset(golden,0,sizeof(*golden));
+    golden->data = data;
+    golden->path = path;
+    golden->golden_path = golden_path;
+    current_test_frame.used_golden = true;
+
+    internal_ufbgc_file_view output, expected;
+    memset(&output,0,sizeof(output));
+    bool output_ok = path == NULL || ufbgc_view_open(&output,path);
+    bool expected_ok = ufbgc_view_open(&expected,golden_path);
+    golden->size = path == NULL ? size : output.size;
+    golden->golden_size = expected.size;
+    size_t common = golden->size < golden->golden_size ? golden->size : golden->golden_size;
+    ufbgc_mismatch_init(&golden->mismatch,UFBGC_ELEM_BYTES,1,common,UFBGC_TOLERANCE(0,0,0));
+
+    //Golden file is rewritten at the first difference in the update mode, there is nothing more to report
+    bool update = ufbgc_update_golden();
+    for(size_t offset = 0; output_ok && expected_ok && offset < common; offset += UFBGC_GOLDEN_WINDOW){
+        if(update && golden->mismatch.mismatches != 0){
+            break;
+        }
+        size_t n = common - offset < UFBGC_GOLDEN_WINDOW ? common - offset : UFBGC_GOLDEN_WINDOW;
+        const unsigned char * a = path == NULL ? (const unsigned char *) data + offset : ufbgc_view_window(&output,offset,n);
+        const unsigned char * b = ufbgc_view_window(&expected,offset,n);
+        output_ok = a != NULL;
+        expected_ok = b != NULL;
+        ufbgc_mismatch window;
+        if(a != NULL && b != NULL && ufbgc_compare_mem(a,b,n,1,&window) != 0){
+            if(golden->mismatch.first == common){
+                golden->mismatch.first = offset + window.first;
+            }
+            golden->mismatch.mismatches += window.mismatches;
+        }
+    }
+    ufbgc_view_close(&expected);
+
+    size_t differing = golden->mismatch.mismatches +
+        (golden->size > golden->golden_size ? golden->size - golden->golden_size : golden->golden_size - golden->size);
+    if(update && output_ok && (!expected_ok || differing != 0)){
+        golden->updated = ufbgc_golden_write((const unsigned char *) data,path != NULL ? &output : NULL,golden->size,golden_path);
+        if(golden->updated){
+            expected_ok = true;
+            differing = 0;
+            if(!current_test_frame.quiet){
+                ufbgc_print_yellow(ufbgc_get_current_test_file(),"Golden file '%s' is updated, %lu bytes\n",golden_path,(unsigned long) golden->size);
+            }
+        }
+    }
+    ufbgc_view_close(&output);
+
+    if(!output_ok || !expected_ok){
+        golden->error = output_ok ? golden_path : path;
+        return SIZE_MAX;
+    }
+    return differing;
+}
+
+size_t ufbgc_compare_golden(const void * data, size_t size, const char * golden_path, ufbgc_golden * golden){
+    return ufbgc_golden_compare(data,NULL,size,golden_path,golden);
+}
+
+size_t ufbgc_compare_golden_file(const char * path, const char * golden_path, ufbgc_golden * golden){
+    return ufbgc_golden_compare(NULL,path,0,golden_path,golden);
+}
+
+UFBGC_COLD bool ufbgc_assert_golden_failed(const ufbgc_golden * golden, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, ...){
+
+    const ufbgc_mismatch * mismatch = &golden->mismatch;
+    char summary[512];
+    if(golden->error != NULL){
+        bool writing = golden->error == golden->golden_path && ufbgc_update_golden();
+        snprintf(summary,sizeof(summary),"cannot %s '%s'",writing ? "write" : "read",golden->error);
+    }
+    else{
+        int len = snprintf(summary,sizeof(summary),"'%s': ",golden->golden_path);
+        if(mismatch->mismatches != 0){
+            len += snprintf(summary + len,sizeof(summary) - (size_t) len,"first mismatch at byte %lu, %lu of %lu bytes differ%s",
+                (unsigned long) mismatch->first,(unsigned long) mismatch->mismatches,(unsigned long) mismatch->count,
+                golden->size != golden->golden_size ? ", " : "");
+        }
+        if(golden->size != golden->golden_size && len < (int) sizeof(summary)){
+            snprintf(summary + len,sizeof(summary) - (size_t) len,"output is %lu bytes, golden file is %lu bytes",
+                (unsigned long) golden->size,(unsigned long) golden->golden_size);
+        }
+    }
+
+    va_list args;
+    va_start(args,format);
+    bool failed = ufbgc_assert_summary_v(summary,type,condition,file,function,line,format,args);
+    va_end(args);
+    if(!failed || current_test_frame.quiet || golden->error != NULL || mismatch->count == 0){
+        return failed;
+    }
+
+    //Only the bytes of the window are read again, the output may not fit into memory
+    size_t start, end;
+    ufbgc_hex_window_range(mismatch->count,mismatch->first,&start,&end);
+    unsigned char a[3 * UFBGC_MISMATCH_HEX_ROW], b[3 * UFBGC_MISMATCH_HEX_ROW];
+    bool read = ufbgc_read_at(golden->golden_path,start,b,end - start);
+    if(golden->data != NULL){
+        memcpy(a,(const unsigned char *) golden->data + start,end - start);
+    }
+    else{
+        read = read && ufbgc_read_at(golden->path,start,a,end - start);
+    }
+    if(read){
+        FILE * fl = ufbgc_get_current_test_file();
+        ufbgc_print_hex_window(fl,a,b,start,mismatch->count,mismatch->first);
+        fprintf(fl,"\n");
+    }
+    return failed;
+}
+
+bool ufbgc_is_colored_file(FILE * fl){
+    return fl == stdout || (fl != NULL && fl == current_test_frame.output_file && current_test_frame.colored_output);
+}
+
+
+bool ufbgc_get_current_test_iterator(size_t * it){
+    if(current_test_frame.frame == NULL || it == NULL){
+        return false;
+    }
+
+    *it = current_test_frame.frame_iterator;
+    return true;
+}
+
+const void * ufbgc_get_parameter(const char * key){
+    const internal_ufbgc_test_frame * context = &current_test_frame;
+    if(context->frame == NULL || (context->frame->parameters == NULL && context->gen_nodes == NULL) || key == NULL){
+        return NULL;
+    }
+    bool generated;
+    const ufbgc_args * arg = ufbgc_find_parameter(context,key,&generated);
+    return arg != NULL ? arg->value : NULL;
+}
+
+static const char * ufbgc_param_type_name(ufbgc_param_type_t type){
+    switch(type){
+        case UFBGC_PARAM_INT: return "int";
+        case UFBGC_PARAM_DOUBLE: return "double";
+        case UFBGC_PARAM_STRING: return "string";
+        case UFBGC_PARAM_BLOB: return "blob";
+        default: return "untyped";
+    }
+}
+
+/*
+    Values of the key and the current iteration, reasons of a failed lookup are printed into the test output
+    Untyped parameters and UFBGC_PARAM_UNTYPED requests are not type checked
+*/
+const void * ufbgc_lookup_parameter(const char * key, ufbgc_param_type_t type, size_t * it){
+    const internal_ufbgc_test_frame * context = &current_test_frame;
+    if(context->frame == NULL || key == NULL){
+        return NULL;
+    }
+    const ufbgc_test_parameters * params = context->frame->parameters;
+    bool generated = false;
+    const ufbgc_args * arg = params != NULL || context->gen_nodes != NULL ? ufbgc_find_parameter(context,key,&generated) : NULL;
+    if(UFBGC_EXPECT_FALSE(arg == NULL)){
+        ufbgc_print_red(ufbgc_get_current_test_file(),"Parameter '%s' is not found\n",key);
+        return NULL;
+    }
+    if(UFBGC_EXPECT_FALSE(type != UFBGC_PARAM_UNTYPED && arg->type != UFBGC_PARAM_UNTYPED && arg->type != type)){
+        ufbgc_print_red(ufbgc_get_current_test_file(),"Parameter '%s' is %s, not %s\n",
+            key,ufbgc_param_type_name(arg->type),ufbgc_param_type_name(type));
+        return NULL;
+    }
+    if(generated){
+        //Generated keys hold the value of the current iteration only
+        if(it != NULL){
+            *it = 0;
+        }
+        return arg->value;
+    }
+    if(UFBGC_EXPECT_FALSE(context->frame_iterator >= params->no_iteration)){
+        ufbgc_print_red(ufbgc_get_current_test_file(),"Parameter '%s' has %lu values, iteration %lu is out of range\n",
+            key,params->no_iteration,context->frame_iterator);
+        return NULL;
+    }
+    if(it != NULL){
+        *it = context->frame_iterator;
+    }
+    return arg->value;
+}
+
+bool ufbgc_get_parameter_int(const char * key, int * dest){
+    size_t it;
+    const int * values = (const int *) ufbgc_lookup_parameter(key,UFBGC_PARAM_INT,&it);
+    if(values == NULL){
+        return false;
+    }
+    *dest = values[it];
+    return true;
+}
+
+bool ufbgc_get_parameter_double(const char * key, double * dest){
+    size_t it;
+    const double * values = (const double *) ufbgc_lookup_parameter(key,UFBGC_PARAM_DOUBLE,&it);
+    if(values == NULL){
+        return false;
+    }
+    *dest = values[it];
+    return true;
+}
+
+bool ufbgc_get_parameter_string(const char * key, const char ** dest){
+    size_t it;
+    const char * const * values = (const char * const *) ufbgc_lookup_parameter(key,UFBGC_PARAM_STRING,&it);
+    if(values == NULL){
+        return false;
+    }
+    *dest = values[it];
+    return true;
+}
+
+bool ufbgc_get_parameter_blob(const char * key, ufbgc_blob * dest){
+    size_t it;
+    const ufbgc_blob * values = (const ufbgc_blob *) ufbgc_lookup_parameter(key,UFBGC_PARAM_BLOB,&it);
+    if(values == NULL){
+        return false;
+    }
+    *dest = values[it];
+    return true;
+}
+
+
+void ufbgc_get_current_time(struct tm * dest){
+    time_t rawtime;
+    time ( &rawtime );
+    #ifdef UFBGC_POSIX
+        localtime_r(&rawtime,dest);
+    #else
+        struct tm * timeinfo = localtime ( &rawtime );
+        memcpy(dest,timeinfo,sizeof(struct tm));
+    #endif
+}
+
+
+//Process CPU time, use ufbgc_timer for wall time and thread CPU time
+double ufbgc_get_execution_time(clock_t start){
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+double ufbgc_get_execution_time_ms(clock_t start){
+    return (double)(clock() - start) * 1e3 / CLOCKS_PER_SEC;
+}
+double ufbgc_get_execution_time_us(clock_t start){
+    return (double)(clock() - start) * 1e6 / CLOCKS_PER_SEC;
+}
+
+
+uint64_t ufbgc_get_wall_time_ns(){
+    struct timespec ts;
+    #if defined(CLOCK_MONOTONIC_RAW)
+        clock_gettime(CLOCK_MONOTONIC_RAW,&ts);
+    #elif defined(UFBGC_POSIX)
+        clock_gettime(CLOCK_MONOTONIC,&ts);
+    #else
+        timespec_get(&ts,TIME_UTC);
+    #endif
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+uint64_t ufbgc_get_thread_cpu_time_ns(){
+    #if defined(CLOCK_THREAD_CPUTIME_ID)
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+        return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+    #else
+        return (uint64_t)((double) clock() * 1e9 / CLOCKS_PER_SEC);
+    #endif
+}
+
+//Counter is only used when it runs at a constant rate
+static bool ufbgc_has_cycle_counter(){
+    #if defined(__x86_64__) || defined(__i386__)
+        unsigned int eax, ebx, ecx, edx;
+        if(__get_cpuid(0x80000000,&eax,&ebx,&ecx,&edx) == 0 || eax < 0x80000007){
+            return false;
+        }
+        __get_cpuid(0x80000007,&eax,&ebx,&ecx,&edx);
+        return (edx & (1u << 8)) != 0;
+    #elif defined(__aarch64__)
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+static uint64_t ufbgc_read_cycle_counter(){
+    #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+    #elif defined(__aarch64__)
+        uint64_t value;
+        __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+    #else
+        return 0;
+    #endif
+}
+
+static bool cycle_counter_enabled = false;
+static double cycle_frequency = 0;
+
+//Frequency of the counter is measured against the wall clock once
+static void ufbgc_calibrate_cycle_counter(){
+    if(!ufbgc_has_cycle_counter()){
+        return;
+    }
+    #if defined(__aarch64__)
+        uint64_t frequency;
+        __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+        cycle_frequency = (double) frequency;
+    #else
+        uint64_t wall_start = ufbgc_get_wall_time_ns();
+        uint64_t cycles_start = ufbgc_read_cycle_counter();
+        while(ufbgc_get_wall_time_ns() - wall_start < 10000000ull);
+        uint64_t cycles = ufbgc_read_cycle_counter() - cycles_start;
+        uint64_t wall = ufbgc_get_wall_time_ns() - wall_start;
+        cycle_frequency = (double) cycles * 1e9 / (double) wall;
+    #endif
+    cycle_counter_enabled = cycle_frequency > 0;
+}
+
+#ifdef UFBGC_POSIX
+static pthread_once_t cycle_counter_once = PTHREAD_ONCE_INIT;
+#else
+static bool cycle_counter_calibrated = false;
+#endif
+
+static void ufbgc_init_cycle_counter(){
+    #ifdef UFBGC_POSIX
+        pthread_once(&cycle_counter_once,ufbgc_calibrate_cycle_counter);
+    #else
+        if(!cycle_counter_calibrated){
+            ufbgc_calibrate_cycle_counter();
+            cycle_counter_calibrated = true;
+        }
+    #endif
+}
+
+uint64_t ufbgc_get_cycles(){
+    ufbgc_init_cycle_counter();
+    return cycle_counter_enabled ? ufbgc_read_cycle_counter() : 0;
+}
+
+//Ticks per second of the cycle counter, zero if it is not used
+double ufbgc_get_cycle_frequency(){
+    ufbgc_init_cycle_counter();
+    return cycle_frequency;
+}
+
+void ufbgc_timer_now(ufbgc_time_sample * sample){
+    sample->cycles = ufbgc_get_cycles();
+    sample->cpu_ns = ufbgc_get_thread_cpu_time_ns();
+    sample->wall_ns = ufbgc_get_wall_time_ns();
+}
+
+void ufbgc_timer_start(ufbgc_timer * timer){
+    memset(&timer->elapsed,0,sizeof(timer->elapsed));
+    ufbgc_timer_now(&timer->start);
+}
+
+void ufbgc_timer_stop(ufbgc_timer * timer){
+    ufbgc_time_sample now;
+    now.wall_ns = ufbgc_get_wall_time_ns();
+    now.cpu_ns = ufbgc_get_thread_cpu_time_ns();
+    now.cycles = ufbgc_get_cycles();
+    timer->elapsed.wall_ns = now.wall_ns - timer->start.wall_ns;
+    timer->elapsed.cpu_ns = now.cpu_ns - timer->start.cpu_ns;
+    timer->elapsed.cycles = now.cycles - timer->start.cycles;
+}
+
+
+/*
+    Values below 2^SUB_BITS have a bucket each, above that every power of two is split into 2^(SUB_BITS - 1) buckets
+    Bucket of a value is found from its highest set bit and the SUB_BITS - 1 bits below it
+*/
+static inline size_t ufbgc_histogram_index(uint64_t value){
+    const unsigned sub_bits = UFBGC_HISTOGRAM_SUB_BITS;
+    if(value < ((uint64_t) 1 << sub_bits)){
+        return (size_t) value;
+    }
+    unsigned exponent = 63 - (unsigned) __builtin_clzll(value);
+    uint64_t mantissa = value >> (exponent - (sub_bits - 1));
+    return ((size_t)(exponent - sub_bits + 2) << (sub_bits - 1)) + (size_t)(mantissa - ((uint64_t) 1 << (sub_bits - 1)));
+}
+
+//Largest value of the bucket, the last bucket ends at UINT64_MAX
+static uint64_t ufbgc_histogram_upper(size_t index){
+    const size_t half = (size_t) 1 << (UFBGC_HISTOGRAM_SUB_BITS - 1);
+    if(index < 2 * half){
+        return index;
+    }
+    unsigned shift = (unsigned)(index / half) - 1;
+    uint64_t mantissa = half + index % half;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void ufbgc_histogram_reset(ufbgc_histogram * histogram){
+    memset(histogram,0,sizeof(*histogram));
+}
+
+void ufbgc_histogram_record_n(ufbgc_histogram * histogram, uint64_t value, uint64_t count){
+    if(count == 0){
+        return;
+    }
+    if(histogram->count == 0 || value < histogram->min){
+        histogram->min = value;
+    }
+    if(value > histogram->max){
+        histogram->max = value;
+    }
+    histogram->count += count;
+    histogram->sum += (double) value * (double) count;
+    histogram->buckets[ufbgc_histogram_index(value)] += count;
+}
+
+void ufbgc_histogram_record(ufbgc_histogram * histogram, uint64_t value){
+    ufbgc_histogram_record_n(histogram,value,1);
+}
+
+void ufbgc_histogram_merge(ufbgc_histogram * dest, const ufbgc_histogram * src){
+    if(src->count == 0){
+        return;
+    }
+    if(dest->count == 0 || src->min < dest->min){
+        dest->min = src->min;
+    }
+    if(src->max > dest->max){
+        dest->max = src->max;
+    }
+    dest->count += src->count;
+    dest->sum += src->sum;
+    for(size_t i = 0; i < UFBGC_HISTOGRAM_BUCKETS; ++i){
+        dest->buckets[i] += src->buckets[i];
+    }
+}
+
+//Value at the rank ceil(percentile * count / 100), rounded up to its bucket
+uint64_t ufbgc_histogram_percentile(const ufbgc_histogram * histogram, double percentile){
+    if(histogram->count == 0){
+        return 0;
+    }
+    double rank = ceil(percentile / 100.0 * (double) histogram->count);
+    uint64_t target = rank < 1 ? 1 : rank >= (double) histogram->count ? histogram->count : (uint64_t) rank;
+    uint64_t seen = 0;
+    for(size_t i = 0; i < UFBGC_HISTOGRAM_BUCKETS; ++i){
+        seen += histogram->buckets[i];
+        if(seen >= target){
+            uint64_t upper = ufbgc_histogram_upper(i);
+            return upper > histogram->max ? histogram->max : upper < histogram->min ? histogram->min : upper;
+        }
+    }
+    return histogram->max;
+}
+
+double ufbgc_histogram_mean(const ufbgc_histogram * histogram){
+    return histogram->count ? histogram->sum / (double) histogram->count : 0;
+}
+
+void ufbgc_report_histogram(const char * name, const ufbgc_histogram * histogram){
+    if(current_test_frame.frame == NULL || name == NULL){
+        return;
+    }
+    internal_ufbgc_histogram_report report;
+    snprintf(report.name,sizeof(report.name),"%s",name);
+    report.count = histogram->count;
+    report.p50 = ufbgc_histogram_percentile(histogram,50);
+    report.p99 = ufbgc_histogram_percentile(histogram,99);
+    report.p999 = ufbgc_histogram_percentile(histogram,99.9);
+    report.max = histogram->max;
+    ufbgc_add_histogram_report(&current_test_frame,&report);
+}
+
+//Duration literal such as 200us or 1.5ms, a number without a unit is in nanoseconds
+static bool ufbgc_parse_duration_ns(const char * str, double * ns){
+    static const struct{
+        const char * unit;
+        double scale;
+    }units[] = {{"",1},{"ns",1},{"us",1e3},{"ms",1e6},{"s",1e9}};
+    char * end;
+    double value = strtod(str,&end);
+    if(end == str || value < 0){
+        return false;
+    }
+    while(*end == ' '){
+        end++;
+    }
+    for(size_t i = 0; i < sizeof(units) / sizeof(units[0]); ++i){
+        if(!strcmp(end,units[i].unit)){
+            *ns = value * units[i].scale;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ufbgc_check_percentile_ns(const ufbgc_histogram * histogram, double percentile, const char * op, double limit_ns, ufbgc_percentile_check * check){
+    memset(check,0,sizeof(*check));
+    check->histogram = histogram;
+    check->percentile = percentile;
+    check->limit_ns = limit_ns;
+    if(histogram->count == 0){
+        check->error = "histogram is empty";
+        return false;
+    }
+    if(!(percentile >= 0 && percentile <= 100)){
+        check->error = "percentile is not in [0,100]";
+        return false;
+    }
+    double value = (double)(check->value = ufbgc_histogram_percentile(histogram,percentile));
+    if(!strcmp(op,"<"))     return value < limit_ns;
+    if(!strcmp(op,"<="))    return value <= limit_ns;
+    if(!strcmp(op,">"))     return value > limit_ns;
+    if(!strcmp(op,">="))    return value >= limit_ns;
+    if(!strcmp(op,"=="))    return value == limit_ns;
+    check->error = "operator is not one of < <= > >= ==";
+    return false;
+}
+
+bool ufbgc_check_percentile(const ufbgc_histogram * histogram, double percentile, const char * op, const char * limit, ufbgc_percentile_check * check){
+    double limit_ns = 0;
+    bool parsed = ufbgc_parse_duration_ns(limit,&limit_ns);
+    bool passed = ufbgc_check_percentile_ns(histogram,percentile,op,limit_ns,check);
+    check->limit = limit;
+    if(!parsed){
+        check->error = "limit is not a duration, e.g. 200us";
+        return false;
+    }
+    return passed;
+}
+
+UFBGC_COLD bool ufbgc_assert_percentile_failed(const ufbgc_percentile_check * check, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, ...){
+
+    char summary[256];
+    if(check->error != NULL){
+        snprintf(summary,sizeof(summary),"%s",check->error);
+    }
+    else{
+        const ufbgc_histogram * histogram = check->histogram;
+        char value[32], limit[32], p50[32], max[32];
+        snprintf(summary,sizeof(summary),"p%g is %s, limit %s (%llu values, p50 %s, max %s)",check->percentile,
+            ufbgc_format_ns((double) check->value,value,sizeof(value)),
+            ufbgc_format_ns(check->limit_ns,limit,sizeof(limit)),
+            (unsigned long long) histogram->count,
+            ufbgc_format_ns((double) ufbgc_histogram_percentile(histogram,50),p50,sizeof(p50)),
+            ufbgc_format_ns((double) histogram->max,max,sizeof(max)));
+    }
+    va_list args;
+    va_start(args,format);
+    bool failed = ufbgc_assert_summary_v(summary,type,condition,file,function,line,format,args);
+    va_end(args);
+    return failed;
+}
+
+void ufbgc_set_bytes_processed(uint64_t bytes){
+    current_test_frame.bytes_processed = bytes;
+}
+
+void ufbgc_set_items_processed(uint64_t items){
+    current_test_frame.items_processed = items;
+}
+
+size_t ufbgc_get_bench_iterations(){
+    return current_test_frame.bench_iterations ? current_test_frame.bench_iterations : 1;
+}
+
+//Pointer is stored into a volatile object, so compiler has to assume the memory is used
+static const void * volatile ufbgc_escape_sink;
+void ufbgc_escape(const void * p){
+    ufbgc_escape_sink = p;
+}
+
+
+/*
+    Properties record the random choices of a run, a failing run is shrunk by simplifying its choices and running them again
+    Deleting choices, zeroing them and lowering their values only moves to shorter or smaller sequences, so shrinking ends
+    Values are encoded so that smaller choices give values closer to zero (or to the range boundary nearest to zero)
+*/
+#define UFBGC_PROPERTY_SHRINK_RUNS 10000
+#define UFBGC_PROPERTY_PRINT_BYTES 64
+
+typedef struct{
+    uint64_t * data;
+    size_t size;
+    size_t capacity;
+}internal_ufbgc_choices;
+
+struct internal_ufbgc_property{
+    const uint64_t * source;        //Choices of a replay, NULL draws random choices
+    size_t source_size;
+    size_t position;
+    internal_ufbgc_choices record;  //Choices the run used
+    void ** blocks;                 //Buffers and strings of the run
+    size_t no_blocks;
+    size_t blocks_capacity;
+    bool verbose;                   //Drawn values are printed, while the shrunk input runs again
+};
+
+static bool ufbgc_choices_push(internal_ufbgc_choices * choices, uint64_t value){
+    if(choices->size == choices->capacity){
+        size_t capacity = choices->capacity ? choices->capacity * 2 : 64;
+        uint64_t * data = (uint64_t *) ufbgc_internal_realloc(choices->data,capacity * sizeof(uint64_t));
+        if(data == NULL){
+            return false;
+        }
+        choices->data = data;
+        choices->capacity = capacity;
+    }
+    choices->data[choices->size++] = value;
+    return true;
+}
+
+static bool ufbgc_choices_copy(internal_ufbgc_choices * dest, const uint64_t * data, size_t size){
+    dest->size = 0;
+    for(size_t i = 0; i < size; ++i){
+        if(!ufbgc_choices_push(dest,data[i])){
+            return false;
+        }
+    }
+    return true;
+}
+
+//Next choice below bound (0 is unbounded), random is the choice of a run which is not a replay
+static uint64_t ufbgc_prop_choice(ufbgc_property * prop, uint64_t bound, uint64_t random){
+    uint64_t value = random;
+    if(prop->source != NULL){
+        value = prop->position < prop->source_size ? prop->source[prop->position] : 0;
+        if(bound != 0 && value >= bound){
+            value %= bound;
+        }
+    }
+    prop->position++;
+    ufbgc_choices_push(&prop->record,value);
+    return value;
+}
+
+//Block is freed when the run ends, it is freed right away if it cannot be registered
+static bool ufbgc_prop_register(ufbgc_property * prop, void * block){
+    if(prop->no_blocks == prop->blocks_capacity){
+        size_t capacity = prop->blocks_capacity ? prop->blocks_capacity * 2 : 16;
+        void ** blocks = (void **) ufbgc_internal_realloc(prop->blocks,capacity * sizeof(void *));
+        if(blocks == NULL){
+            ufbgc_internal_free(block);
+            return false;
+        }
+        prop->blocks = blocks;
+        prop->blocks_capacity = capacity;
+    }
+    prop->blocks[prop->no_blocks++] = block;
+    return true;
+}
+
+static uint64_t ufbgc_zigzag_encode(int64_t value){
+    return ((uint64_t) value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t ufbgc_zigzag_decode(uint64_t value){
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+int64_t ufbgc_prop_int(ufbgc_property * prop, int64_t min, int64_t max){
+    if(max <= min){
+        return min;
+    }
+    int64_t origin = min > 0 ? min : max < 0 ? max : 0;
+    uint64_t random = 0;
+    if(prop->source == NULL){
+        uint64_t span = (uint64_t) max - (uint64_t) min + 1;
+        int64_t value = (int64_t)((uint64_t) min + (span != 0 ? ufbgc_rand_below(span) : ufbgc_rand_u64()));
+        random = ufbgc_zigzag_encode((int64_t)((uint64_t) value - (uint64_t) origin));
+    }
+    int64_t offset = ufbgc_zigzag_decode(ufbgc_prop_choice(prop,0,random));
+    uint64_t below = (uint64_t) origin - (uint64_t) min;
+    uint64_t above = (uint64_t) max - (uint64_t) origin;
+    int64_t value;
+    if(offset < 0){
+        uint64_t distance = (uint64_t) -(offset + 1) + 1;
+        value = distance > below ? min : (int64_t)((uint64_t) origin - distance);
+    }
+    else{
+        value = (uint64_t) offset > above ? max : (int64_t)((uint64_t) origin + (uint64_t) offset);
+    }
+    if(prop->verbose){
+        ufbgc_print_blue(ufbgc_get_current_test_file(),"  int %lld\n",(long long) value);
+    }
+    return value;
+}
+
+double ufbgc_prop_double(ufbgc_property * prop, double min, double max){
+    if(!(max > min)){
+        return min;
+    }
+    double origin = min > 0 ? min : max < 0 ? max : 0;
+    uint64_t random_side = 0, random_fraction = 0;
+    if(prop->source == NULL){
+        double value = min + (max - min) * ufbgc_rand_double();
+        random_side = value < origin;
+        double side = random_side ? origin - min : max - origin;
+        random_fraction = side > 0 ? (uint64_t)(fabs(value - origin) / side * 0x1.0p53) : 0;
+    }
+    uint64_t negative = ufbgc_prop_choice(prop,2,random_side);
+    uint64_t fraction = ufbgc_prop_choice(prop,(1ull << 53) + 1,random_fraction);
+    double side = negative ? origin - min : max - origin;
+    double value = origin + (negative ? -1.0 : 1.0) * side * ((double) fraction * 0x1.0p-53);
+    value = value < min ? min : value > max ? max : value;
+    if(prop->verbose){
+        ufbgc_print_blue(ufbgc_get_current_test_file(),"  double %.17g\n",value);
+    }
+    return value;
+}
+
+/*
+    Collections draw a flag before every element after the first min elements, deleting a flag and its element
+    removes one element. The block is registered with the property when the collection is complete
+*/
+static unsigned char * ufbgc_prop_collection(ufbgc_property * prop, size_t min_size, size_t max_size, uint64_t alphabet_size, size_t * size){
+    if(max_size < min_size){
+        max_size = min_size;
+    }
+    size_t target = prop->source == NULL ? min_size + (size_t) ufbgc_rand_below((uint64_t)(max_size - min_size) + 1) : 0;
+    unsigned char * data = NULL;
+    size_t capacity = 0;
+    size_t length = 0;
+    for(;;){
+        if(length >= min_size && (length == max_size || ufbgc_prop_choice(prop,2,length < target) == 0)){
+            break;
+        }
+        if(length + 1 >= capacity){
+            capacity = capacity ? capacity * 2 : 64;
+            unsigned char * grown = (unsigned char *) ufbgc_internal_realloc(data,capacity);
+            if(grown == NULL){
+                break;
+            }
+            data = grown;
+        }
+        data[length++] = (unsigned char) ufbgc_prop_choice(prop,alphabet_size,prop->source == NULL ? ufbgc_rand_below(alphabet_size) : 0);
+    }
+    if(data != NULL && !ufbgc_prop_register(prop,data)){
+        data = NULL;
+        length = 0;
+    }
+    *size = length;
+    return data;
+}
+
+const void * ufbgc_prop_bytes(ufbgc_property * prop, size_t min_size, size_t max_size, size_t * size){
+    static const unsigned char empty[1];
+    size_t length;
+    unsigned char * bytes = ufbgc_prop_collection(prop,min_size,max_size,256,&length);
+    *size = length;
+    if(prop->verbose){
+        FILE * fl = ufbgc_get_current_test_file();
+        ufbgc_print_blue(fl,"  bytes[%lu]",length);
+        for(size_t i = 0; i < length && i < UFBGC_PROPERTY_PRINT_BYTES; ++i){
+            ufbgc_print_blue(fl," %02x",bytes[i]);
+        }
+        ufbgc_print_blue(fl,"%s\n",length > UFBGC_PROPERTY_PRINT_BYTES ? " ..." : "");
+    }
+    return bytes != NULL ? bytes : empty;
+}
+
+const char * ufbgc_prop_string(ufbgc_property * prop, size_t max_length, const char * alphabet){
+    if(alphabet == NULL || alphabet[0] == '\0'){
+        alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+    }
+    size_t alphabet_size = strlen(alphabet);
+    if(alphabet_size > 256){
+        alphabet_size = 256;
+    }
+    size_t length;
+    unsigned char * indices = ufbgc_prop_collection(prop,0,max_length,alphabet_size,&length);
+    if(indices == NULL){
+        return "";
+    }
+    //Collection keeps a byte free for the terminator
+    char * str = (char *) indices;
+    for(size_t i = 0; i < length; ++i){
+        str[i] = alphabet[indices[i]];
+    }
+    str[length] = '\0';
+    if(prop->verbose){
+        ufbgc_print_blue(ufbgc_get_current_test_file(),"  string \"%s\"\n",str);
+    }
+    return str;
+}
+
+//Runs the property once, source NULL draws new random choices
+static ufbgc_return_t ufbgc_property_run(ufbgc_property * prop, ufbgc_property_fun_t property, void * uarg, const uint64_t * source, size_t source_size){
+    prop->source = source;
+    prop->source_size = source_size;
+    prop->position = 0;
+    prop->record.size = 0;
+    ufbgc_return_t result = property(prop,uarg);
+    for(size_t i = 0; i < prop->no_blocks; ++i){
+        ufbgc_internal_free(prop->blocks[i]);
+    }
+    prop->no_blocks = 0;
+    return result;
+}
+
+//Shorter sequences are smaller, sequences of the same length are compared element by element
+static bool ufbgc_choices_less(const uint64_t * a, size_t a_size, const uint64_t * b, size_t b_size){
+    if(a_size != b_size){
+        return a_size < b_size;
+    }
+    for(size_t i = 0; i < a_size; ++i){
+        if(a[i] != b[i]){
+            return a[i] < b[i];
+        }
+    }
+    return false;
+}
+
+typedef struct{
+    ufbgc_property * prop;
+    ufbgc_property_fun_t property;
+    void * uarg;
+    internal_ufbgc_choices best;
+    internal_ufbgc_choices candidate;
+    size_t runs;                    //Runs left for shrinking
+    size_t shrinks;                 //Accepted simplifications
+}internal_ufbgc_shrinker;
+
+//Runs the candidate, it becomes the best one if it still fails and is smaller
+static bool ufbgc_shrink_try(internal_ufbgc_shrinker * shrinker){
+    if(shrinker->runs == 0){
+        return false;
+    }
+    shrinker->runs--;
+    internal_ufbgc_choices * record = &shrinker->prop->record;
+    if(ufbgc_property_run(shrinker->prop,shrinker->property,shrinker->uarg,shrinker->candidate.data,shrinker->candidate.size) == UFBGC_OK ||
+        !ufbgc_choices_less(record->data,record->size,shrinker->best.data,shrinker->best.size)){
+        return false;
+    }
+    ufbgc_choices_copy(&shrinker->best,record->data,record->size);
+    shrinker->shrinks++;
+    return true;
+}
+
+//Binary search over the values of a choice with the same remainder modulo step
+static bool ufbgc_shrink_choice(internal_ufbgc_shrinker * shrinker, size_t i, uint64_t step){
+    bool improved = false;
+    uint64_t remainder = shrinker->best.data[i] % step;
+    uint64_t low = 0, high = shrinker->best.data[i] / step;
+    while(low < high && shrinker->runs > 0){
+        uint64_t middle = low + (high - low) / 2;
+        ufbgc_choices_copy(&shrinker->candidate,shrinker->best.data,shrinker->best.size);
+        shrinker->candidate.data[i] = middle * step + remainder;
+        if(ufbgc_shrink_try(shrinker)){
+            improved = true;
+            if(i >= shrinker->best.size || shrinker->best.data[i] % step != remainder){
+                break;
+            }
+            high = shrinker->best.data[i] / step;
+        }
+        else{
+            low = middle + 1;
+        }
+    }
+    return improved;
+}
+
+static void ufbgc_shrink(internal_ufbgc_shrinker * shrinker){
+    bool improved = true;
+    while(improved && shrinker->runs > 0){
+        improved = false;
+
+        //Delete chunks of choices, e.g. elements of a buffer or whole inputs
+        for(size_t chunk = 8; chunk > 0; chunk /= 2){
+            for(size_t i = shrinker->best.size; i >= chunk; --i){
+                size_t start = i - chunk;
+                if(start + chunk > shrinker->best.size){
+                    continue;
+                }
+                ufbgc_choices_copy(&shrinker->candidate,shrinker->best.data,start);
+                for(size_t j = start + chunk; j < shrinker->best.size; ++j){
+                    ufbgc_choices_push(&shrinker->candidate,shrinker->best.data[j]);
+                }
+                improved |= ufbgc_shrink_try(shrinker);
+            }
+        }
+
+        //Zero chunks
+        for(size_t chunk = 8; chunk > 0; chunk /= 2){
+            for(size_t start = 0; start + chunk <= shrinker->best.size; ++start){
+                bool zero = true;
+                for(size_t j = start; j < start + chunk; ++j){
+                    zero = zero && shrinker->best.data[j] == 0;
+                }
+                if(zero){
+                    continue;
+                }
+                ufbgc_choices_copy(&shrinker->candidate,shrinker->best.data,shrinker->best.size);
+                memset(shrinker->candidate.data + start,0,chunk * sizeof(uint64_t));
+                improved |= ufbgc_shrink_try(shrinker);
+            }
+        }
+
+        //Smallest value of every choice which still fails, the second search keeps the sign of zigzag encoded integers
+        for(size_t i = 0; i < shrinker->best.size; ++i){
+            improved |= ufbgc_shrink_choice(shrinker,i,1);
+            improved |= ufbgc_shrink_choice(shrinker,i,2);
+        }
+    }
+}
+
+static FILE * ufbgc_open_null_stream(){
+    #ifdef UFBGC_POSIX
+        return fopen("/dev/null","w");
+    #else
+        return tmpfile();
+    #endif
+}
+
+ufbgc_return_t ufbgc_check_property(const char * name, ufbgc_property_fun_t property, void * uarg, size_t runs){
+    if(property == NULL){
+        return UFBGC_FAIL;
+    }
+    if(runs == 0){
+        runs = runner_options.property_runs;
+    }
+    name = name != NULL ? name : "property";
+
+    ufbgc_property prop;
+    memset(&prop,0,sizeof(prop));
+
+    //Runs are hidden, assertions of the shrunk input are printed when it runs again
+    internal_ufbgc_test_frame * context = &current_test_frame;
+    FILE * output_file = context->output_file;
+    bool colored = context->colored_output;
+    internal_ufbgc_event_buffer * events = context->events;
+    bool quiet = context->quiet;
+    FILE * null_stream = context->frame != NULL ? ufbgc_open_null_stream() : NULL;
+    if(null_stream != NULL){
+        context->output_file = null_stream;
+        context->colored_output = false;
+    }
+    context->events = NULL;
+    context->quiet = true;
+
+    uint64_t seed = ufbgc_get_seed();
+    size_t failed_run = 0;
+    bool failed = false;
+    for(size_t i = 0; i < runs && !failed; ++i){
+        failed = ufbgc_property_run(&prop,property,uarg,NULL,0) != UFBGC_OK;
+        failed_run = i;
+    }
+
+    internal_ufbgc_shrinker shrinker;
+    memset(&shrinker,0,sizeof(shrinker));
+    if(failed){
+        shrinker.prop = &prop;
+        shrinker.property = property;
+        shrinker.uarg = uarg;
+        shrinker.runs = UFBGC_PROPERTY_SHRINK_RUNS;
+        ufbgc_choices_copy(&shrinker.best,prop.record.data,prop.record.size);
+        ufbgc_shrink(&shrinker);
+    }
+
+    context->output_file = output_file;
+    context->colored_output = colored;
+    context->events = events;
+    context->quiet = quiet;
+    if(null_stream != NULL){
+        fclose(null_stream);
+    }
+
+    ufbgc_return_t result = UFBGC_OK;
+    if(failed){
+        FILE * fl = ufbgc_get_current_test_file();
+        ufbgc_print_red(fl,"Property '%s' failed at run %lu of %lu, shrunk %lu times (seed 0x%016llx)\n",
+            name,failed_run + 1,runs,shrinker.shrinks,(unsigned long long) seed);
+        ufbgc_print_red(fl,"Minimal input:\n");
+        prop.verbose = true;
+        if(ufbgc_property_run(&prop,property,uarg,shrinker.best.data,shrinker.best.size) == UFBGC_OK){
+            ufbgc_print_yellow(fl,"Property '%s' passed with the minimal input, it is flaky\n",name);
+        }
+        result = UFBGC_FAIL;
+    }
+
+    ufbgc_internal_free(shrinker.best.data);
+    ufbgc_internal_free(shrinker.candidate.data);
+    ufbgc_internal_free(prop.record.data);
+    ufbgc_internal_free(prop.blocks);
+    return result;
+}
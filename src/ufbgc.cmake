@@ -0,0 +1,33 @@
+#Settings shared by the ufbgc target of the project and ufbgc_lib of src/CMakeLists.txt
+include_guard(GLOBAL)
+
+set(THREADS_PREFER_PTHREAD_FLAG ON)
+find_package(Threads)
+
+option(UFBGC_ALLOC_TRACKER "Replace malloc family to track allocations of tests (glibc)" OFF)
+option(UFBGC_PROFILE "Keep frame pointers in ufbgc and the targets linking it so profiled stacks are complete" ON)
+
+function(ufbgc_configure_target target)
+    if(Threads_FOUND)
+        target_link_libraries(${target} PUBLIC Threads::Threads)
+    endif()
+    if(UNIX)
+        target_link_libraries(${target} PUBLIC m ${CMAKE_DL_LIBS})
+    endif()
+    if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+        #timer_create of the profiler is in librt before glibc 2.34
+        target_link_libraries(${target} PUBLIC rt)
+    endif()
+    if(UFBGC_ALLOC_TRACKER)
+        target_compile_definitions(${target} PRIVATE UFBGC_ALLOC_TRACKER)
+    endif()
+    #Flags are recorded in the environment of every run
+    string(TOUPPER "${CMAKE_BUILD_TYPE}" build_type)
+    string(STRIP "${CMAKE_C_FLAGS} ${CMAKE_C_FLAGS_${build_type}}" compile_flags)
+    if(UFBGC_PROFILE AND CMAKE_C_COMPILER_ID MATCHES "GNU|Clang")
+        #Public, the profiler walks the frames of the tests, not only of the library
+        target_compile_options(${target} PUBLIC -fno-omit-frame-pointer)
+        string(STRIP "${compile_flags} -fno-omit-frame-pointer" compile_flags)
+    endif()
+    target_compile_definitions(${target} PRIVATE UFBGC_COMPILE_FLAGS="${compile_flags}")
+endfunction()
@@ -40,9 +40,15 @@ typedef enum {
     UFBGC_FAIL
 }ufbgc_return_t;
 
+//Options are flags, they can be combined with '|'
 typedef enum {
-    NO_OPTION,
-    PASS_TEST,
+    NO_OPTION = 0,
+    PASS_TEST = 1 << 0,
+    BENCHMARK_TEST = 1 << 1,                //Test function is a benchmark, see UFBGC_BENCH
+    PERF_COUNTERS = 1 << 2,                 //Hardware performance counters are read around the test function (Linux)
+    TRACK_ALLOCS = 1 << 3,                  //Allocations of setup, test and teardown are counted (glibc)
+    STRESS_TEST = 1 << 4,                   //Test function runs on .threads threads for .rounds rounds, see UFBGC_STRESS
+    PROFILE_STACKS = 1 << 5,                //Stacks of the test function are sampled into a folded file per iteration (Linux)
 }ufbgc_option_t;
 
 typedef enum {
@@ -52,9 +58,24 @@ typedef enum {
 }ufbgc_log_verbosity_t;
 
 
+//Type of a parameter array, typed getters check it unless the parameter is untyped
+typedef enum {
+    UFBGC_PARAM_UNTYPED = 0,
+    UFBGC_PARAM_INT,                        //int array
+    UFBGC_PARAM_DOUBLE,                     //double array
+    UFBGC_PARAM_STRING,                     //const char * array
+    UFBGC_PARAM_BLOB,                       //ufbgc_blob array
+}ufbgc_param_type_t;
+
+typedef struct {
+    const void * data;
+    size_t size;
+} ufbgc_blob;
+
 typedef struct {
     const char * key;
     const void * value;
+    ufbgc_param_type_t type;                //Optional, value holds no_iteration elements of this type
 } ufbgc_args;
 
 typedef struct {
@@ -63,10 +84,98 @@ typedef struct {
 } ufbgc_test_parameters;
 
 
+/*
+    Generators produce the parameters of each iteration on demand, the frame iterates until its generator is exhausted
+    Leaves give the values of a single key, cartesian products and zips combine other generators
+    Typed getters read the current value of a generated key, ufbgc_get_parameter returns a pointer to it
+*/
+typedef enum {
+    UFBGC_GENERATOR_INT_RANGE,              //int values from start to stop (exclusive) by step
+    UFBGC_GENERATOR_DOUBLE_RANGE,           //double values start + i * step before stop
+    UFBGC_GENERATOR_VALUES,                 //Array of values of the given type
+    UFBGC_GENERATOR_FILE,                   //One value per line, empty lines and lines starting with '#' are skipped
+    UFBGC_GENERATOR_CARTESIAN,              //Every combination, last generator changes fastest
+    UFBGC_GENERATOR_ZIP,                    //Generators side by side until the shortest one ends
+}ufbgc_generator_kind_t;
+
+typedef struct ufbgc_generator ufbgc_generator;
+struct ufbgc_generator {
+    ufbgc_generator_kind_t kind;
+    const char * key;                       //Key of the generated values, leaves only
+    ufbgc_param_type_t type;                //Type of the generated values
+    union{
+        struct { int start, stop, step; } int_range;
+        struct { double start, stop, step; } double_range;
+        struct { const void * values; size_t count; } values;
+        const char * path;
+        struct { const ufbgc_generator * const * generators; size_t count; } combine;
+    };
+};
+
+#define UFBGC_INT_RANGE(_key,_start,_stop,_step)                                                       \
+    (&(const ufbgc_generator){ .kind = UFBGC_GENERATOR_INT_RANGE, .key = _key, .type = UFBGC_PARAM_INT,   \
+        .int_range = { _start, _stop, _step } })
+#define UFBGC_DOUBLE_RANGE(_key,_start,_stop,_step)                                                    \
+    (&(const ufbgc_generator){ .kind = UFBGC_GENERATOR_DOUBLE_RANGE, .key = _key, .type = UFBGC_PARAM_DOUBLE, \
+        .double_range = { _start, _stop, _step } })
+#define UFBGC_VALUES(_key,_type,_array)                                                                \
+    (&(const ufbgc_generator){ .kind = UFBGC_GENERATOR_VALUES, .key = _key, .type = _type,             \
+        .values = { _array, sizeof(_array) / sizeof((_array)[0]) } })
+#define UFBGC_FILE_VALUES(_key,_type,_path)                                                            \
+    (&(const ufbgc_generator){ .kind = UFBGC_GENERATOR_FILE, .key = _key, .type = _type, .path = _path })
+#define UFBGC_CARTESIAN(...)                                                                           \
+    (&(const ufbgc_generator){ .kind = UFBGC_GENERATOR_CARTESIAN, .combine = {                         \
+        (const ufbgc_generator * const []){ __VA_ARGS__ },                                             \
+        sizeof((const ufbgc_generator * const []){ __VA_ARGS__ }) / sizeof(const ufbgc_generator *) } })
+#define UFBGC_ZIP(...)                                                                                 \
+    (&(const ufbgc_generator){ .kind = UFBGC_GENERATOR_ZIP, .combine = {                               \
+        (const ufbgc_generator * const []){ __VA_ARGS__ },                                             \
+        sizeof((const ufbgc_generator * const []){ __VA_ARGS__ }) / sizeof(const ufbgc_generator *) } })
+
+
 typedef ufbgc_return_t(* ufbgc_setup_fun_t)(ufbgc_test_parameters * parameters, void ** uarg);
 typedef ufbgc_return_t(* ufbgc_test_fun_t)(ufbgc_test_parameters * parameters, void * uarg);
 typedef ufbgc_return_t(* ufbgc_teardown_fun_t)(ufbgc_test_parameters * parameters, void * uarg);
 
+/*
+    Fixtures are shared by the frames which list them, built when a frame asks for them the first time
+    and torn down when the last of those frames finishes. Data is shared read-only, also across worker threads
+    A fixture asked by a frame which does not list it stays until the run ends
+*/
+typedef ufbgc_return_t(* ufbgc_fixture_setup_fun_t)(void ** data);
+typedef void(* ufbgc_fixture_teardown_fun_t)(void * data);
+
+typedef struct{
+    const char * name;                      //<! Fixture name
+    ufbgc_fixture_setup_fun_t setup_f;      //<! Builds the data, fixture is not available if it fails
+    ufbgc_fixture_teardown_fun_t teardown_f;//<! Releases the data, optional
+    void * internal;                        //<! State of the fixture in a run, must be NULL
+}ufbgc_fixture;
+
+#define UFBGC_FIXTURES(...) ((ufbgc_fixture * const []){ __VA_ARGS__, NULL })
+
+/*
+    Performance budget of every iteration of a frame, fields which are 0 are not checked
+    Size fields flagged in checked are checked even when they are 0, e.g. .checked = UFBGC_BUDGET_ALLOCS allows no allocation
+    An iteration which passes its assertions but exceeds a budget is [OVER BUDGET] and fails the run
+    Iteration running longer than its deadline is stopped by the watchdog and reported as [TIMEOUT]
+*/
+typedef enum{
+    UFBGC_BUDGET_ALLOCS = 1 << 0,
+    UFBGC_BUDGET_RSS_GROWTH = 1 << 1,
+}ufbgc_budget_flag;
+
+typedef struct{
+    double wall_ms;                         //<! Wall time of the test function, median of an operation for a benchmark
+    double cpu_ms;                          //<! CPU time of the test function, mean of an operation for a benchmark
+    size_t allocs;                          //<! Allocations of the test function, turns on allocation tracking (glibc)
+    size_t rss_growth;                      //<! Growth of the peak resident set size of the process in bytes (Linux)
+    double deadline_ms;                     //<! Setup, test and teardown of an iteration, --timeout if 0
+    unsigned checked;                       //<! UFBGC_BUDGET_* flags of the size fields which are checked even if 0
+}ufbgc_budget;
+
+#define UFBGC_BUDGET(...) .budget = { __VA_ARGS__ }
+
 typedef struct{
     ufbgc_test_fun_t test_f;                //<! Actual test function
     const char * name;                      //<! Test name
@@ -76,31 +185,141 @@ typedef struct{
     ufbgc_option_t option;                  //<! Test options
     ufbgc_log_verbosity_t log_level;        //<! Log level of the test
     const char * output_file;               //<! Output file name
+    const ufbgc_generator * generator;      //<! Generated parameters, optional
+    ufbgc_fixture * const * fixtures;       //<! Fixtures used by the frame, NULL terminated, see UFBGC_FIXTURES
+    const char * tags;                      //<! Comma separated tags for --tag, optional
+    const char * version;                   //<! Part of the --cache key, changing it invalidates cached results, optional
+    size_t threads;                         //<! Threads of a STRESS_TEST, 0 is one per online CPU
+    size_t rounds;                          //<! Rounds of a STRESS_TEST, 0 is a single round
+    ufbgc_budget budget;                    //<! Performance budget of an iteration, optional
 }ufbgc_test_frame;
 
+/*
+    Test macros also put a registration of their frame into the "ufbgc_tests" section of the binary (ELF targets)
+    ufbgc_run_all finds the frames of every translation unit linked into the executable, no test list is needed
+    Frames written by hand are registered with UFBGC_REGISTER(frame_variable);
+*/
+typedef struct{
+    const ufbgc_test_frame * frame;
+    const char * file;                      //Registered frames run sorted by file and line
+    int line;
+}ufbgc_registration;
+
+#if defined(__ELF__) && defined(__GNUC__)
+#define UFBGC_AUTO_REGISTRATION
+#define UFBGC_REGISTER(_frame)                                                                          \
+    static const ufbgc_registration _frame##_registration = { &(_frame), __FILE__, __LINE__ };         \
+    static const ufbgc_registration * const _frame##_registration_ptr                                   \
+        __attribute__((used, section("ufbgc_tests"))) = &_frame##_registration
+extern const ufbgc_registration * const __start_ufbgc_tests[] __attribute__((weak));
+extern const ufbgc_registration * const __stop_ufbgc_tests[] __attribute__((weak));
+#define ufbgc_run_all(argc,argv) ufbgc_run_registered(__start_ufbgc_tests,__stop_ufbgc_tests,argc,argv)
+#else
+#define UFBGC_REGISTER(_frame) extern int ufbgc_no_registration
+#define ufbgc_run_all(argc,argv) ufbgc_run_registered(NULL,NULL,argc,argv)
+#endif
+#define UFBGC_INTERNAL_REGISTER(_frame) extern const ufbgc_test_frame _frame; UFBGC_REGISTER(_frame);
+
 ufbgc_return_t ufbgc_start_test(const ufbgc_test_frame * test_list, size_t list_len);
+ufbgc_return_t ufbgc_start_test_parallel(const ufbgc_test_frame * test_list, size_t list_len, size_t n_workers);
+ufbgc_return_t ufbgc_start_test_isolated(const ufbgc_test_frame * test_list, size_t list_len, size_t n_workers);
+ufbgc_return_t ufbgc_parse_args(int argc, char const * argv[]);
+ufbgc_return_t ufbgc_run_registered(const ufbgc_registration * const * begin, const ufbgc_registration * const * end, int argc, char const * argv[]);
 const void * ufbgc_get_parameter(const char * key);
+const void * ufbgc_get_fixture(ufbgc_fixture * fixture);
+const void * ufbgc_lookup_parameter(const char * key, ufbgc_param_type_t type, size_t * it);
+bool ufbgc_get_parameter_int(const char * key, int * dest);
+bool ufbgc_get_parameter_double(const char * key, double * dest);
+bool ufbgc_get_parameter_string(const char * key, const char ** dest);
+bool ufbgc_get_parameter_blob(const char * key, ufbgc_blob * dest);
 bool ufbgc_get_current_test_iterator(size_t * it);
 
 ufbgc_log_verbosity_t ufbgc_get_current_test_verbosity();
 FILE * ufbgc_get_current_test_file();
+bool ufbgc_is_colored_file(FILE * fl);
+
+/*
+    Reporters receive the events of a run while it runs, in test list order and always on the thread which started the run
+    Parallel and isolated runs deliver the events of a test when the test is finished
+*/
+typedef enum{
+    UFBGC_EVENT_TEST_START = 1,
+    UFBGC_EVENT_ASSERT_FAIL,
+    UFBGC_EVENT_ITERATION_END,
+    UFBGC_EVENT_TEST_END,
+}ufbgc_event_type_t;
+
+typedef enum{
+    UFBGC_STATUS_OK = 0,
+    UFBGC_STATUS_FAILED,
+    UFBGC_STATUS_CRASHED,
+    UFBGC_STATUS_SKIPPED,               //PASS_TEST
+    UFBGC_STATUS_REGRESSED,
+    UFBGC_STATUS_CACHED,                //Passed before with the same cache key, not run
+    UFBGC_STATUS_OVER_BUDGET,           //Passed its assertions but exceeded its budget
+    UFBGC_STATUS_TIMEOUT,               //Stopped by the watchdog at its deadline
+}ufbgc_status_t;
+
+typedef struct{
+    ufbgc_event_type_t type;
+    const char * test;                  //Test name
+    size_t iteration;
+    ufbgc_status_t status;              //Iteration and test end
+    double wall_ms;                     //Iteration end: time of the iteration, test end: sum of the iterations
+    double cpu_ms;
+    uint64_t cycles;
+    ufbgc_log_verbosity_t log_level;    //Assertion failure: UFBGC_LOG_ERROR for assert, UFBGC_LOG_WARNING for likely
+    const char * assert_type;           //Assertion failure, e.g. "assert", "likely"
+    const char * condition;
+    const char * file;
+    const char * function;
+    unsigned line;
+    const char * message;               //Note of the assertion, crash reason of a test end, exceeded budgets of an iteration end or noise sources of a test start, "" if there is none
+    uint64_t timestamp_ns;              //Unix time of the event
+}ufbgc_event;
+
+typedef struct{
+    void (*run_start)(void * context, size_t no_tests);
+    void (*event)(void * context, const ufbgc_event * event);
+    void (*run_end)(void * context, ufbgc_return_t result);
+    void * context;
+}ufbgc_reporter;
+
+bool ufbgc_add_reporter(const ufbgc_reporter * reporter);
+//Built in reporters, format is "junit", "jsonl" or "binary", file is created when a run starts
+bool ufbgc_add_report_file(const char * format, const char * path);
+void ufbgc_clear_reporters();
+
+//Machine and build of a run, collected when a run starts, after the runner thread is pinned
+typedef struct{
+    char cpu_model[128];
+    size_t online_cpus;
+    char kernel[128];                   //System name, release and machine
+    char governor[32];                  //Frequency governor of the CPU of the runner, "" without cpufreq
+    char compiler[128];
+    char compile_flags[256];            //Flags the library is built with
+}ufbgc_environment;
+
+const ufbgc_environment * ufbgc_get_environment();
 
 
 //If flag is one put the color, if not then put the string
 #define UFBGC_COLOR_SANDWICH(flag,color,format) ((flag) ? color format ANSI_COLOR_RESET : format)
+//Output is colored when it ends up in stdout (parallel runs buffer stdout output in memory first)
+#define UFBGC_COLORED(fl) ((fl) == stdout || ufbgc_is_colored_file(fl))
 //#define UFBGC_COLOR_SANDWICH_DET(flag,color,format) (flag ? color "%s/%s:%u" format ANSI_COLOR_RESET ,__FILE__,__FUNCTION__,  __LINE__ : "%s/%s:%u" format ,__FILE__,__FUNCTION__,  __LINE__)
 //#define UFBGC_COLORED_PRINT(color,format) color format ANSI_COLOR_RESET
 //#define UFBGC_COLORED_PRINT_DETAILED(color,format,rst) color "%s/%s:%u" format rst ,__FILE__, __FUNCTION__, __LINE__
 
-#define ufbgc_print_red(fl,format,...)     fprintf(fl,UFBGC_COLOR_SANDWICH(fl==stdout,ANSI_COLOR_RED,format),##__VA_ARGS__)
-#define ufbgc_print_green(fl,format,...)   fprintf(fl,UFBGC_COLOR_SANDWICH(fl==stdout,ANSI_COLOR_GREEN,format),##__VA_ARGS__)
-#define ufbgc_print_blue(fl,format,...)    fprintf(fl,UFBGC_COLOR_SANDWICH(fl==stdout,ANSI_COLOR_BLUE ,format),##__VA_ARGS__)
-#define ufbgc_print_yellow(fl,format,...)  fprintf(fl,UFBGC_COLOR_SANDWICH(fl==stdout,ANSI_COLOR_YELLOW ,format),##__VA_ARGS__)
-#define ufbgc_print_cyan(fl,format,...)    fprintf(fl,UFBGC_COLOR_SANDWICH(fl==stdout,ANSI_COLOR_CYAN ,format),##__VA_ARGS__)
-#define ufbgc_print_white(fl,format,...)   fprintf(fl,UFBGC_COLOR_SANDWICH(fl==stdout,ANSI_COLOR_WHITE ,format),##__VA_ARGS__)
-#define ufbgc_print_magenta(fl,format,...) fprintf(fl,UFBGC_COLOR_SANDWICH(fl==stdout,ANSI_COLOR_MAGENTA ,format),##__VA_ARGS__)
-#define ufbgc_print_black(fl,format,...)   fprintf(fl,UFBGC_COLOR_SANDWICH(fl==stdout,ANSI_COLOR_BLACK ,format),##__VA_ARGS__)
-#define ufbgc_print_line(fl,color)         fprintf(fl,UFBGC_COLOR_SANDWICH(fl==stdout,color,"%s/%s:%u"),__FILE__,__FUNCTION__,__LINE__)
+#define ufbgc_print_red(fl,format,...)     fprintf(fl,UFBGC_COLOR_SANDWICH(UFBGC_COLORED(fl),ANSI_COLOR_RED,format),##__VA_ARGS__)
+#define ufbgc_print_green(fl,format,...)   fprintf(fl,UFBGC_COLOR_SANDWICH(UFBGC_COLORED(fl),ANSI_COLOR_GREEN,format),##__VA_ARGS__)
+#define ufbgc_print_blue(fl,format,...)    fprintf(fl,UFBGC_COLOR_SANDWICH(UFBGC_COLORED(fl),ANSI_COLOR_BLUE ,format),##__VA_ARGS__)
+#define ufbgc_print_yellow(fl,format,...)  fprintf(fl,UFBGC_COLOR_SANDWICH(UFBGC_COLORED(fl),ANSI_COLOR_YELLOW ,format),##__VA_ARGS__)
+#define ufbgc_print_cyan(fl,format,...)    fprintf(fl,UFBGC_COLOR_SANDWICH(UFBGC_COLORED(fl),ANSI_COLOR_CYAN ,format),##__VA_ARGS__)
+#define ufbgc_print_white(fl,format,...)   fprintf(fl,UFBGC_COLOR_SANDWICH(UFBGC_COLORED(fl),ANSI_COLOR_WHITE ,format),##__VA_ARGS__)
+#define ufbgc_print_magenta(fl,format,...) fprintf(fl,UFBGC_COLOR_SANDWICH(UFBGC_COLORED(fl),ANSI_COLOR_MAGENTA ,format),##__VA_ARGS__)
+#define ufbgc_print_black(fl,format,...)   fprintf(fl,UFBGC_COLOR_SANDWICH(UFBGC_COLORED(fl),ANSI_COLOR_BLACK ,format),##__VA_ARGS__)
+#define ufbgc_print_line(fl,color)         fprintf(fl,UFBGC_COLOR_SANDWICH(UFBGC_COLORED(fl),color,"%s/%s:%u"),__FILE__,__FUNCTION__,__LINE__)
 
 #define ufbgc_print_fail(name,format,...)                   \
     do{                                                     \
@@ -122,23 +341,41 @@ FILE * ufbgc_get_current_test_file();
     }while(0)
 
 
-#define ufbgc_assert_full(log_level,type,condition,expected,should_return,format,...)                           \
-    do{                                                                                                         \
-        FILE * fl = ufbgc_get_current_test_file();                                                              \
-        if(ufbgc_get_current_test_verbosity() >= log_level && __builtin_expect(condition,1) == expected){       \
-            ufbgc_print_fail(type,"%s",#condition);                                                             \
-            if(strcmp(format,"")){                                                                              \
-                ufbgc_print_yellow(fl,"\nNote:{");                                                              \
-                ufbgc_print_blue(fl,format,##__VA_ARGS__);                                                      \
-                ufbgc_print_yellow(fl,"}\n\n");                                                                 \
-            }                                                                                                   \
-            if(should_return){return UFBGC_FAIL;}                                                               \
-        }                                                                                                       \
-        else{                                                                                                   \
-            if(ufbgc_get_current_test_verbosity() >= UFBGC_LOG_INFO){                                           \
-                ufbgc_print_pass(type,"%s",#condition);                                                         \
-            }                                                                                                   \
-        }                                                                                                       \
+/*
+    Passing assertion is a single predicted branch, failures are formatted by an out of line function
+    Passes are reported only while a frame with UFBGC_LOG_INFO runs, define UFBGC_MAX_VERBOSITY before including
+    ufbgc.h to remove reporting above that level at compile time, e.g. UFBGC_LOG_WARNING drops pass reporting
+*/
+#ifndef UFBGC_MAX_VERBOSITY
+    #define UFBGC_MAX_VERBOSITY UFBGC_LOG_INFO
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define UFBGC_COLD __attribute__((cold,noinline))
+    #define UFBGC_EXPECT_FALSE(x) __builtin_expect(!!(x),0)
+#else
+    #define UFBGC_COLD
+    #define UFBGC_EXPECT_FALSE(x) (x)
+#endif
+
+extern int ufbgc_pass_reporting;        //Number of running frames with UFBGC_LOG_INFO verbosity
+
+UFBGC_COLD bool ufbgc_assert_failed(ufbgc_log_verbosity_t log_level, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, ...);
+UFBGC_COLD void ufbgc_assert_passed(const char * type, const char * condition, const char * file, const char * function, unsigned line);
+
+#define ufbgc_assert_full(log_level,type,condition,expected,should_return,format,...)                                   \
+    do{                                                                                                                 \
+        if(UFBGC_EXPECT_FALSE((!!(condition)) == (expected))){                                                        \
+            if((log_level) <= UFBGC_MAX_VERBOSITY &&                                                                    \
+                ufbgc_assert_failed(log_level,type,#condition,__FILE__,__FUNCTION__,__LINE__,format,##__VA_ARGS__) &&   \
+                (should_return)){                                                                                       \
+                return UFBGC_FAIL;                                                                                      \
+            }                                                                                                           \
+        }                                                                                                               \
+        else if(UFBGC_MAX_VERBOSITY >= UFBGC_LOG_INFO && UFBGC_EXPECT_FALSE(ufbgc_pass_reporting)){                     \
+            ufbgc_assert_passed(type,#condition,__FILE__,__FUNCTION__,__LINE__);                                        \
+        }                                                                                                               \
     }while(0)
 
 
@@ -175,8 +412,160 @@ FILE * ufbgc_get_current_test_file();
 #define ufbgc_assert_eqstr(a,b) ufbgc_assert_full(UFBGC_LOG_ERROR,"assert_eqstr",!strcmp(a,b),false,true,"")
 #define ufbgc_assert_eqstr_(a,b,format, ...) ufbgc_assert_full(UFBGC_LOG_ERROR,"assert_eqstr",!strcmp(a,b),false,true,format,##__VA_ARGS__)
 
-#define ufbgc_assert_eqmem(a,b,size) ufbgc_assert_full(UFBGC_LOG_ERROR,"assert_eqmem",!memcmp(a,b,size),false,true,"")
-#define ufbgc_assert_eqmem_(a,b,size,format, ...) ufbgc_assert_full(UFBGC_LOG_ERROR,"assert_eqmem",!memcmp(a,b,size),false,true,format,##__VA_ARGS__)
+#define ufbgc_assert_max_allocs(n)                                                                                  \
+    ufbgc_assert_full(UFBGC_LOG_ERROR,"assert_max_allocs",ufbgc_alloc_tracking() && ufbgc_get_test_allocations() <= (size_t)(n),false,true,   \
+        "%lu allocations, max %lu%s",(unsigned long) ufbgc_get_test_allocations(),(unsigned long)(n),                    \
+        ufbgc_alloc_tracking() ? "" : " (allocation tracking is off)")
+#define ufbgc_assert_no_leak()                                                                                      \
+    ufbgc_assert_full(UFBGC_LOG_ERROR,"assert_no_leak",ufbgc_alloc_tracking() && ufbgc_get_test_live_allocations() == 0,false,true, \
+        "%lu allocations (%lu bytes) not freed%s",(unsigned long) ufbgc_get_test_live_allocations(),                   \
+        (unsigned long) ufbgc_get_test_live_bytes(),ufbgc_alloc_tracking() ? "" : " (allocation tracking is off)")
+
+/*
+    Buffer comparisons find the first mismatch and count all of them, bytes are compared with AVX2 or SSE2 when available
+    Failures print the mismatch count and a window around the first mismatch, hex for bytes and values for floats
+    Floating point elements are equal within any of the tolerances, NaN is equal to NaN, 0 disables a tolerance
+*/
+typedef enum{
+    UFBGC_ELEM_BYTES = 0,                   //Elements of elem_size bytes compared bitwise
+    UFBGC_ELEM_FLOAT,
+    UFBGC_ELEM_DOUBLE,
+}ufbgc_elem_type_t;
+
+typedef struct{
+    double abs;                             //Maximum absolute difference
+    double rel;                             //Maximum difference relative to the bigger magnitude
+    uint64_t ulp;                           //Maximum distance in units in the last place
+}ufbgc_tolerance;
+
+#define UFBGC_TOLERANCE(_abs,_rel,_ulp) ((ufbgc_tolerance){ .abs = _abs, .rel = _rel, .ulp = _ulp })
+#define UFBGC_ABS_TOLERANCE(_abs) UFBGC_TOLERANCE(_abs,0,0)
+#define UFBGC_REL_TOLERANCE(_rel) UFBGC_TOLERANCE(0,_rel,0)
+#define UFBGC_ULP_TOLERANCE(_ulp) UFBGC_TOLERANCE(0,0,_ulp)
+
+typedef struct{
+    ufbgc_elem_type_t type;
+    size_t elem_size;
+    size_t count;                           //Compared elements
+    size_t first;                           //Index of the first mismatching element, count if there is none
+    size_t mismatches;                      //Number of mismatching elements
+    double max_diff;                        //Largest absolute difference of mismatching floating point elements
+    ufbgc_tolerance tolerance;
+}ufbgc_mismatch;
+
+size_t ufbgc_compare_mem(const void * a, const void * b, size_t count, size_t elem_size, ufbgc_mismatch * mismatch);
+size_t ufbgc_compare_floats(const float * a, const float * b, size_t count, ufbgc_tolerance tolerance, ufbgc_mismatch * mismatch);
+size_t ufbgc_compare_doubles(const double * a, const double * b, size_t count, ufbgc_tolerance tolerance, ufbgc_mismatch * mismatch);
+UFBGC_COLD bool ufbgc_assert_mismatch(const ufbgc_mismatch * mismatch, const void * a, const void * b, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, ...);
+
+/*
+    a and b are evaluated once into ufbgc_a_ and ufbgc_b_, compare expressions use these
+    Expressions under sizeof only check the types of a and b, they are not evaluated
+*/
+#define ufbgc_assert_compare_full(type,a,b,compare,condition,format,...)                                               \
+    do{                                                                                                                 \
+        const void * ufbgc_a_ = (a);                                                                                    \
+        const void * ufbgc_b_ = (b);                                                                                    \
+        ufbgc_mismatch ufbgc_mismatch_;                                                                                 \
+        if(UFBGC_EXPECT_FALSE((compare) != 0)){                                                                         \
+            if(ufbgc_assert_mismatch(&ufbgc_mismatch_,ufbgc_a_,ufbgc_b_,type,condition,__FILE__,__FUNCTION__,__LINE__,format,##__VA_ARGS__)){ \
+                return UFBGC_FAIL;                                                                                      \
+            }                                                                                                           \
+        }                                                                                                               \
+        else if(UFBGC_MAX_VERBOSITY >= UFBGC_LOG_INFO && UFBGC_EXPECT_FALSE(ufbgc_pass_reporting)){                     \
+            ufbgc_assert_passed(type,condition,__FILE__,__FUNCTION__,__LINE__);                                        \
+        }                                                                                                               \
+    }while(0)
+
+//size is in bytes
+#define ufbgc_assert_eqmem(a,b,size)                                                                                   \
+    ufbgc_assert_compare_full("assert_eqmem",a,b,ufbgc_compare_mem(ufbgc_a_,ufbgc_b_,size,1,&ufbgc_mismatch_),           \
+        #a " == " #b " [" #size " bytes]","")
+#define ufbgc_assert_eqmem_(a,b,size,format, ...)                                                                      \
+    ufbgc_assert_compare_full("assert_eqmem",a,b,ufbgc_compare_mem(ufbgc_a_,ufbgc_b_,size,1,&ufbgc_mismatch_),           \
+        #a " == " #b " [" #size " bytes]",format,##__VA_ARGS__)
+
+//count is in elements, both arrays must have the same element size
+#define ufbgc_internal_compare_array(a,b,count)                                                                        \
+    ((void) sizeof(char[sizeof(*(a)) == sizeof(*(b)) ? 1 : -1]),                                                       \
+        ufbgc_compare_mem(ufbgc_a_,ufbgc_b_,count,sizeof(*(a)),&ufbgc_mismatch_))
+#define ufbgc_assert_eqarray(a,b,count)                                                                                \
+    ufbgc_assert_compare_full("assert_eqarray",a,b,ufbgc_internal_compare_array(a,b,count),                            \
+        #a " == " #b " [" #count " elements]","")
+#define ufbgc_assert_eqarray_(a,b,count,format, ...)                                                                   \
+    ufbgc_assert_compare_full("assert_eqarray",a,b,ufbgc_internal_compare_array(a,b,count),                            \
+        #a " == " #b " [" #count " elements]",format,##__VA_ARGS__)
+
+#define ufbgc_internal_compare_floats(a,b,count,tolerance)                                                             \
+    ((void) sizeof(ufbgc_compare_floats(a,b,0,tolerance,NULL)),                                                        \
+        ufbgc_compare_floats((const float *) ufbgc_a_,(const float *) ufbgc_b_,count,tolerance,&ufbgc_mismatch_))
+#define ufbgc_assert_near_floats(a,b,count,tolerance)                                                                  \
+    ufbgc_assert_compare_full("assert_near_floats",a,b,ufbgc_internal_compare_floats(a,b,count,tolerance),             \
+        #a " ~= " #b " [" #count " floats, " #tolerance "]","")
+#define ufbgc_assert_near_floats_(a,b,count,tolerance,format, ...)                                                     \
+    ufbgc_assert_compare_full("assert_near_floats",a,b,ufbgc_internal_compare_floats(a,b,count,tolerance),             \
+        #a " ~= " #b " [" #count " floats, " #tolerance "]",format,##__VA_ARGS__)
+
+#define ufbgc_internal_compare_doubles(a,b,count,tolerance)                                                            \
+    ((void) sizeof(ufbgc_compare_doubles(a,b,0,tolerance,NULL)),                                                       \
+        ufbgc_compare_doubles((const double *) ufbgc_a_,(const double *) ufbgc_b_,count,tolerance,&ufbgc_mismatch_))
+#define ufbgc_assert_near_doubles(a,b,count,tolerance)                                                                 \
+    ufbgc_assert_compare_full("assert_near_doubles",a,b,ufbgc_internal_compare_doubles(a,b,count,tolerance),           \
+        #a " ~= " #b " [" #count " doubles, " #tolerance "]","")
+#define ufbgc_assert_near_doubles_(a,b,count,tolerance,format, ...)                                                    \
+    ufbgc_assert_compare_full("assert_near_doubles",a,b,ufbgc_internal_compare_doubles(a,b,count,tolerance),           \
+        #a " ~= " #b " [" #count " doubles, " #tolerance "]",format,##__VA_ARGS__)
+
+/*
+    Golden files are mapped and compared in windows, outputs of any size are compared without reading them into memory
+    With UFBGC_UPDATE_GOLDEN=1 in the environment a differing or missing golden file is rewritten atomically and
+    the assertion passes, frames comparing golden files are never cached by --cache
+*/
+typedef struct{
+    ufbgc_mismatch mismatch;                //Bytes of the common prefix of the output and the golden file
+    const void * data;                      //Output buffer, NULL if the output is a file
+    const char * path;                      //Output file, NULL if the output is a buffer
+    const char * golden_path;
+    size_t size;                            //Size of the output
+    size_t golden_size;
+    const char * error;                     //File which cannot be read, NULL if both are read
+    bool updated;                           //Golden file is rewritten by UFBGC_UPDATE_GOLDEN
+}ufbgc_golden;
+
+//Both return the number of differing bytes, bytes past the end of the shorter one differ, SIZE_MAX if a file cannot be read
+size_t ufbgc_compare_golden(const void * data, size_t size, const char * golden_path, ufbgc_golden * golden);
+size_t ufbgc_compare_golden_file(const char * path, const char * golden_path, ufbgc_golden * golden);
+UFBGC_COLD bool ufbgc_assert_golden_failed(const ufbgc_golden * golden, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, ...);
+
+#define ufbgc_assert_golden_full(type,compare,condition,format,...)                                                   \
+    do{                                                                                                                 \
+        ufbgc_golden ufbgc_golden_;                                                                                     \
+        if(UFBGC_EXPECT_FALSE((compare) != 0)){                                                                         \
+            if(ufbgc_assert_golden_failed(&ufbgc_golden_,type,condition,__FILE__,__FUNCTION__,__LINE__,format,##__VA_ARGS__)){ \
+                return UFBGC_FAIL;                                                                                      \
+            }                                                                                                           \
+        }                                                                                                               \
+        else if(UFBGC_MAX_VERBOSITY >= UFBGC_LOG_INFO && UFBGC_EXPECT_FALSE(ufbgc_pass_reporting)){                     \
+            ufbgc_assert_passed(type,condition,__FILE__,__FUNCTION__,__LINE__);                                        \
+        }                                                                                                               \
+    }while(0)
+
+//size is in bytes
+#define ufbgc_assert_golden(data,size,golden_path)                                                                     \
+    ufbgc_assert_golden_full("assert_golden",ufbgc_compare_golden(data,size,golden_path,&ufbgc_golden_),                \
+        #data " == " #golden_path " [" #size " bytes]","")
+#define ufbgc_assert_golden_(data,size,golden_path,format, ...)                                                        \
+    ufbgc_assert_golden_full("assert_golden",ufbgc_compare_golden(data,size,golden_path,&ufbgc_golden_),                \
+        #data " == " #golden_path " [" #size " bytes]",format,##__VA_ARGS__)
+
+#define ufbgc_assert_golden_file(path,golden_path)                                                                     \
+    ufbgc_assert_golden_full("assert_golden_file",ufbgc_compare_golden_file(path,golden_path,&ufbgc_golden_),           \
+        #path " == " #golden_path,"")
+#define ufbgc_assert_golden_file_(path,golden_path,format, ...)                                                        \
+    ufbgc_assert_golden_full("assert_golden_file",ufbgc_compare_golden_file(path,golden_path,&ufbgc_golden_),           \
+        #path " == " #golden_path,format,##__VA_ARGS__)
 
 #define ufbgc_assert_null(a) ufbgc_assert(a != NULL)
 #define ufbgc_assert_null_(a,format,...) ufbgc_assert_(a != NULL,format,##__VA_ARGS__)
@@ -185,15 +574,27 @@ FILE * ufbgc_get_current_test_file();
 #define __ufbgc_internal_assert(condition) __ufbgc_internal_assert_full("internal-assert",condition,false,true,"");
 #define __ufbgc_internal_assert_(condition,format, ...) __ufbgc_internal_assert_full("internal-assert",condition,false,true,format,##__VA_ARGS__);
 
-#define ufbgc_get_param(buf, key, cast)                         \
-    do{                                                         \
-        size_t it = 0;                                          \
-        ufbgc_get_current_test_iterator(&it);                   \
-        const void * p = ufbgc_get_parameter(key);              \
-        __ufbgc_internal_assert_(p != NULL,"No key found!");    \
-        buf = ((cast) p)[it];                                   \
+#define ufbgc_get_param(buf, key, cast)                                         \
+    do{                                                                         \
+        size_t it = 0;                                                          \
+        const void * p = ufbgc_lookup_parameter(key,UFBGC_PARAM_UNTYPED,&it);   \
+        __ufbgc_internal_assert_(p != NULL,"No key found!");                    \
+        buf = ((cast) p)[it];                                                   \
     }while(0)
 
+#define ufbgc_use_fixture(buf, fixture, cast)                                                   \
+    do{                                                                                         \
+        const void * p = ufbgc_get_fixture(&(fixture));                                         \
+        __ufbgc_internal_assert_(p != NULL,"Fixture '%s' is not available",(fixture).name);     \
+        buf = (cast) p;                                                                         \
+    }while(0)
+
+//Typed getters fail the test if the key is missing, has an other type or the iteration is out of no_iteration
+#define ufbgc_get_param_int(buf, key)    __ufbgc_internal_assert_(ufbgc_get_parameter_int(key,&(buf)),"Parameter '%s'",key)
+#define ufbgc_get_param_double(buf, key) __ufbgc_internal_assert_(ufbgc_get_parameter_double(key,&(buf)),"Parameter '%s'",key)
+#define ufbgc_get_param_string(buf, key) __ufbgc_internal_assert_(ufbgc_get_parameter_string(key,&(buf)),"Parameter '%s'",key)
+#define ufbgc_get_param_blob(buf, key)   __ufbgc_internal_assert_(ufbgc_get_parameter_blob(key,&(buf)),"Parameter '%s'",key)
+
 
 
 
@@ -203,12 +604,190 @@ double ufbgc_get_execution_time(clock_t start);
 double ufbgc_get_execution_time_ms(clock_t start);
 double ufbgc_get_execution_time_us(clock_t start);
 
-//Random helpers
-int ufbgc_randint(int min, int max);
+/*
+    Timer samples wall time (CLOCK_MONOTONIC_RAW), CPU time of the calling thread and TSC cycles together
+    Cycles are zero if the CPU has no invariant time stamp counter
+*/
+typedef struct{
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+    uint64_t cycles;
+}ufbgc_time_sample;
+
+typedef struct{
+    ufbgc_time_sample start;
+    ufbgc_time_sample elapsed;
+}ufbgc_timer;
+
+void ufbgc_timer_now(ufbgc_time_sample * sample);
+void ufbgc_timer_start(ufbgc_timer * timer);
+void ufbgc_timer_stop(ufbgc_timer * timer);
+uint64_t ufbgc_get_wall_time_ns();
+uint64_t ufbgc_get_thread_cpu_time_ns();
+uint64_t ufbgc_get_cycles();
+double ufbgc_get_cycle_frequency();
+
+/*
+    Histogram counts values in log-linear buckets, a value is recorded with less than 1/64 relative error
+    Its size is fixed and zero memory is an empty histogram, threads record into their own and merge them
+    Latencies are recorded in nanoseconds, ufbgc_report_histogram prints p50/p99/p999/max after the [OK] line of the iteration
+*/
+#define UFBGC_HISTOGRAM_SUB_BITS 7
+#define UFBGC_HISTOGRAM_BUCKETS ((64 - UFBGC_HISTOGRAM_SUB_BITS + 2) << (UFBGC_HISTOGRAM_SUB_BITS - 1))
+
+typedef struct{
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+    uint64_t buckets[UFBGC_HISTOGRAM_BUCKETS];
+}ufbgc_histogram;
+
+void ufbgc_histogram_reset(ufbgc_histogram * histogram);
+void ufbgc_histogram_record(ufbgc_histogram * histogram, uint64_t value);
+void ufbgc_histogram_record_n(ufbgc_histogram * histogram, uint64_t value, uint64_t count);
+void ufbgc_histogram_merge(ufbgc_histogram * dest, const ufbgc_histogram * src);
+uint64_t ufbgc_histogram_percentile(const ufbgc_histogram * histogram, double percentile);   //Upper bound of the bucket, at most max
+double ufbgc_histogram_mean(const ufbgc_histogram * histogram);
+void ufbgc_report_histogram(const char * name, const ufbgc_histogram * histogram);            //Percentiles are copied, histogram can be freed
+
+/*
+    Percentile assertions compare a percentile of a latency histogram against a limit, op is one of < <= > >= ==
+    ufbgc_assert_percentile takes a duration literal with ns, us, ms or s unit, e.g. 200us, 1.5ms
+    ufbgc_assert_percentile_ns takes an expression in nanoseconds
+*/
+typedef struct{
+    const ufbgc_histogram * histogram;
+    double percentile;
+    uint64_t value;
+    double limit_ns;
+    const char * limit;
+    const char * error;             //Reason the comparison cannot be made, NULL if it is made
+}ufbgc_percentile_check;
+
+bool ufbgc_check_percentile(const ufbgc_histogram * histogram, double percentile, const char * op, const char * limit, ufbgc_percentile_check * check);
+bool ufbgc_check_percentile_ns(const ufbgc_histogram * histogram, double percentile, const char * op, double limit_ns, ufbgc_percentile_check * check);
+UFBGC_COLD bool ufbgc_assert_percentile_failed(const ufbgc_percentile_check * check, const char * type, const char * condition,
+    const char * file, const char * function, unsigned line, const char * format, ...);
+
+#define ufbgc_assert_percentile_full(type,check,condition,format,...)                                                  \
+    do{                                                                                                                 \
+        ufbgc_percentile_check ufbgc_check_;                                                                            \
+        if(UFBGC_EXPECT_FALSE(!(check))){                                                                               \
+            if(ufbgc_assert_percentile_failed(&ufbgc_check_,type,condition,__FILE__,__FUNCTION__,__LINE__,format,##__VA_ARGS__)){ \
+                return UFBGC_FAIL;                                                                                      \
+            }                                                                                                           \
+        }                                                                                                               \
+        else if(UFBGC_MAX_VERBOSITY >= UFBGC_LOG_INFO && UFBGC_EXPECT_FALSE(ufbgc_pass_reporting)){                     \
+            ufbgc_assert_passed(type,condition,__FILE__,__FUNCTION__,__LINE__);                                        \
+        }                                                                                                               \
+    }while(0)
+
+#define ufbgc_assert_percentile(histogram,percentile,op,limit)                                                         \
+    ufbgc_assert_percentile_full("assert_percentile",ufbgc_check_percentile(histogram,percentile,#op,#limit,&ufbgc_check_), \
+        "p" #percentile " of " #histogram " " #op " " #limit,"")
+#define ufbgc_assert_percentile_(histogram,percentile,op,limit,format, ...)                                            \
+    ufbgc_assert_percentile_full("assert_percentile",ufbgc_check_percentile(histogram,percentile,#op,#limit,&ufbgc_check_), \
+        "p" #percentile " of " #histogram " " #op " " #limit,format,##__VA_ARGS__)
+
+#define ufbgc_assert_percentile_ns(histogram,percentile,op,limit_ns)                                                   \
+    ufbgc_assert_percentile_full("assert_percentile",                                                                   \
+        ufbgc_check_percentile_ns(histogram,percentile,#op,(double)(limit_ns),&ufbgc_check_),                           \
+        "p" #percentile " of " #histogram " " #op " " #limit_ns " ns","")
+#define ufbgc_assert_percentile_ns_(histogram,percentile,op,limit_ns,format, ...)                                      \
+    ufbgc_assert_percentile_full("assert_percentile",                                                                   \
+        ufbgc_check_percentile_ns(histogram,percentile,#op,(double)(limit_ns),&ufbgc_check_),                           \
+        "p" #percentile " of " #histogram " " #op " " #limit_ns " ns",format,##__VA_ARGS__)
+
+/*
+    Allocation statistics of the running test function, needs TRACK_ALLOCS or --track-allocs
+    Live allocations are the ones not freed yet, peak is the maximum of live bytes
+*/
+typedef struct{
+    size_t allocations;
+    size_t frees;
+    size_t bytes;
+    size_t peak_bytes;
+    size_t live_allocations;
+    size_t live_bytes;
+}ufbgc_alloc_stats;
+
+bool ufbgc_alloc_tracking();
+bool ufbgc_get_alloc_stats(ufbgc_alloc_stats * stats);
+size_t ufbgc_get_test_allocations();
+size_t ufbgc_get_test_live_allocations();
+size_t ufbgc_get_test_live_bytes();
+
+/*
+    Random numbers come from a xoshiro256** generator of the calling thread
+    Every test iteration is seeded from the seed of the run, the test name and the iteration, --seed=N repeats a run
+    Seed is printed when an iteration which used random numbers fails
+*/
+uint64_t ufbgc_get_seed();
+void ufbgc_seed_random(uint64_t seed);
+uint64_t ufbgc_rand_u64();
+uint64_t ufbgc_rand_below(uint64_t bound);         //[0,bound)
+int ufbgc_randint(int min, int max);               //[min,max]
+double ufbgc_rand_double();                        //[0,1)
+void ufbgc_rand_bytes(void * dest, size_t size);
+
+/*
+    Property runs a test body over generated inputs, a failing input is shrunk to a minimal one and printed
+    Inputs are drawn with ufbgc_prop_* functions, output of the runs is hidden until the shrunk input is run again
+    Buffers and strings belong to the property and are valid until the body returns
+*/
+typedef struct internal_ufbgc_property ufbgc_property;
+typedef ufbgc_return_t(* ufbgc_property_fun_t)(ufbgc_property * prop, void * uarg);
+
+ufbgc_return_t ufbgc_check_property(const char * name, ufbgc_property_fun_t property, void * uarg, size_t runs);    //runs 0 uses --property-runs
+int64_t ufbgc_prop_int(ufbgc_property * prop, int64_t min, int64_t max);
+double ufbgc_prop_double(ufbgc_property * prop, double min, double max);
+const void * ufbgc_prop_bytes(ufbgc_property * prop, size_t min_size, size_t max_size, size_t * size);
+const char * ufbgc_prop_string(ufbgc_property * prop, size_t max_length, const char * alphabet);                  //NULL alphabet is printable ASCII
+
+#define ufbgc_assert_property(property,uarg,runs) \
+    ufbgc_assert_full(UFBGC_LOG_ERROR,"assert_property",ufbgc_check_property(#property,property,uarg,runs) == UFBGC_OK,false,true,"")
+
+
+//Stress test helpers, thread is in [0,threads) and round in [0,rounds)
+size_t ufbgc_stress_threads();          //0 outside of a stress thread
+size_t ufbgc_stress_thread();
+size_t ufbgc_stress_round();
+
+//Work of the current iteration, rates are printed next to its time and in the summary
+//A benchmark sets the work of one operation, a stress frame the work of one thread in one round
+void ufbgc_set_bytes_processed(uint64_t bytes);
+void ufbgc_set_items_processed(uint64_t items);
+
+//Benchmark helpers
+size_t ufbgc_get_bench_iterations();
+void ufbgc_escape(const void * p);
+
+//Compiler can't remove the computation of value or assume anything about the memory after these macros
+#if defined(__GNUC__) || defined(__clang__)
+    #define ufbgc_do_not_optimize(value) __asm__ volatile("" : : "r,m"(value) : "memory")
+    #define ufbgc_clobber_memory() __asm__ volatile("" : : : "memory")
+#else
+    #define ufbgc_do_not_optimize(value) ufbgc_escape(&(value))
+    #define ufbgc_clobber_memory() ufbgc_escape(NULL)
+#endif
 
 
 
-#define UFBGC_TEST(test_function_name, _opt,_log,_output_file,_param,sf,tf,tdf)                         \
+#define UFBGC_FIXTURE(fixture_name,sf,tdf)                                                              \
+    ufbgc_return_t fixture_name##_setup(void ** data)                                                   \
+        {sf return UFBGC_OK;}                                                                           \
+    void fixture_name##_teardown(void * data)                                                           \
+        {tdf}                                                                                           \
+    ufbgc_fixture fixture_name = {                                                                      \
+        .name = #fixture_name,                                                                          \
+        .setup_f = fixture_name##_setup,                                                                \
+        .teardown_f = fixture_name##_teardown,                                                          \
+        .internal = NULL};
+
+//Arguments after the functions are more fields of the frame, e.g. UFBGC_BUDGET(.wall_ms = 5, .checked = UFBGC_BUDGET_ALLOCS)
+#define UFBGC_TEST(test_function_name, _opt,_log,_output_file,_param,sf,tf,tdf,...)                     \
+    UFBGC_INTERNAL_REGISTER(test_function_name##_frame)                                                 \
     ufbgc_return_t test_function_name##_setup(ufbgc_test_parameters * parameters, void ** uarg)         \
         {sf return UFBGC_OK;}                                                                           \
     ufbgc_return_t test_function_name(ufbgc_test_parameters * parameters, void * uarg)                  \
@@ -223,11 +802,13 @@ int ufbgc_randint(int min, int max);
         .parameters = _param,                                                                           \
         .option = _opt,                                                                                 \
         .log_level = _log,                                                                              \
-        .output_file = _output_file};
+        .output_file = _output_file,                                                                    \
+        __VA_ARGS__};
 
 
 
-#define UFBGC_TEST_FRAME(test_function_name, _opt,_log,_output_file,_param)                             \
+#define UFBGC_TEST_FRAME(test_function_name, _opt,_log,_output_file,_param,...)                         \
+    UFBGC_INTERNAL_REGISTER(test_function_name##_frame)                                                 \
     ufbgc_return_t test_function_name(ufbgc_test_parameters * parameters, void * uarg);                 \
     ufbgc_return_t test_function_name##_setup(ufbgc_test_parameters * parameters, void ** uarg);        \
     ufbgc_return_t test_function_name##_teardown(ufbgc_test_parameters * parameters, void * uarg);      \
@@ -239,8 +820,63 @@ int ufbgc_randint(int min, int max);
         .parameters = _param,                                                                           \
         .option = _opt,                                                                                 \
         .log_level = _log,                                                                              \
-        .output_file = _output_file}
-
+        .output_file = _output_file,                                                                    \
+        __VA_ARGS__}
+
+
+/*
+    UFBGC_BENCH creates a benchmark frame, body of the benchmark is a single operation
+    Runner warms it up, scales the number of operations until a sample takes long enough and reports per operation statistics
+    Assert macros can be used inside the body, failed assertion stops the benchmark
+*/
+#define UFBGC_BENCH(bench_function_name,_log,_output_file,_param,sf,bf,tdf,...)                         \
+    UFBGC_INTERNAL_REGISTER(bench_function_name##_frame)                                                \
+    ufbgc_return_t bench_function_name##_setup(ufbgc_test_parameters * parameters, void ** uarg)        \
+        {sf return UFBGC_OK;}                                                                           \
+    ufbgc_return_t bench_function_name(ufbgc_test_parameters * parameters, void * uarg){                \
+        const size_t ufbgc_bench_n = ufbgc_get_bench_iterations();                                      \
+        for(size_t ufbgc_bench_i = 0; ufbgc_bench_i < ufbgc_bench_n; ++ufbgc_bench_i){bf}               \
+        return UFBGC_OK;                                                                                \
+    }                                                                                                   \
+    ufbgc_return_t bench_function_name##_teardown(ufbgc_test_parameters * parameters, void * uarg)      \
+        {tdf return UFBGC_OK;}                                                                          \
+        const ufbgc_test_frame bench_function_name##_frame = {                                          \
+        .test_f = bench_function_name,                                                                  \
+        .name = #bench_function_name,                                                                   \
+        .setup_f = bench_function_name##_setup,                                                         \
+        .teardown_f = bench_function_name##_teardown,                                                   \
+        .parameters = _param,                                                                           \
+        .option = BENCHMARK_TEST,                                                                       \
+        .log_level = _log,                                                                              \
+        .output_file = _output_file,                                                                    \
+        __VA_ARGS__};
+
+
+/*
+    UFBGC_STRESS creates a stress frame, body runs on every thread in every round, rounds start on all threads together
+    Setup runs before the first round and teardown after the last one, uarg is shared by the threads
+    Assertions are thread safe, a failure reports its thread and round and stops the rounds after the current one
+*/
+#define UFBGC_STRESS(stress_function_name,_threads,_rounds,_log,_output_file,_param,sf,bf,tdf,...)       \
+    UFBGC_INTERNAL_REGISTER(stress_function_name##_frame)                                               \
+    ufbgc_return_t stress_function_name##_setup(ufbgc_test_parameters * parameters, void ** uarg)       \
+        {sf return UFBGC_OK;}                                                                           \
+    ufbgc_return_t stress_function_name(ufbgc_test_parameters * parameters, void * uarg)                \
+        {bf return UFBGC_OK;}                                                                           \
+    ufbgc_return_t stress_function_name##_teardown(ufbgc_test_parameters * parameters, void * uarg)     \
+        {tdf return UFBGC_OK;}                                                                          \
+        const ufbgc_test_frame stress_function_name##_frame = {                                         \
+        .test_f = stress_function_name,                                                                 \
+        .name = #stress_function_name,                                                                  \
+        .setup_f = stress_function_name##_setup,                                                        \
+        .teardown_f = stress_function_name##_teardown,                                                  \
+        .parameters = _param,                                                                           \
+        .option = STRESS_TEST,                                                                          \
+        .log_level = _log,                                                                              \
+        .output_file = _output_file,                                                                    \
+        .threads = _threads,                                                                            \
+        .rounds = _rounds,                                                                              \
+        __VA_ARGS__};
 
 #define ufbgc_test_frame_array_length(test_list) (sizeof(test_list)/(sizeof(ufbgc_test_frame)))
 
@@ -0,0 +1,61 @@
+/*
+    Allocation budget is only met when the allocations are counted, without the tracker the frame is [OVER BUDGET]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ufbgc.h"
+
+static int tracking = -1;
+
+ufbgc_return_t alloc_test(ufbgc_test_parameters * parameters, void * uarg){
+    tracking = ufbgc_alloc_tracking();
+    void * p = malloc(32);
+    ufbgc_escape(p);
+    free(p);
+    return UFBGC_OK;
+}
+
+ufbgc_test_frame test_list[] = {
+    {.test_f = alloc_test, .name = "alloc", UFBGC_BUDGET(.allocs = 1)},
+};
+
+int main(int argc, char const *argv[]){
+    FILE * capture = tmpfile();
+    int saved_stdout = dup(STDOUT_FILENO);
+    if(capture == NULL || saved_stdout < 0){
+        return 1;
+    }
+    fflush(stdout);
+    dup2(fileno(capture),STDOUT_FILENO);
+    ufbgc_return_t result = ufbgc_start_test(test_list,ufbgc_test_frame_array_length(test_list));
+    fflush(stdout);
+    dup2(saved_stdout,STDOUT_FILENO);
+
+    long size = ftell(capture);
+    char * output = (char *) calloc((size_t) size + 1,1);
+    rewind(capture);
+    if(size < 0 || output == NULL || fread(output,1,(size_t) size,capture) != (size_t) size){
+        return 1;
+    }
+    fputs(output,stdout);
+
+    bool ok = true;
+    if(tracking < 0){
+        fprintf(stderr,"budget_test - frame did not run\n");
+        ok = false;
+    }
+    else if(tracking){
+        if(result != UFBGC_OK){
+            fprintf(stderr,"budget_test - single allocation must meet the budget with the tracker\n");
+            ok = false;
+        }
+    }
+    else if(result != UFBGC_FAIL || strstr(output,"[OVER BUDGET]") == NULL || strstr(output,"allocs budget cannot be verified") == NULL){
+        fprintf(stderr,"budget_test - allocation budget must not be met without the tracker\n");
+        ok = false;
+    }
+    free(output);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+/*
+    Frames run with --timeout: a shared fixture is built once for the run, output of every frame stays in order
+    and a hung frame is reported as [TIMEOUT] while the frames after it still run
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ufbgc.h"
+
+static int fixture_builds = 0;
+static int fixture_teardowns = 0;
+
+static ufbgc_return_t shared_setup(void ** data){
+    fixture_builds++;
+    *data = &fixture_builds;
+    return UFBGC_OK;
+}
+
+static void shared_teardown(void * data){
+    fixture_teardowns++;
+}
+
+static ufbgc_fixture shared = {
+    .name = "shared",
+    .setup_f = shared_setup,
+    .teardown_f = shared_teardown,
+};
+
+#define PRINT_TEST(_name)                                                                   \
+    ufbgc_return_t _name##_test(ufbgc_test_parameters * parameters, void * uarg){          \
+        ufbgc_assert(ufbgc_get_fixture(&shared) != NULL);                                   \
+        printf("body of " #_name "\n");                                                    \
+        return UFBGC_OK;                                                                    \
+    }
+
+PRINT_TEST(first)
+PRINT_TEST(second)
+PRINT_TEST(third)
+
+ufbgc_return_t hung_test(ufbgc_test_parameters * parameters, void * uarg){
+    ufbgc_get_fixture(&shared);
+    for(;;){
+        pause();
+    }
+    return UFBGC_OK;
+}
+
+ufbgc_test_frame test_list[] = {
+    {.test_f = first_test, .name = "first", .fixtures = UFBGC_FIXTURES(&shared)},
+    {.test_f = hung_test, .name = "hung", .fixtures = UFBGC_FIXTURES(&shared), UFBGC_BUDGET(.deadline_ms = 200)},
+    {.test_f = second_test, .name = "second", .fixtures = UFBGC_FIXTURES(&shared)},
+    {.test_f = third_test, .name = "third", .fixtures = UFBGC_FIXTURES(&shared)},
+};
+
+//Lines of the frame must be in this order: header, body, result
+static bool check_order(const char * output, const char * name, bool has_body){
+    char header[64], body[64], result[64];
+    snprintf(header,sizeof(header),"Starting test : '%s'",name);
+    snprintf(body,sizeof(body),"body of %s\n",name);
+    snprintf(result,sizeof(result),"'%s'\t\t\t",name);
+    const char * h = strstr(output,header);
+    const char * b = has_body ? strstr(output,body) : h;
+    const char * r = h != NULL ? strstr(h,result) : NULL;
+    if(h == NULL || b == NULL || r == NULL || b < h || r < b){
+        fprintf(stderr,"deadline_test - output of '%s' is missing or out of order\n",name);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char const *argv[]){
+    char const * args[] = {argv[0],"--timeout=5000"};
+    if(ufbgc_parse_args(2,args) != UFBGC_OK){
+        return 1;
+    }
+
+    //Output of the run, workers included, goes into a file which is checked after the run
+    FILE * capture = tmpfile();
+    int saved_stdout = dup(STDOUT_FILENO);
+    if(capture == NULL || saved_stdout < 0){
+        return 1;
+    }
+    fflush(stdout);
+    dup2(fileno(capture),STDOUT_FILENO);
+    ufbgc_return_t result = ufbgc_start_test(test_list,ufbgc_test_frame_array_length(test_list));
+    fflush(stdout);
+    dup2(saved_stdout,STDOUT_FILENO);
+
+    long size = ftell(capture);
+    char * output = (char *) calloc((size_t) size + 1,1);
+    rewind(capture);
+    if(size < 0 || output == NULL || fread(output,1,(size_t) size,capture) != (size_t) size){
+        return 1;
+    }
+    fputs(output,stdout);
+
+    bool ok = true;
+    if(result != UFBGC_FAIL){
+        fprintf(stderr,"deadline_test - run with a hung frame must fail\n");
+        ok = false;
+    }
+    if(fixture_builds != 1 || fixture_teardowns != 1){
+        fprintf(stderr,"deadline_test - fixture built %d and torn down %d times, expected once\n",fixture_builds,fixture_teardowns);
+        ok = false;
+    }
+    ok = check_order(output,"first",true) && ok;
+    ok = check_order(output,"hung",false) && ok;
+    ok = check_order(output,"second",true) && ok;
+    ok = check_order(output,"third",true) && ok;
+    if(strstr(output,"[TIMEOUT]") == NULL || strstr(output,"tests summary") == NULL){
+        fprintf(stderr,"deadline_test - [TIMEOUT] or the summary is missing\n");
+        ok = false;
+    }
+    free(output);
+    return ok ? 0 : 1;
+}